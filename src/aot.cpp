@@ -0,0 +1,132 @@
+#include "aot.hpp"
+
+namespace aot {
+namespace {
+
+/**
+ * Function - a compiled pseudocode function, as a value
+ */
+class Function : public Callable {
+    std::string name;
+    int parameters;
+    RuntimeValue (*body)(std::vector<RuntimeValue> &);
+
+public:
+    Function(std::string name, int parameters, RuntimeValue (*body)(std::vector<RuntimeValue> &))
+        : name(std::move(name)), parameters(parameters), body(body) {
+    }
+
+    int arity() override {
+        return parameters;
+    }
+
+    RuntimeValue call(Interpreter &, std::vector<RuntimeValue> arguments) override {
+        return body(arguments);
+    }
+
+    std::string toString() override {
+        return "<fn " + name + ">";
+    }
+};
+
+} // namespace
+
+const RuntimeValue &undefined(const Token &name) {
+    throw RuntimeError(name, "Undefined variable '" + name.lexeme + "'.");
+}
+
+// The natives' own checks, raised at the call like finishCall does
+
+double sqrt(const Token &paren, double x) {
+    if (x < 0)
+        throw RuntimeError(paren, "SQRT of a negative number.");
+    return std::sqrt(x);
+}
+
+double mod(const Token &paren, double x, double divisor) {
+    if (divisor == 0)
+        throw RuntimeError(paren, "MOD by zero.");
+    return std::fmod(x, divisor);
+}
+
+double log(const Token &paren, double x) {
+    if (x <= 0)
+        throw RuntimeError(paren, "LOG of a non-positive number.");
+    return std::log(x);
+}
+
+// --- Runtime ---
+
+RuntimeValue Runtime::global(const std::string &name) {
+    return interpreter.globals->get(Token{TOK_IDENTIFIER, name, 0, 0, (int) name.size()});
+}
+
+RuntimeValue Runtime::function(const std::string &name, int arity,
+                               RuntimeValue (*call)(std::vector<RuntimeValue> &)) {
+    return {std::shared_ptr<Callable>(std::make_shared<Function>(name, arity, call))};
+}
+
+RuntimeValue Runtime::call(const Token &paren, Call call) {
+    if (!call.target.is<std::shared_ptr<Callable>>()) {
+        throw RuntimeError(paren, "Can only call functions and classes.");
+    }
+    auto function = call.target.as<std::shared_ptr<Callable>>();
+    interpreter.checkArgumentCount(paren, *function, call.args.size());
+    try {
+        return function->call(interpreter, std::move(call.args));
+    } catch (const NativeError &error) {
+        throw RuntimeError(paren, error.what());
+    }
+}
+
+RuntimeValue Runtime::invoke(const Token &name, const Token &paren, Call call) {
+    if (Interpreter::hasNativeMethods(call.target)) {
+        return interpreter.callNativeMethod(call.target, name, call.args);
+    }
+    call.target = interpreter.getProperty(call.target, name);
+    return this->call(paren, std::move(call));
+}
+
+RuntimeValue Runtime::list(std::vector<RuntimeValue> elements) {
+    auto array = std::make_shared<Array>();
+    array->reserve(elements.size());
+    for (auto &element : elements) {
+        array->push(std::move(element));
+    }
+    return {array};
+}
+
+RuntimeValue Runtime::slice(const Token &bracket, const Args<3> &operands, bool start,
+                            bool end) {
+    return interpreter.sliceArray(bracket, operands[0], start ? &operands[1] : nullptr,
+                                  end ? &operands[2] : nullptr);
+}
+
+RuntimeValue Runtime::setIndex(const Token &bracket, Args<3> operands) {
+    interpreter.setIndex(bracket, operands[1], operands[2], operands[0]);
+    return std::move(operands[0]);
+}
+
+RuntimeValue Runtime::setProperty(const Token &name, Args<2> operands) {
+    interpreter.setProperty(operands[1], name, operands[0]);
+    return std::move(operands[0]);
+}
+
+int Runtime::run(void (*program)()) {
+    try {
+        program();
+    } catch (const RuntimeError &error) {
+        *interpreter.errorOutput << "[Runtime Error] " << error.what() << "\n[Line "
+                                 << error.token.line << "]" << std::endl;
+        return 1;
+    } catch (const NativeError &error) {
+        *interpreter.errorOutput << "[Runtime Error] " << error.what() << std::endl;
+        return 1;
+    } catch (const std::exception &error) {
+        std::cerr << error.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace aot
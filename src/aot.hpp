@@ -0,0 +1,185 @@
+#pragma once
+
+#include "interpreter.hpp"
+
+#include <array>
+#include <cmath>
+#include <string>
+#include <vector>
+
+/**
+ * Runtime support for programs compiled with `scsa --emit-cpp` (see transpiler.hpp)
+ *
+ * Generated sources include this header and link against libscsa.a. Their values are the
+ * interpreter's RuntimeValues, and everything beyond arithmetic on numbers - natives, collection
+ * methods, indexing, printing and error messages - goes through one Interpreter, so a compiled
+ * program prints exactly what the interpreted one does.
+ */
+namespace aot {
+
+// Values evaluated left to right by a braced list, handed to a runtime operation in one piece
+template <size_t N> using Args = std::array<RuntimeValue, N>;
+
+// A callee (or method receiver) and its arguments, evaluated in that order
+struct Call {
+    RuntimeValue target;
+    std::vector<RuntimeValue> args;
+};
+
+/**
+ * Var - one pseudocode variable
+ * Whether a name exists decides which scope an assignment goes to, so a variable is not
+ * defined until it is first assigned.
+ */
+struct Var {
+    RuntimeValue value;
+    bool defined = false;
+};
+
+// The innermost defined variable of a scope chain, or null
+inline Var *innermost() {
+    return nullptr;
+}
+template <typename... Outer> Var *innermost(Var &first, Outer &...outer) {
+    return first.defined ? &first : innermost(outer...);
+}
+
+/**
+ * Read a name that several scopes may define, innermost scope first
+ */
+template <typename... Outer>
+const RuntimeValue &read(const Token &name, Var &inner, Outer &...outer) {
+    if (Var *var = innermost(inner, outer...))
+        return var->value;
+    throw RuntimeError(name, "Undefined variable '" + name.lexeme + "'.");
+}
+
+/**
+ * Read a name no scope of the program defines
+ */
+[[noreturn]] const RuntimeValue &undefined(const Token &name);
+
+/**
+ * Assign to the innermost scope that defines the name, or define it in the innermost one
+ */
+template <typename... Outer>
+const RuntimeValue &assign(RuntimeValue value, Var &inner, Outer &...outer) {
+    Var *var = innermost(inner, outer...);
+    if (!var)
+        var = &inner;
+    var->value   = std::move(value);
+    var->defined = true;
+    return var->value;
+}
+
+/**
+ * Check that a function called directly has been declared by now
+ */
+inline void require(const Token &name, const Var &function) {
+    if (!function.defined)
+        undefined(name);
+}
+
+// --- Operators ---
+
+/**
+ * A binary operator, with numbers handled inline and everything else by the interpreter
+ */
+template <TokenType OP>
+RuntimeValue binary(Interpreter &interpreter, const Token &op, const Args<2> &operands) {
+    const RuntimeValue &left  = operands[0];
+    const RuntimeValue &right = operands[1];
+    if (left.is<double>() && right.is<double>()) {
+        double a = left.as<double>(), b = right.as<double>();
+        switch (OP) {
+        case TOK_PLUS:
+            return {a + b};
+        case TOK_MINUS:
+            return {a - b};
+        case TOK_MULTIPLY:
+            return {a * b};
+        case TOK_DIVIDE:
+            if (b != 0)
+                return {a / b};
+            break;
+        case TOK_LESS_THAN:
+            return {a < b};
+        case TOK_LT_OR_EQ:
+            return {a <= b};
+        case TOK_GREATER_THAN:
+            return {a > b};
+        case TOK_GT_OR_EQ:
+            return {a >= b};
+        case TOK_EQUAL:
+            return {a == b};
+        default:
+            break;
+        }
+    }
+    return interpreter.binaryOp(op, left, right);
+}
+
+/**
+ * Division in numeric code, which reports division by zero like the interpreter
+ */
+inline double divide(const Token &op, double a, double b) {
+    if (b == 0)
+        throw RuntimeError(op, "Division by zero.");
+    return a / b;
+}
+
+// Math natives called from numeric code, with the interpreter's argument checks
+double sqrt(const Token &paren, double x);
+double mod(const Token &paren, double x, double divisor);
+double log(const Token &paren, double x);
+
+// --- Runtime ---
+
+/**
+ * Runtime - the interpreter a compiled program borrows operations from
+ */
+class Runtime {
+public:
+    Interpreter interpreter;
+
+    /**
+     * A global the standard library defines (a native function)
+     */
+    RuntimeValue global(const std::string &name);
+
+    /**
+     * Wrap a compiled function as a value, for passing it around and calling it indirectly
+     */
+    RuntimeValue function(const std::string &name, int arity,
+                          RuntimeValue (*call)(std::vector<RuntimeValue> &));
+
+    // Calls through a value, and methods of lists, sets and dictionaries
+    RuntimeValue call(const Token &paren, Call call);
+    RuntimeValue invoke(const Token &name, const Token &paren, Call call);
+
+    RuntimeValue list(std::vector<RuntimeValue> elements);
+    RuntimeValue index(const Token &bracket, const Args<2> &operands) {
+        return interpreter.getIndex(bracket, operands[0], operands[1]);
+    }
+    // {array, start, end}; a bound that was left out is passed as nil and flagged absent
+    RuntimeValue slice(const Token &bracket, const Args<3> &operands, bool start, bool end);
+    // Index assignment evaluates the value first: {value, array, index}
+    RuntimeValue setIndex(const Token &bracket, Args<3> operands);
+    // Property assignment evaluates the value first: {value, object}
+    RuntimeValue setProperty(const Token &name, Args<2> operands);
+
+    bool truthy(const RuntimeValue &value) {
+        return interpreter.isTruthy(value);
+    }
+    void print(const RuntimeValue &value) {
+        interpreter.printValue(value);
+    }
+
+    /**
+     * Run the program's top level, reporting an error as the interpreter does
+     * @return The process exit status: 0, or 1 if the program stopped on an error
+     */
+    int run(void (*program)());
+};
+
+} // namespace aot
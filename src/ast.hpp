@@ -17,6 +17,7 @@ struct CallExpr;
 struct GetExpr;
 struct ArrayAccessExpr;
 struct ArrayLitExpr;
+struct SliceExpr;
 struct NewExpr;
 
 // Statements
@@ -46,6 +47,7 @@ struct ExprVisitor {
     virtual void visitGetExpr(GetExpr *expr)                 = 0;
     virtual void visitArrayAccessExpr(ArrayAccessExpr *expr) = 0;
     virtual void visitArrayLitExpr(ArrayLitExpr *expr)       = 0;
+    virtual void visitSliceExpr(SliceExpr *expr)             = 0;
     virtual void visitNewExpr(NewExpr *expr)                 = 0;
 };
 
@@ -163,7 +165,9 @@ struct BinaryExpr : Expr {
 struct CallExpr : Expr {
     ExprPtr callee;
     std::vector<ExprPtr> args;
-    CallExpr(ExprPtr c, std::vector<ExprPtr> a) : callee(std::move(c)), args(std::move(a)) {
+    Token paren; // The '(' token, kept for error reporting
+    CallExpr(ExprPtr c, std::vector<ExprPtr> a, Token p)
+        : callee(std::move(c)), args(std::move(a)), paren(p) {
     }
     void accept(ExprVisitor &visitor) override {
         visitor.visitCallExpr(this);
@@ -191,7 +195,9 @@ struct GetExpr : Expr {
 struct ArrayAccessExpr : Expr {
     ExprPtr array;
     ExprPtr index;
-    ArrayAccessExpr(ExprPtr a, ExprPtr i) : array(std::move(a)), index(std::move(i)) {
+    Token bracket; // The '[' token, kept for error reporting
+    ArrayAccessExpr(ExprPtr a, ExprPtr i, Token b)
+        : array(std::move(a)), index(std::move(i)), bracket(b) {
     }
     void accept(ExprVisitor &visitor) override {
         visitor.visitArrayAccessExpr(this);
@@ -211,6 +217,24 @@ struct ArrayLitExpr : Expr {
     }
 };
 
+/**
+ * Slice Expression
+ * Represents copying a sub-range of an array (e.g., arr[1:3], arr[:2], arr[2:]).
+ * Either bound may be omitted, in which case it defaults to the start or end of the array.
+ */
+struct SliceExpr : Expr {
+    ExprPtr array;
+    ExprPtr start; // May be null
+    ExprPtr end;   // May be null
+    Token bracket; // The '[' token, kept for error reporting
+    SliceExpr(ExprPtr a, ExprPtr s, ExprPtr e, Token b)
+        : array(std::move(a)), start(std::move(s)), end(std::move(e)), bracket(b) {
+    }
+    void accept(ExprVisitor &visitor) override {
+        visitor.visitSliceExpr(this);
+    }
+};
+
 /**
  * New Instance Expression
  * Represents the instantiation of a class.
@@ -300,9 +324,11 @@ struct IfStmt : Stmt {
  * Repeats a body of code while a condition remains true.
  */
 struct WhileStmt : Stmt {
+    Token keyword; // The 'WHILE', for errors raised by the loop itself
     ExprPtr condition;
     std::vector<StmtPtr> body;
-    WhileStmt(ExprPtr c, std::vector<StmtPtr> b) : condition(std::move(c)), body(std::move(b)) {
+    WhileStmt(Token k, ExprPtr c, std::vector<StmtPtr> b)
+        : keyword(k), condition(std::move(c)), body(std::move(b)) {
     }
     void accept(StmtVisitor &visitor) override {
         visitor.visitWhileStmt(this);
@@ -344,14 +370,16 @@ struct ClassStmt : Stmt {
 /**
  * For-In Statement
  * Represents a range/collection loop: for (item in collection) { body }
+ * PARALLEL FOR loops run their iterations concurrently, sharing outer state read-only.
  */
 struct ForInStmt : Stmt {
     Token variable;
     ExprPtr iterable;
     std::vector<StmtPtr> body;
+    bool parallel;
 
-    ForInStmt(Token var, ExprPtr iter, std::vector<StmtPtr> b)
-        : variable(var), iterable(std::move(iter)), body(std::move(b)) {
+    ForInStmt(Token var, ExprPtr iter, std::vector<StmtPtr> b, bool p = false)
+        : variable(var), iterable(std::move(iter)), body(std::move(b)), parallel(p) {
     }
 
     void accept(StmtVisitor &visitor) override {
@@ -0,0 +1,604 @@
+#include "ast_cache.hpp"
+#include "parser.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <sstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// --- File Format ---
+//
+// Header, then the string table, then the statements in pre-order. Each node is a tag byte
+// followed by its fields; tokens are stored as their type, an index into the string table for
+// the lexeme, and their position. Numbers are in the writing machine's byte order, which the
+// header records, so a cache copied to a different machine is simply rebuilt.
+
+static constexpr uint32_t CACHE_MAGIC       = 0x43415343; // "SCAC"
+static constexpr uint32_t CACHE_VERSION     = 3;          // Bump whenever the AST or grammar changes
+static constexpr uint32_t CACHE_BYTE_ORDER  = 0x01020304;
+static constexpr uint32_t CACHE_TOKEN_TYPES = TOK_RBRACKET + 1;
+
+enum NodeTag : uint8_t {
+    TAG_NULL,
+    // Expressions
+    TAG_LITERAL,
+    TAG_VARIABLE,
+    TAG_ASSIGN,
+    TAG_BINARY,
+    TAG_CALL,
+    TAG_GET,
+    TAG_ARRAY_ACCESS,
+    TAG_ARRAY_LIT,
+    TAG_SLICE,
+    TAG_NEW,
+    // Statements
+    TAG_EXPRESSION,
+    TAG_PRINT,
+    TAG_RETURN,
+    TAG_BLOCK,
+    TAG_IF,
+    TAG_WHILE,
+    TAG_FUNCTION,
+    TAG_CLASS,
+    TAG_FOR_IN,
+};
+
+struct CacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t tokenTypes;
+    uint64_t sourceHash;
+    uint64_t sourceSize;
+    uint32_t stringCount;
+    uint32_t reserved; // Keeps the header a multiple of 8 bytes
+};
+
+// --- Writer ---
+
+/**
+ * AstWriter - encodes statements into the cache's binary form
+ */
+class AstWriter : public ExprVisitor, public StmtVisitor {
+public:
+    std::vector<uint8_t> body;
+    std::vector<const std::string *> strings;
+
+    void write(Stmt *stmt) {
+        if (stmt)
+            stmt->accept(*this);
+        else
+            put<uint8_t>(TAG_NULL);
+    }
+
+    void write(Expr *expr) {
+        if (expr)
+            expr->accept(*this);
+        else
+            put<uint8_t>(TAG_NULL);
+    }
+
+    void write(const std::vector<StmtPtr> &statements) {
+        put<uint32_t>((uint32_t) statements.size());
+        for (const auto &stmt : statements)
+            write(stmt.get());
+    }
+
+    void write(const std::vector<ExprPtr> &expressions) {
+        put<uint32_t>((uint32_t) expressions.size());
+        for (const auto &expr : expressions)
+            write(expr.get());
+    }
+
+    void write(const Token &token) {
+        put<uint8_t>((uint8_t) token.type);
+        put<uint32_t>(intern(token.lexeme));
+        put<int32_t>(token.line);
+        put<int32_t>(token.column);
+        put<int32_t>(token.length);
+    }
+
+    // --- ExprVisitor Implementation ---
+    void visitLiteralExpr(LiteralExpr *expr) override {
+        put<uint8_t>(TAG_LITERAL);
+        write(expr->token);
+    }
+    void visitVariableExpr(VariableExpr *expr) override {
+        put<uint8_t>(TAG_VARIABLE);
+        write(expr->name);
+    }
+    void visitAssignExpr(AssignExpr *expr) override {
+        put<uint8_t>(TAG_ASSIGN);
+        write(expr->target.get());
+        write(expr->value.get());
+    }
+    void visitBinaryExpr(BinaryExpr *expr) override {
+        put<uint8_t>(TAG_BINARY);
+        write(expr->left.get());
+        write(expr->op);
+        write(expr->right.get());
+    }
+    void visitCallExpr(CallExpr *expr) override {
+        put<uint8_t>(TAG_CALL);
+        write(expr->callee.get());
+        write(expr->args);
+        write(expr->paren);
+    }
+    void visitGetExpr(GetExpr *expr) override {
+        put<uint8_t>(TAG_GET);
+        write(expr->object.get());
+        write(expr->name);
+    }
+    void visitArrayAccessExpr(ArrayAccessExpr *expr) override {
+        put<uint8_t>(TAG_ARRAY_ACCESS);
+        write(expr->array.get());
+        write(expr->index.get());
+        write(expr->bracket);
+    }
+    void visitArrayLitExpr(ArrayLitExpr *expr) override {
+        put<uint8_t>(TAG_ARRAY_LIT);
+        write(expr->elements);
+    }
+    void visitSliceExpr(SliceExpr *expr) override {
+        put<uint8_t>(TAG_SLICE);
+        write(expr->array.get());
+        write(expr->start.get());
+        write(expr->end.get());
+        write(expr->bracket);
+    }
+    void visitNewExpr(NewExpr *expr) override {
+        put<uint8_t>(TAG_NEW);
+        write(expr->className);
+        write(expr->args);
+    }
+
+    // --- StmtVisitor Implementation ---
+    void visitExpressionStmt(ExpressionStmt *stmt) override {
+        put<uint8_t>(TAG_EXPRESSION);
+        write(stmt->expression.get());
+    }
+    void visitPrintStmt(PrintStmt *stmt) override {
+        put<uint8_t>(TAG_PRINT);
+        write(stmt->expression.get());
+    }
+    void visitReturnStmt(ReturnStmt *stmt) override {
+        put<uint8_t>(TAG_RETURN);
+        write(stmt->value.get());
+    }
+    void visitBlockStmt(BlockStmt *stmt) override {
+        put<uint8_t>(TAG_BLOCK);
+        write(stmt->statements);
+    }
+    void visitIfStmt(IfStmt *stmt) override {
+        put<uint8_t>(TAG_IF);
+        write(stmt->condition.get());
+        write(stmt->thenBranch);
+        write(stmt->elseBranch);
+    }
+    void visitWhileStmt(WhileStmt *stmt) override {
+        put<uint8_t>(TAG_WHILE);
+        write(stmt->keyword);
+        write(stmt->condition.get());
+        write(stmt->body);
+    }
+    void visitFunctionStmt(FunctionStmt *stmt) override {
+        put<uint8_t>(TAG_FUNCTION);
+        write(stmt->name);
+        put<uint32_t>((uint32_t) stmt->params.size());
+        for (const Token &param : stmt->params)
+            write(param);
+        write(stmt->body);
+    }
+    void visitClassStmt(ClassStmt *stmt) override {
+        put<uint8_t>(TAG_CLASS);
+        write(stmt->name);
+        write(stmt->superclass);
+        write(stmt->methods);
+    }
+    void visitForInStmt(ForInStmt *stmt) override {
+        put<uint8_t>(TAG_FOR_IN);
+        write(stmt->variable);
+        write(stmt->iterable.get());
+        write(stmt->body);
+        put<uint8_t>(stmt->parallel ? 1 : 0);
+    }
+
+private:
+    std::unordered_map<std::string, uint32_t> stringIndex;
+
+    template <typename T> void put(T value) {
+        size_t at = body.size();
+        body.resize(at + sizeof(T));
+        std::memcpy(body.data() + at, &value, sizeof(T));
+    }
+
+    // Each distinct lexeme is stored once; identifiers repeat a lot
+    uint32_t intern(const std::string &text) {
+        auto found = stringIndex.find(text);
+        if (found != stringIndex.end())
+            return found->second;
+        uint32_t index = (uint32_t) strings.size();
+        auto added     = stringIndex.emplace(text, index).first;
+        strings.push_back(&added->first);
+        return index;
+    }
+};
+
+// --- Reader ---
+
+/**
+ * AstReader - rebuilds statements from the cache's binary form
+ * Every read is bounds checked, and so is every count before anything is allocated for it;
+ * damaged data throws std::runtime_error.
+ */
+class AstReader {
+public:
+    AstReader(const uint8_t *data, size_t size) : pos(data), end(data + size) {
+    }
+
+    template <typename T> T get() {
+        if ((size_t) (end - pos) < sizeof(T))
+            throw std::runtime_error("Truncated AST cache.");
+        T value;
+        std::memcpy(&value, pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+
+    /**
+     * Check that 'count' items of at least 'minBytes' each could still be in the file
+     */
+    void checkCount(uint32_t count, size_t minBytes) const {
+        if ((size_t) (end - pos) / minBytes < count)
+            throw std::runtime_error("Bad count in AST cache.");
+    }
+
+    void readStrings(uint32_t count) {
+        checkCount(count, sizeof(uint32_t));
+        strings.reserve(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            uint32_t length = get<uint32_t>();
+            if ((size_t) (end - pos) < length)
+                throw std::runtime_error("Truncated AST cache.");
+            strings.emplace_back(reinterpret_cast<const char *>(pos), length);
+            pos += length;
+        }
+    }
+
+    std::vector<StmtPtr> readStatements() {
+        std::vector<StmtPtr> statements(readCount(1));
+        for (auto &stmt : statements)
+            stmt = readStmt();
+        return statements;
+    }
+
+    bool atEnd() const {
+        return pos == end;
+    }
+
+private:
+    const uint8_t *pos;
+    const uint8_t *end;
+    std::vector<std::string> strings;
+
+    // Nodes open around the one being read. The parser never nests anything this deep (class
+    // and function bodies add a few levels its limit does not count), so deeper data is damaged
+    // and would otherwise only exhaust the stack.
+    int depth                      = 0;
+    static constexpr int MAX_DEPTH = 2 * Parser::MAX_NESTING;
+
+    // A token is written as its type, string index, line, column and length
+    static constexpr size_t TOKEN_BYTES = sizeof(uint8_t) + sizeof(uint32_t) + 3 * sizeof(int32_t);
+
+    // A count of items taking at least 'minBytes' each; one for a statement or expression tag
+    size_t readCount(size_t minBytes) {
+        uint32_t count = get<uint32_t>();
+        checkCount(count, minBytes);
+        return count;
+    }
+
+    Token readToken() {
+        Token token{};
+        uint8_t type = get<uint8_t>();
+        if (type >= CACHE_TOKEN_TYPES)
+            throw std::runtime_error("Bad token in AST cache.");
+        token.type     = (TokenType) type;
+        uint32_t index = get<uint32_t>();
+        if (index >= strings.size())
+            throw std::runtime_error("Bad string in AST cache.");
+        token.lexeme = strings[index];
+        token.line   = get<int32_t>();
+        token.column = get<int32_t>();
+        token.length = get<int32_t>();
+        return token;
+    }
+
+    std::vector<ExprPtr> readExpressions() {
+        std::vector<ExprPtr> expressions(readCount(1));
+        for (auto &expr : expressions)
+            expr = readExpr();
+        return expressions;
+    }
+
+    void enter() {
+        if (++depth > MAX_DEPTH)
+            throw std::runtime_error("AST cache nested too deeply.");
+    }
+
+    ExprPtr readExpr() {
+        enter();
+        ExprPtr expr = readExprNode();
+        --depth;
+        return expr;
+    }
+
+    // A child the parser may leave out: a RETURN value or a slice bound
+    ExprPtr readOptionalExpr() {
+        if (pos < end && *pos == TAG_NULL) {
+            ++pos;
+            return nullptr;
+        }
+        return readExpr();
+    }
+
+    StmtPtr readStmt() {
+        enter();
+        StmtPtr stmt = readStmtNode();
+        --depth;
+        return stmt;
+    }
+
+    // Null is only valid where readOptionalExpr() allows it, so TAG_NULL is an error here
+    ExprPtr readExprNode() {
+        switch (get<uint8_t>()) {
+        case TAG_LITERAL:
+            return std::make_unique<LiteralExpr>(readToken());
+        case TAG_VARIABLE:
+            return std::make_unique<VariableExpr>(readToken());
+        case TAG_ASSIGN: {
+            ExprPtr target = readExpr();
+            ExprPtr value  = readExpr();
+            return std::make_unique<AssignExpr>(std::move(target), std::move(value));
+        }
+        case TAG_BINARY: {
+            ExprPtr left  = readExpr();
+            Token op      = readToken();
+            ExprPtr right = readExpr();
+            return std::make_unique<BinaryExpr>(std::move(left), op, std::move(right));
+        }
+        case TAG_CALL: {
+            ExprPtr callee            = readExpr();
+            std::vector<ExprPtr> args = readExpressions();
+            Token paren               = readToken();
+            return std::make_unique<CallExpr>(std::move(callee), std::move(args), paren);
+        }
+        case TAG_GET: {
+            ExprPtr object = readExpr();
+            return std::make_unique<GetExpr>(std::move(object), readToken());
+        }
+        case TAG_ARRAY_ACCESS: {
+            ExprPtr array = readExpr();
+            ExprPtr index = readExpr();
+            Token bracket = readToken();
+            return std::make_unique<ArrayAccessExpr>(std::move(array), std::move(index),
+                                                     bracket);
+        }
+        case TAG_ARRAY_LIT:
+            return std::make_unique<ArrayLitExpr>(readExpressions());
+        case TAG_SLICE: {
+            ExprPtr array = readExpr();
+            ExprPtr start = readOptionalExpr();
+            ExprPtr stop  = readOptionalExpr();
+            Token bracket = readToken();
+            return std::make_unique<SliceExpr>(std::move(array), std::move(start),
+                                               std::move(stop), bracket);
+        }
+        case TAG_NEW: {
+            Token className = readToken();
+            return std::make_unique<NewExpr>(className, readExpressions());
+        }
+        default:
+            throw std::runtime_error("Bad expression in AST cache.");
+        }
+    }
+
+    StmtPtr readStmtNode() {
+        switch (get<uint8_t>()) {
+        case TAG_EXPRESSION:
+            return std::make_unique<ExpressionStmt>(readExpr());
+        case TAG_PRINT:
+            return std::make_unique<PrintStmt>(readExpr());
+        case TAG_RETURN:
+            return std::make_unique<ReturnStmt>(readOptionalExpr());
+        case TAG_BLOCK:
+            return std::make_unique<BlockStmt>(readStatements());
+        case TAG_IF: {
+            ExprPtr condition               = readExpr();
+            std::vector<StmtPtr> thenBranch = readStatements();
+            std::vector<StmtPtr> elseBranch = readStatements();
+            return std::make_unique<IfStmt>(std::move(condition), std::move(thenBranch),
+                                            std::move(elseBranch));
+        }
+        case TAG_WHILE: {
+            Token keyword             = readToken();
+            ExprPtr condition         = readExpr();
+            std::vector<StmtPtr> body = readStatements();
+            return std::make_unique<WhileStmt>(keyword, std::move(condition), std::move(body));
+        }
+        case TAG_FUNCTION: {
+            Token name = readToken();
+            std::vector<Token> params(readCount(TOKEN_BYTES));
+            for (Token &param : params)
+                param = readToken();
+            return std::make_unique<FunctionStmt>(name, std::move(params), readStatements());
+        }
+        case TAG_CLASS: {
+            Token name       = readToken();
+            Token superclass = readToken();
+            return std::make_unique<ClassStmt>(name, superclass, readStatements());
+        }
+        case TAG_FOR_IN: {
+            Token variable            = readToken();
+            ExprPtr iterable          = readExpr();
+            std::vector<StmtPtr> body = readStatements();
+            bool parallel             = get<uint8_t>() != 0;
+            return std::make_unique<ForInStmt>(variable, std::move(iterable), std::move(body),
+                                               parallel);
+        }
+        default:
+            throw std::runtime_error("Bad statement in AST cache.");
+        }
+    }
+};
+
+// --- Memory-Mapped Files ---
+
+/**
+ * MappedFile - a read-only view of a whole file
+ * Uses mmap on POSIX systems; elsewhere the file is read into memory.
+ */
+class MappedFile {
+public:
+    explicit MappedFile(const std::string &path) {
+#ifdef _WIN32
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+            return;
+        std::ostringstream contents;
+        contents << file.rdbuf();
+        buffer = contents.str();
+        bytes  = reinterpret_cast<const uint8_t *>(buffer.data());
+        length = buffer.size();
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return;
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            void *mapped = mmap(nullptr, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED) {
+                bytes  = static_cast<const uint8_t *>(mapped);
+                length = (size_t) info.st_size;
+            }
+        }
+        close(fd); // The mapping stays valid without the descriptor
+#endif
+    }
+
+    ~MappedFile() {
+#ifndef _WIN32
+        if (bytes)
+            munmap(const_cast<uint8_t *>(bytes), length);
+#endif
+    }
+
+    MappedFile(const MappedFile &)            = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const uint8_t *data() const {
+        return bytes;
+    }
+    size_t size() const {
+        return length;
+    }
+
+private:
+    const uint8_t *bytes = nullptr;
+    size_t length        = 0;
+#ifdef _WIN32
+    std::string buffer;
+#endif
+};
+
+// --- AstCache ---
+
+std::string AstCache::pathFor(const std::string &sourcePath) {
+    return sourcePath + "c";
+}
+
+uint64_t AstCache::hash(const std::string &source) {
+    uint64_t hash = 0xcbf29ce484222325ull; // FNV-1a offset basis
+    for (unsigned char c : source) {
+        hash ^= c;
+        hash *= 0x100000001b3ull; // FNV prime
+    }
+    return hash;
+}
+
+bool AstCache::load(const std::string &cachePath, const std::string &source,
+                    std::vector<StmtPtr> &statements) {
+    MappedFile file(cachePath);
+    if (!file.data())
+        return false;
+
+    try {
+        AstReader reader(file.data(), file.size());
+        CacheHeader header = reader.get<CacheHeader>();
+        if (header.magic != CACHE_MAGIC || header.version != CACHE_VERSION ||
+            header.byteOrder != CACHE_BYTE_ORDER || header.tokenTypes != CACHE_TOKEN_TYPES ||
+            header.sourceSize != source.size() || header.sourceHash != hash(source))
+            return false;
+
+        reader.readStrings(header.stringCount);
+        statements = reader.readStatements();
+        return reader.atEnd();
+    } catch (const std::exception &) {
+        // A damaged cache is a cache miss, whether it fails a check or an allocation
+        statements.clear();
+        return false;
+    }
+}
+
+bool AstCache::save(const std::string &cachePath, const std::string &source,
+                    const std::vector<StmtPtr> &statements) {
+    AstWriter writer;
+    writer.write(statements);
+
+    CacheHeader header;
+    header.magic          = CACHE_MAGIC;
+    header.version        = CACHE_VERSION;
+    header.byteOrder      = CACHE_BYTE_ORDER;
+    header.tokenTypes     = CACHE_TOKEN_TYPES;
+    header.sourceHash     = hash(source);
+    header.sourceSize     = source.size();
+    header.stringCount    = (uint32_t) writer.strings.size();
+    header.reserved       = 0;
+
+    // Unique per thread, so concurrent batch runs never write the same temporary file
+    size_t thread         = std::hash<std::thread::id>{}(std::this_thread::get_id());
+    std::string temporary = cachePath + ".tmp" + std::to_string(thread);
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file)
+            return false;
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        for (const std::string *text : writer.strings) {
+            uint32_t length = (uint32_t) text->size();
+            file.write(reinterpret_cast<const char *>(&length), sizeof(length));
+            file.write(text->data(), length);
+        }
+        file.write(reinterpret_cast<const char *>(writer.body.data()), writer.body.size());
+        if (!file) {
+            file.close();
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+    if (std::rename(temporary.c_str(), cachePath.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "ast.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * AstCache - parsed programs saved next to their source as compact binary .scsac files
+ *
+ * A cache file holds the parsed statements together with an FNV-1a hash of the source they
+ * came from. When the source is unchanged, loading the file (memory-mapped where the platform
+ * allows) replaces lexing and parsing entirely. Any mismatch or damage makes load() fail, and
+ * the caller simply parses the source again.
+ */
+class AstCache {
+public:
+    /**
+     * Cache file used for a source file: 'program.scsa' is cached in 'program.scsac'
+     */
+    static std::string pathFor(const std::string &sourcePath);
+
+    /**
+     * 64-bit FNV-1a hash of a program's text, which keys its cache file
+     */
+    static uint64_t hash(const std::string &source);
+
+    /**
+     * Load the statements cached for 'source'
+     * @param cachePath The cache file to read
+     * @param source The current program text; the cache must have been made from exactly this
+     * @param statements Receives the statements on success
+     * @return false if there is no usable cache for this source
+     */
+    static bool load(const std::string &cachePath, const std::string &source,
+                     std::vector<StmtPtr> &statements);
+
+    /**
+     * Write the statements parsed from 'source' to a cache file
+     * The file is written under a temporary name and renamed into place, so concurrent
+     * readers never see a partial file. Failure (e.g. a read-only directory) is not an error.
+     * @return true if the cache file was written
+     */
+    static bool save(const std::string &cachePath, const std::string &source,
+                     const std::vector<StmtPtr> &statements);
+};
@@ -9,7 +9,7 @@
  * @param statements The vector of statement pointers to process
  */
 void ASTPrinter::print(const std::vector<StmtPtr> &statements) {
-    std::cout << "AST Root" << std::endl;
+    out << "AST Root" << std::endl;
     for (const auto &stmt : statements) {
         accept(stmt.get());
     }
@@ -43,11 +43,11 @@ void ASTPrinter::accept(Stmt *stmt) {
  * @param stmt Pointer to the class statement node
  */
 void ASTPrinter::visitClassStmt(ClassStmt *stmt) {
-    std::cout << indent << "[Class] " << stmt->name.lexeme;
+    out << indent << "[Class] " << stmt->name.lexeme;
     if (stmt->superclass.type != TOK_EOF) {
-        std::cout << " < " << stmt->superclass.lexeme;
+        out << " < " << stmt->superclass.lexeme;
     }
-    std::cout << std::endl;
+    out << std::endl;
 
     IndentScope scope(*this);
     for (const auto &method : stmt->methods) {
@@ -61,11 +61,11 @@ void ASTPrinter::visitClassStmt(ClassStmt *stmt) {
  * @param stmt Pointer to the function statement node
  */
 void ASTPrinter::visitFunctionStmt(FunctionStmt *stmt) {
-    std::cout << indent << "[Function] " << stmt->name.lexeme << "(";
+    out << indent << "[Function] " << stmt->name.lexeme << "(";
     for (size_t i = 0; i < stmt->params.size(); ++i) {
-        std::cout << stmt->params[i].lexeme << (i < stmt->params.size() - 1 ? ", " : "");
+        out << stmt->params[i].lexeme << (i < stmt->params.size() - 1 ? ", " : "");
     }
-    std::cout << ")" << std::endl;
+    out << ")" << std::endl;
 
     IndentScope scope(*this);
     for (const auto &bodyStmt : stmt->body) {
@@ -80,17 +80,17 @@ void ASTPrinter::visitFunctionStmt(FunctionStmt *stmt) {
  * @param stmt Pointer to the if-statement node
  */
 void ASTPrinter::visitIfStmt(IfStmt *stmt) {
-    std::cout << indent << "[If]" << std::endl;
+    out << indent << "[If]" << std::endl;
 
     IndentScope scope(*this);
 
-    std::cout << indent << "Condition:" << std::endl;
+    out << indent << "Condition:" << std::endl;
     {
         IndentScope condScope(*this);
         accept(stmt->condition.get());
     }
 
-    std::cout << indent << "Then:" << std::endl;
+    out << indent << "Then:" << std::endl;
     {
         IndentScope thenScope(*this);
         for (const auto &st : stmt->thenBranch)
@@ -98,7 +98,7 @@ void ASTPrinter::visitIfStmt(IfStmt *stmt) {
     }
 
     if (!stmt->elseBranch.empty()) {
-        std::cout << indent << "Else:" << std::endl;
+        out << indent << "Else:" << std::endl;
         IndentScope elseScope(*this);
         for (const auto &st : stmt->elseBranch)
             accept(st.get());
@@ -111,16 +111,16 @@ void ASTPrinter::visitIfStmt(IfStmt *stmt) {
  * @param stmt Pointer to the while-statement node
  */
 void ASTPrinter::visitWhileStmt(WhileStmt *stmt) {
-    std::cout << indent << "[While]" << std::endl;
+    out << indent << "[While]" << std::endl;
 
     IndentScope scope(*this);
-    std::cout << indent << "Condition:" << std::endl;
+    out << indent << "Condition:" << std::endl;
     {
         IndentScope condScope(*this);
         accept(stmt->condition.get());
     }
 
-    std::cout << indent << "Body:" << std::endl;
+    out << indent << "Body:" << std::endl;
     {
         IndentScope bodyScope(*this);
         for (const auto &st : stmt->body)
@@ -134,16 +134,17 @@ void ASTPrinter::visitWhileStmt(WhileStmt *stmt) {
  * @param stmt Pointer to the for-in statement node
  */
 void ASTPrinter::visitForInStmt(ForInStmt *stmt) {
-    std::cout << indent << "[ForIn] " << stmt->variable.lexeme << std::endl;
+    out << indent << (stmt->parallel ? "[ParallelForIn] " : "[ForIn] ")
+        << stmt->variable.lexeme << std::endl;
 
     IndentScope scope(*this);
-    std::cout << indent << "Iterable:" << std::endl;
+    out << indent << "Iterable:" << std::endl;
     {
         IndentScope iterScope(*this);
         accept(stmt->iterable.get());
     }
 
-    std::cout << indent << "Body:" << std::endl;
+    out << indent << "Body:" << std::endl;
     {
         IndentScope bodyScope(*this);
         for (const auto &st : stmt->body)
@@ -157,7 +158,7 @@ void ASTPrinter::visitForInStmt(ForInStmt *stmt) {
  * @param stmt Pointer to the return statement node
  */
 void ASTPrinter::visitReturnStmt(ReturnStmt *stmt) {
-    std::cout << indent << "[Return]" << std::endl;
+    out << indent << "[Return]" << std::endl;
     if (stmt->value) {
         IndentScope scope(*this);
         accept(stmt->value.get());
@@ -170,7 +171,7 @@ void ASTPrinter::visitReturnStmt(ReturnStmt *stmt) {
  * @param stmt Pointer to the print statement node
  */
 void ASTPrinter::visitPrintStmt(PrintStmt *stmt) {
-    std::cout << indent << "[Print]" << std::endl;
+    out << indent << "[Print]" << std::endl;
     IndentScope scope(*this);
     accept(stmt->expression.get());
 }
@@ -182,7 +183,7 @@ void ASTPrinter::visitPrintStmt(PrintStmt *stmt) {
  * @param stmt Pointer to the expression statement node
  */
 void ASTPrinter::visitExpressionStmt(ExpressionStmt *stmt) {
-    std::cout << indent << "[ExprStmt]" << std::endl;
+    out << indent << "[ExprStmt]" << std::endl;
     IndentScope scope(*this);
     accept(stmt->expression.get());
 }
@@ -193,7 +194,7 @@ void ASTPrinter::visitExpressionStmt(ExpressionStmt *stmt) {
  * @param stmt Pointer to the block statement node
  */
 void ASTPrinter::visitBlockStmt(BlockStmt *stmt) {
-    std::cout << indent << "[Block]" << std::endl;
+    out << indent << "[Block]" << std::endl;
     IndentScope scope(*this);
     for (const auto &s : stmt->statements) {
         accept(s.get());
@@ -208,7 +209,7 @@ void ASTPrinter::visitBlockStmt(BlockStmt *stmt) {
  * @param expr Pointer to the binary expression node
  */
 void ASTPrinter::visitBinaryExpr(BinaryExpr *expr) {
-    std::cout << indent << "Binary (" << expr->op.lexeme << ")" << std::endl;
+    out << indent << "Binary (" << expr->op.lexeme << ")" << std::endl;
     IndentScope scope(*this);
     accept(expr->left.get());
     accept(expr->right.get());
@@ -220,16 +221,16 @@ void ASTPrinter::visitBinaryExpr(BinaryExpr *expr) {
  * @param expr Pointer to the assignment expression node
  */
 void ASTPrinter::visitAssignExpr(AssignExpr *expr) {
-    std::cout << indent << "Assign (=)" << std::endl;
+    out << indent << "Assign (=)" << std::endl;
     IndentScope scope(*this);
 
-    std::cout << indent << "Target:" << std::endl;
+    out << indent << "Target:" << std::endl;
     {
         IndentScope targetScope(*this);
         accept(expr->target.get());
     }
 
-    std::cout << indent << "Value:" << std::endl;
+    out << indent << "Value:" << std::endl;
     {
         IndentScope valScope(*this);
         accept(expr->value.get());
@@ -242,7 +243,7 @@ void ASTPrinter::visitAssignExpr(AssignExpr *expr) {
  * @param expr Pointer to the literal expression node
  */
 void ASTPrinter::visitLiteralExpr(LiteralExpr *expr) {
-    std::cout << indent << "Literal: " << expr->token.lexeme << std::endl;
+    out << indent << "Literal: " << expr->token.lexeme << std::endl;
 }
 
 /**
@@ -251,7 +252,7 @@ void ASTPrinter::visitLiteralExpr(LiteralExpr *expr) {
  * @param expr Pointer to the variable expression node
  */
 void ASTPrinter::visitVariableExpr(VariableExpr *expr) {
-    std::cout << indent << "Var: " << expr->name.lexeme << std::endl;
+    out << indent << "Var: " << expr->name.lexeme << std::endl;
 }
 
 /**
@@ -260,16 +261,16 @@ void ASTPrinter::visitVariableExpr(VariableExpr *expr) {
  * @param expr Pointer to the call expression node
  */
 void ASTPrinter::visitCallExpr(CallExpr *expr) {
-    std::cout << indent << "Call" << std::endl;
+    out << indent << "Call" << std::endl;
     IndentScope scope(*this);
 
-    std::cout << indent << "Callee:" << std::endl;
+    out << indent << "Callee:" << std::endl;
     {
         IndentScope calleeScope(*this);
         accept(expr->callee.get());
     }
 
-    std::cout << indent << "Args:" << std::endl;
+    out << indent << "Args:" << std::endl;
     {
         IndentScope argScope(*this);
         for (const auto &arg : expr->args) {
@@ -284,7 +285,7 @@ void ASTPrinter::visitCallExpr(CallExpr *expr) {
  * @param expr Pointer to the get expression node
  */
 void ASTPrinter::visitGetExpr(GetExpr *expr) {
-    std::cout << indent << "Get Property: ." << expr->name.lexeme << std::endl;
+    out << indent << "Get Property: ." << expr->name.lexeme << std::endl;
     IndentScope scope(*this);
     accept(expr->object.get());
 }
@@ -295,16 +296,16 @@ void ASTPrinter::visitGetExpr(GetExpr *expr) {
  * @param expr Pointer to the array access expression node
  */
 void ASTPrinter::visitArrayAccessExpr(ArrayAccessExpr *expr) {
-    std::cout << indent << "Array Index []" << std::endl;
+    out << indent << "Array Index []" << std::endl;
     IndentScope scope(*this);
 
-    std::cout << indent << "Array:" << std::endl;
+    out << indent << "Array:" << std::endl;
     {
         IndentScope arrScope(*this);
         accept(expr->array.get());
     }
 
-    std::cout << indent << "Index:" << std::endl;
+    out << indent << "Index:" << std::endl;
     {
         IndentScope idxScope(*this);
         accept(expr->index.get());
@@ -317,20 +318,48 @@ void ASTPrinter::visitArrayAccessExpr(ArrayAccessExpr *expr) {
  * @param expr Pointer to the array literal expression node
  */
 void ASTPrinter::visitArrayLitExpr(ArrayLitExpr *expr) {
-    std::cout << indent << "Array Literal []" << std::endl;
+    out << indent << "Array Literal []" << std::endl;
     IndentScope scope(*this);
     for (const auto &elem : expr->elements) {
         accept(elem.get());
     }
 }
 
+/**
+ * Visit a Slice Expression
+ * Prints the sliced array and whichever of the start/end bounds are present.
+ * @param expr Pointer to the slice expression node
+ */
+void ASTPrinter::visitSliceExpr(SliceExpr *expr) {
+    out << indent << "Array Slice [:]" << std::endl;
+    IndentScope scope(*this);
+
+    out << indent << "Array:" << std::endl;
+    {
+        IndentScope arrScope(*this);
+        accept(expr->array.get());
+    }
+
+    if (expr->start) {
+        out << indent << "Start:" << std::endl;
+        IndentScope startScope(*this);
+        accept(expr->start.get());
+    }
+
+    if (expr->end) {
+        out << indent << "End:" << std::endl;
+        IndentScope endScope(*this);
+        accept(expr->end.get());
+    }
+}
+
 /**
  * Visit a New Instance Expression
  * Prints the class instantiation and the constructor arguments.
  * @param expr Pointer to the new expression node
  */
 void ASTPrinter::visitNewExpr(NewExpr *expr) {
-    std::cout << indent << "New " << expr->className.lexeme << std::endl;
+    out << indent << "New " << expr->className.lexeme << std::endl;
     IndentScope scope(*this);
     for (const auto &arg : expr->args) {
         accept(arg.get());
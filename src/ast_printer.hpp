@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ast.hpp"
+#include <iostream>
 #include <string>
 #include <vector>
 
@@ -11,6 +12,12 @@
  */
 class ASTPrinter : public ExprVisitor, public StmtVisitor {
 public:
+    /**
+     * @param out The stream the tree is printed to
+     */
+    explicit ASTPrinter(std::ostream &out = std::cout) : out(out) {
+    }
+
     /**
      * Entry point for printing the AST.
      * @param statements The vector of top-level statements to print
@@ -26,6 +33,7 @@ public:
     void visitGetExpr(GetExpr *expr) override;
     void visitArrayAccessExpr(ArrayAccessExpr *expr) override;
     void visitArrayLitExpr(ArrayLitExpr *expr) override;
+    void visitSliceExpr(SliceExpr *expr) override;
     void visitNewExpr(NewExpr *expr) override;
 
     // --- StmtVisitor Implementation ---
@@ -40,6 +48,7 @@ public:
     void visitForInStmt(ForInStmt *stmt) override;
 
 private:
+    std::ostream &out;
     std::string indent = ""; // Holds the current indentation string
 
     /**
@@ -0,0 +1,303 @@
+#include "builtins.hpp"
+#include "interpreter.hpp"
+#include "kernels.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// ============================================================
+// Argument Helpers
+// ============================================================
+
+/**
+ * Borrow the elements of a list argument as a contiguous buffer of numbers
+ * Packed number lists are used in place; a generic list holding only numbers is unboxed
+ * into 'scratch'. Anything else is an error.
+ * @param value The argument to inspect
+ * @param fnName Name of the builtin, for error messages
+ * @param scratch Storage used when the list is not already packed
+ */
+static const std::vector<double> &numbersOf(const RuntimeValue &value, const std::string &fnName,
+                                            std::vector<double> &scratch) {
+    if (!value.is<ArrayPtr>()) {
+        throw NativeError(fnName + " expects a list of numbers.");
+    }
+    const Array &array = *value.as<ArrayPtr>();
+    if (array.kind() == Array::Kind::Number) {
+        return array.numbers();
+    }
+
+    scratch.clear();
+    scratch.reserve(array.size());
+    for (size_t i = 0; i < array.size(); ++i) {
+        RuntimeValue element = array.get(i);
+        if (!element.is<double>()) {
+            throw NativeError(fnName + " expects a list of numbers.");
+        }
+        scratch.push_back(element.as<double>());
+    }
+    return scratch;
+}
+
+static const std::vector<double> &nonEmptyNumbersOf(const RuntimeValue &value,
+                                                    const std::string &fnName,
+                                                    std::vector<double> &scratch) {
+    const std::vector<double> &numbers = numbersOf(value, fnName, scratch);
+    if (numbers.empty()) {
+        throw NativeError(fnName + " expects a non-empty list.");
+    }
+    return numbers;
+}
+
+static double numberArg(const RuntimeValue &value, const std::string &fnName) {
+    if (!value.is<double>()) {
+        throw NativeError(fnName + " expects a number.");
+    }
+    return value.as<double>();
+}
+
+// ============================================================
+// List Statistics (vectorized in kernels.cpp)
+// ============================================================
+
+static RuntimeValue nativeSum(Interpreter &, ArgSpan args) {
+    std::vector<double> scratch;
+    const std::vector<double> &numbers = numbersOf(args[0], "SUM", scratch);
+    return {kernels::sum(numbers.data(), numbers.size())};
+}
+
+static RuntimeValue nativeMin(Interpreter &, ArgSpan args) {
+    std::vector<double> scratch;
+    const std::vector<double> &numbers = nonEmptyNumbersOf(args[0], "MIN", scratch);
+    return {kernels::min(numbers.data(), numbers.size())};
+}
+
+static RuntimeValue nativeMax(Interpreter &, ArgSpan args) {
+    std::vector<double> scratch;
+    const std::vector<double> &numbers = nonEmptyNumbersOf(args[0], "MAX", scratch);
+    return {kernels::max(numbers.data(), numbers.size())};
+}
+
+static RuntimeValue nativeMean(Interpreter &, ArgSpan args) {
+    std::vector<double> scratch;
+    const std::vector<double> &numbers = nonEmptyNumbersOf(args[0], "MEAN", scratch);
+    return {kernels::sum(numbers.data(), numbers.size()) / (double) numbers.size()};
+}
+
+static RuntimeValue nativeDot(Interpreter &, ArgSpan args) {
+    std::vector<double> scratchA, scratchB;
+    const std::vector<double> &a = numbersOf(args[0], "DOT", scratchA);
+    const std::vector<double> &b = numbersOf(args[1], "DOT", scratchB);
+    if (a.size() != b.size()) {
+        throw NativeError("DOT expects two lists of the same length.");
+    }
+    return {kernels::dot(a.data(), b.data(), a.size())};
+}
+
+// ============================================================
+// Element-wise Scalar Operations (return a new packed list)
+// ============================================================
+
+static RuntimeValue nativeAddEach(Interpreter &, ArgSpan args) {
+    std::vector<double> scratch;
+    const std::vector<double> &numbers = numbersOf(args[0], "ADD_EACH", scratch);
+    double k                           = numberArg(args[1], "ADD_EACH");
+
+    // Reserving first charges the result's buffer against the memory limit
+    auto out = std::make_shared<Array>();
+    out->reserve(numbers.size());
+    out->numbers().resize(numbers.size());
+    kernels::addScalar(numbers.data(), k, out->numbers().data(), numbers.size());
+    return {out};
+}
+
+static RuntimeValue nativeMultiplyEach(Interpreter &, ArgSpan args) {
+    std::vector<double> scratch;
+    const std::vector<double> &numbers = numbersOf(args[0], "MULTIPLY_EACH", scratch);
+    double k                           = numberArg(args[1], "MULTIPLY_EACH");
+
+    auto out = std::make_shared<Array>();
+    out->reserve(numbers.size());
+    out->numbers().resize(numbers.size());
+    kernels::mulScalar(numbers.data(), k, out->numbers().data(), numbers.size());
+    return {out};
+}
+
+// ============================================================
+// Sorting
+// ============================================================
+
+/**
+ * Ascending order on numbers with every NaN after every other number
+ * '<' alone is not a strict weak ordering once a NaN is involved, which std::sort requires.
+ */
+static bool numberBefore(double a, double b) {
+    return !std::isnan(a) && (std::isnan(b) || a < b);
+}
+
+/**
+ * Sort a list in place and return it
+ * Without a comparator, packed number lists are sorted directly on their double buffer and
+ * boolean lists with a counting pass; generic lists must hold only numbers or only strings.
+ * Numbers sort ascending with NaNs last.
+ * With a comparator, 'comparator(a, b)' returns TRUE when a belongs before b.
+ * @param stable Whether equal elements must keep their relative order
+ */
+static RuntimeValue sortList(Interpreter &interpreter, ArgSpan args,
+                             const std::string &fnName, bool stable) {
+    if (!args[0].is<ArrayPtr>()) {
+        throw NativeError(fnName + " expects a list.");
+    }
+    ArrayPtr array = args[0].as<ArrayPtr>();
+    if (array->isFrozen()) {
+        throw NativeError(fnName + " cannot sort a shared list inside a PARALLEL FOR loop.");
+    }
+
+    if (args.size() > 1) {
+        if (!args[1].is<std::shared_ptr<Callable>>()) {
+            throw NativeError(fnName + " expects a comparator function.");
+        }
+        auto comparator = args[1].as<std::shared_ptr<Callable>>();
+        if (comparator->minArity() > 2 || comparator->arity() < 2) {
+            throw NativeError(fnName + " comparator must take 2 arguments.");
+        }
+
+        std::vector<RuntimeValue> values;
+        values.reserve(array->size());
+        for (size_t i = 0; i < array->size(); ++i) {
+            values.push_back(array->get(i));
+        }
+
+        // A user comparator need not be a strict weak ordering, which std::sort requires to
+        // stay in bounds; merge sort only ever reads inside the range, whatever it is told.
+        // Sorting a copy also leaves the list untouched if the comparator raises an error.
+        std::stable_sort(values.begin(), values.end(),
+                         [&](const RuntimeValue &a, const RuntimeValue &b) {
+                             return interpreter.isTruthy(comparator->call(interpreter, {a, b}));
+                         });
+        *array = std::move(*Array::fromValues(std::move(values)));
+        return {array};
+    }
+
+    switch (array->kind()) {
+    case Array::Kind::Number: {
+        std::vector<double> &numbers = array->numbers();
+        if (stable)
+            std::stable_sort(numbers.begin(), numbers.end(), numberBefore);
+        else
+            std::sort(numbers.begin(), numbers.end(), numberBefore);
+        break;
+    }
+    case Array::Kind::Boolean: {
+        // Only two possible keys: count the FALSEs and refill
+        std::vector<uint8_t> &booleans = array->booleans();
+        size_t falses                  = std::count(booleans.begin(), booleans.end(), 0);
+        std::fill(booleans.begin(), booleans.begin() + falses, 0);
+        std::fill(booleans.begin() + falses, booleans.end(), 1);
+        break;
+    }
+    case Array::Kind::Generic: {
+        std::vector<RuntimeValue> &values = array->values();
+        bool allNumbers                   = true;
+        bool allStrings                   = true;
+        for (const auto &value : values) {
+            allNumbers = allNumbers && value.is<double>();
+            allStrings = allStrings && value.is<std::string>();
+        }
+
+        auto byNumber = [](const RuntimeValue &a, const RuntimeValue &b) {
+            return numberBefore(a.as<double>(), b.as<double>());
+        };
+        auto byString = [](const RuntimeValue &a, const RuntimeValue &b) {
+            return a.as<std::string>() < b.as<std::string>();
+        };
+
+        if (allNumbers) {
+            if (stable)
+                std::stable_sort(values.begin(), values.end(), byNumber);
+            else
+                std::sort(values.begin(), values.end(), byNumber);
+        } else if (allStrings) {
+            if (stable)
+                std::stable_sort(values.begin(), values.end(), byString);
+            else
+                std::sort(values.begin(), values.end(), byString);
+        } else {
+            throw NativeError(fnName +
+                              " can only order lists of numbers or strings without a comparator.");
+        }
+        break;
+    }
+    }
+    return {array};
+}
+
+static RuntimeValue nativeSort(Interpreter &interpreter, ArgSpan args) {
+    return sortList(interpreter, args, "SORT", false);
+}
+
+static RuntimeValue nativeStableSort(Interpreter &interpreter, ArgSpan args) {
+    return sortList(interpreter, args, "STABLE_SORT", true);
+}
+
+// ============================================================
+// Registry
+// ============================================================
+
+NativeRegistry &NativeRegistry::standard() {
+    // Built once, thread-safely, on first use
+    static NativeRegistry registry = [] {
+        NativeRegistry r;
+        registerListBuiltins(r);
+        registerStdlib(r);
+        return r;
+    }();
+    return registry;
+}
+
+void NativeRegistry::add(const std::string &name, int arity, NativeFn fn) {
+    add(name, arity, arity, fn);
+}
+
+void NativeRegistry::add(const std::string &name, int minArity, int maxArity, NativeFn fn) {
+    // Re-registering a name replaces the earlier function
+    for (auto &function : functions) {
+        if (function->getName() == name) {
+            function = std::make_shared<NativeFunction>(name, minArity, maxArity, fn);
+            return;
+        }
+    }
+    functions.push_back(std::make_shared<NativeFunction>(name, minArity, maxArity, fn));
+}
+
+std::shared_ptr<NativeFunction> NativeRegistry::find(const std::string &name) const {
+    for (const auto &function : functions) {
+        if (function->getName() == name)
+            return function;
+    }
+    return nullptr;
+}
+
+void NativeRegistry::markImpure(const std::string &name) {
+    if (auto function = find(name))
+        function->markImpure();
+}
+
+void NativeRegistry::defineAll(Environment &globals) const {
+    for (const auto &function : functions) {
+        globals.define(function->getName(), {std::shared_ptr<Callable>(function)});
+    }
+}
+
+void registerListBuiltins(NativeRegistry &registry) {
+    registry.add("SUM", 1, nativeSum);
+    registry.add("MIN", 1, nativeMin);
+    registry.add("MAX", 1, nativeMax);
+    registry.add("MEAN", 1, nativeMean);
+    registry.add("DOT", 2, nativeDot);
+    registry.add("ADD_EACH", 2, nativeAddEach);
+    registry.add("MULTIPLY_EACH", 2, nativeMultiplyEach);
+
+    registry.add("SORT", 1, 2, nativeSort);
+    registry.add("STABLE_SORT", 1, 2, nativeStableSort);
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "runtime.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * ArgSpan - a read-only view of the arguments passed to a native function
+ * Points straight at the caller's evaluated arguments, so calling a native never copies them.
+ */
+class ArgSpan {
+public:
+    ArgSpan(const RuntimeValue *first, size_t count) : first(first), count(count) {
+    }
+    ArgSpan(const std::vector<RuntimeValue> &values) : first(values.data()), count(values.size()) {
+    }
+
+    size_t size() const {
+        return count;
+    }
+    const RuntimeValue &operator[](size_t index) const {
+        return first[index];
+    }
+    const RuntimeValue *begin() const {
+        return first;
+    }
+    const RuntimeValue *end() const {
+        return first + count;
+    }
+
+private:
+    const RuntimeValue *first;
+    size_t count;
+};
+
+/**
+ * Signature of every native function
+ * Arity has already been checked by the caller. Errors are reported by throwing NativeError.
+ */
+using NativeFn = RuntimeValue (*)(Interpreter &interpreter, ArgSpan args);
+
+/**
+ * NativeFunction - a builtin implemented in C++
+ * Behaves like any other Callable, so builtins can be passed around as values, but the
+ * interpreter calls invoke() directly with an ArgSpan when it sees one.
+ */
+class NativeFunction : public Callable {
+public:
+    NativeFunction(std::string name, int minArity, int maxArity, NativeFn fn)
+        : name(std::move(name)), minParams(minArity), numParams(maxArity), fn(fn) {
+    }
+
+    int arity() override {
+        return numParams;
+    }
+
+    int minArity() override {
+        return minParams;
+    }
+
+    /**
+     * Fast path: call with a view of already-evaluated arguments
+     */
+    RuntimeValue invoke(Interpreter &interpreter, ArgSpan args) const {
+        return fn(interpreter, args);
+    }
+
+    RuntimeValue call(Interpreter &interpreter, std::vector<RuntimeValue> arguments) override {
+        return fn(interpreter, ArgSpan(arguments));
+    }
+
+    std::string toString() override {
+        return "<native fn " + name + ">";
+    }
+
+    const std::string &getName() const {
+        return name;
+    }
+
+    /**
+     * Whether the result depends only on the arguments (no clock, randomness or I/O)
+     * Calls to impure natives stop a user function from being memoized.
+     */
+    bool isPure() const {
+        return pure;
+    }
+
+    void markImpure() {
+        pure = false;
+    }
+
+private:
+    std::string name;
+    int minParams;
+    int numParams;
+    NativeFn fn;
+    bool pure = true;
+};
+
+/**
+ * NativeRegistry - the set of C++ functions visible to pseudocode programs
+ *
+ * Functions are registered once with a name and an arity, then defined as globals in every
+ * Interpreter built from the registry. The registered NativeFunction objects are immutable
+ * and shared between interpreters.
+ */
+class NativeRegistry {
+public:
+    /**
+     * The registry holding the standard library (lists, math, strings, time)
+     * Embedders may add their own functions to it before creating interpreters.
+     */
+    static NativeRegistry &standard();
+
+    /**
+     * Register a function taking exactly 'arity' arguments
+     */
+    void add(const std::string &name, int arity, NativeFn fn);
+
+    /**
+     * Register a function whose trailing parameters are optional
+     */
+    void add(const std::string &name, int minArity, int maxArity, NativeFn fn);
+
+    /**
+     * Look up a registered function by name
+     * @return The function, or nullptr if no function has that name
+     */
+    std::shared_ptr<NativeFunction> find(const std::string &name) const;
+
+    /**
+     * Flag a registered function as impure (see NativeFunction::isPure)
+     */
+    void markImpure(const std::string &name);
+
+    /**
+     * Define every registered function in the given scope
+     * @param globals The interpreter's global environment
+     */
+    void defineAll(Environment &globals) const;
+
+private:
+    std::vector<std::shared_ptr<NativeFunction>> functions;
+};
+
+// --- Standard Library Modules ---
+
+/**
+ * List builtins: SUM, MIN, MAX, MEAN, DOT, ADD_EACH, MULTIPLY_EACH, SORT, STABLE_SORT
+ */
+void registerListBuiltins(NativeRegistry &registry);
+
+/**
+ * Math, string and time builtins (see stdlib.cpp)
+ */
+void registerStdlib(NativeRegistry &registry);
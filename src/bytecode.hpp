@@ -0,0 +1,91 @@
+#pragma once
+
+#include "ast.hpp"
+#include "runtime.hpp"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Operations understood by the stack VM
+ * Operands live in Instruction::a, b and c; their meaning is listed beside each opcode.
+ * Token operands index Chunk::tokens and are only used for error messages and names.
+ *
+ * The VM quickens OP_ADD, OP_BINARY '+' and OP_GET_INDEX sites by rewriting them in place to a
+ * form specialized for the operands they first see. The original opcode is kept in b and the
+ * site's SiteState in c; a quickened form whose guard fails restores the original for good.
+ */
+enum OpCode : uint8_t {
+    OP_CONSTANT,      // a: constant index
+    OP_NIL,           // Push nil
+    OP_POP,           // Discard the top of the stack
+    OP_GET_VAR,       // a: name token
+    OP_SET_VAR,       // a: name token (value stays on the stack)
+    OP_GET_PROP,      // a: name token
+    OP_SET_PROP,      // a: name token; pops the object, the value stays on the stack
+    OP_GET_INDEX,     // a: bracket token; pops index and list
+    OP_INDEX_LIST,    // As OP_GET_INDEX, where the indexed value is proven or was seen to be a list
+    OP_SET_INDEX,     // a: bracket token; pops index and list, the value stays on the stack
+    OP_SLICE,         // a: bracket token, b: 1 if a start bound was pushed, 2 if an end bound was
+    OP_ARRAY,         // a: element count
+    OP_BINARY,        // a: operator token
+    OP_ADD,           // a: operator token; the arithmetic and comparison opcodes below check
+    OP_SUBTRACT,      // that both operands are numbers, and take OP_BINARY's path if not
+    OP_MULTIPLY,
+    OP_DIVIDE,
+    OP_LESS,
+    OP_LT_OR_EQ,
+    OP_GREATER,
+    OP_GT_OR_EQ,
+    OP_ADD_NUM,       // a: operator token; the _NUM forms skip the check, and are only emitted
+    OP_SUBTRACT_NUM,  // where type inference proved both operands to be numbers
+    OP_MULTIPLY_NUM,
+    OP_DIVIDE_NUM,
+    OP_LESS_NUM,
+    OP_LT_OR_EQ_NUM,
+    OP_GREATER_NUM,
+    OP_GT_OR_EQ_NUM,
+    OP_ADD_STRINGS,   // a: operator token; a '+' site that saw two strings, checked as OP_ADD is
+    OP_CONCAT,        // a: operator token; both operands proven strings
+    OP_CALL,          // a: argument count, b: paren token
+    OP_TAIL_CALL,     // a: argument count, b: paren token; reuses the frame for user functions
+    OP_INVOKE,        // a: argument count, b: method name token, c: paren token
+    OP_NEW,           // a: argument count, b: class name token
+    OP_PRINT,         // Pops and prints the top of the stack
+    OP_RETURN,        // Pops the return value and leaves the frame
+    OP_JUMP,          // a: target instruction
+    OP_LOOP,          // a: target instruction, b: loop token; a back-edge, counted as a step
+    OP_JUMP_IF_FALSE, // a: target instruction; pops the condition
+    OP_FOR_PREP,      // a: loop variable token; turns the iterable into a list, pushes the position
+    OP_FOR_NEXT,      // a: exit target, b: loop variable token; opens the iteration scope
+    OP_PUSH_SCOPE,    // Enter a new block scope
+    OP_POP_SCOPE,     // Leave the innermost block scope
+    OP_FUNCTION,      // a: function index; defines the function in the current scope
+    OP_EXEC_STMT,     // a: statement index; runs the statement on the tree walker
+};
+
+// How far the VM has specialized an instruction; Instruction::c of the sites it quickens
+enum SiteState : int32_t {
+    SITE_UNSEEN,      // Not specialized yet (or emitted specialized by the compiler)
+    SITE_QUICKENED,   // Rewritten by the VM for the operands it saw; b holds the original opcode
+    SITE_DEOPTIMIZED, // Its guard failed once, so it stays generic
+};
+
+struct Instruction {
+    OpCode op;
+    int32_t a = 0;
+    int32_t b = 0;
+    int32_t c = 0;
+};
+
+/**
+ * Chunk - the compiled form of a script or a function body
+ * Tokens, functions and statements point back into the AST, which must outlive the chunk.
+ */
+struct Chunk {
+    std::vector<Instruction> code;
+    std::vector<RuntimeValue> constants;
+    std::vector<const Token *> tokens;
+    std::vector<FunctionStmt *> functions;
+    std::vector<Stmt *> statements;
+};
@@ -0,0 +1,320 @@
+#include "compiler.hpp"
+
+#include <stdexcept>
+
+// --- Entry Points ---
+
+std::unique_ptr<Chunk> Compiler::compileScript(const std::vector<StmtPtr> &statements) {
+    chunk      = std::make_unique<Chunk>();
+    inFunction = false;
+    types      = inferTypes(statements, nullptr);
+    compile(statements);
+    emit(OP_NIL);
+    emit(OP_RETURN);
+    return std::move(chunk);
+}
+
+std::unique_ptr<Chunk> Compiler::compileFunction(FunctionStmt *function) {
+    chunk      = std::make_unique<Chunk>();
+    inFunction = true;
+    types      = inferTypes(function->body, &function->params);
+    compile(function->body);
+    // Falling off the end of a function returns nil
+    emit(OP_NIL);
+    emit(OP_RETURN);
+    return std::move(chunk);
+}
+
+// --- Helpers ---
+
+void Compiler::compile(Expr *expr) {
+    expr->accept(*this);
+}
+
+void Compiler::compile(const std::vector<StmtPtr> &statements) {
+    for (const auto &stmt : statements) {
+        if (stmt)
+            stmt->accept(*this);
+    }
+}
+
+size_t Compiler::emit(OpCode op, int32_t a, int32_t b, int32_t c) {
+    chunk->code.push_back({op, a, b, c});
+    return chunk->code.size() - 1;
+}
+
+void Compiler::patchJump(size_t position) {
+    chunk->code[position].a = (int32_t) chunk->code.size();
+}
+
+int32_t Compiler::addConstant(RuntimeValue value) {
+    chunk->constants.push_back(std::move(value));
+    return (int32_t) chunk->constants.size() - 1;
+}
+
+int32_t Compiler::addToken(const Token &token) {
+    chunk->tokens.push_back(&token);
+    return (int32_t) chunk->tokens.size() - 1;
+}
+
+void Compiler::emitCall(OpCode op, CallExpr *expr) {
+    compile(expr->callee.get());
+    for (const auto &arg : expr->args) {
+        compile(arg.get());
+    }
+    emit(op, (int32_t) expr->args.size(), addToken(expr->paren));
+}
+
+OperandTypes Compiler::operandTypes(const Expr *expr) const {
+    auto found = types.find(expr);
+    return found == types.end() ? OperandTypes{} : found->second;
+}
+
+OpCode Compiler::binaryOpCode(BinaryExpr *expr) const {
+    OperandTypes operands = operandTypes(expr);
+    OpCode guarded, proven;
+    switch (expr->op.type) {
+    case TOK_PLUS:
+        if (operands.left == StaticType::String && operands.right == StaticType::String)
+            return OP_CONCAT;
+        guarded = OP_ADD;
+        proven  = OP_ADD_NUM;
+        break;
+    case TOK_MINUS:
+        guarded = OP_SUBTRACT;
+        proven  = OP_SUBTRACT_NUM;
+        break;
+    case TOK_MULTIPLY:
+        guarded = OP_MULTIPLY;
+        proven  = OP_MULTIPLY_NUM;
+        break;
+    case TOK_DIVIDE:
+        guarded = OP_DIVIDE;
+        proven  = OP_DIVIDE_NUM;
+        break;
+    case TOK_LESS_THAN:
+        guarded = OP_LESS;
+        proven  = OP_LESS_NUM;
+        break;
+    case TOK_LT_OR_EQ:
+        guarded = OP_LT_OR_EQ;
+        proven  = OP_LT_OR_EQ_NUM;
+        break;
+    case TOK_GREATER_THAN:
+        guarded = OP_GREATER;
+        proven  = OP_GREATER_NUM;
+        break;
+    case TOK_GT_OR_EQ:
+        guarded = OP_GT_OR_EQ;
+        proven  = OP_GT_OR_EQ_NUM;
+        break;
+    default:
+        return OP_BINARY;
+    }
+
+    auto mayBeNumber = [](StaticType type) {
+        return type == StaticType::Number || type == StaticType::Unknown;
+    };
+    if (operands.left == StaticType::Number && operands.right == StaticType::Number)
+        return proven;
+    // An operand proven to be anything else would only ever fail the guard
+    if (mayBeNumber(operands.left) && mayBeNumber(operands.right))
+        return guarded;
+    return OP_BINARY;
+}
+
+// --- ExprVisitor Implementation ---
+
+void Compiler::visitLiteralExpr(LiteralExpr *expr) {
+    // Literals are converted once here rather than on every evaluation
+    switch (expr->token.type) {
+    case TOK_FALSE:
+        emit(OP_CONSTANT, addConstant({false}));
+        break;
+    case TOK_TRUE:
+        emit(OP_CONSTANT, addConstant({true}));
+        break;
+    case TOK_STRING:
+        emit(OP_CONSTANT, addConstant({expr->token.lexeme}));
+        break;
+    case TOK_INTEGER:
+    case TOK_FLOAT:
+        emit(OP_CONSTANT, addConstant({std::stod(expr->token.lexeme)}));
+        break;
+    default:
+        emit(OP_NIL);
+        break;
+    }
+}
+
+void Compiler::visitVariableExpr(VariableExpr *expr) {
+    emit(OP_GET_VAR, addToken(expr->name));
+}
+
+void Compiler::visitAssignExpr(AssignExpr *expr) {
+    // The value is evaluated before the target, as in the tree walker
+    compile(expr->value.get());
+
+    if (auto varExpr = dynamic_cast<VariableExpr *>(expr->target.get())) {
+        emit(OP_SET_VAR, addToken(varExpr->name));
+    } else if (auto getExpr = dynamic_cast<GetExpr *>(expr->target.get())) {
+        compile(getExpr->object.get());
+        emit(OP_SET_PROP, addToken(getExpr->name));
+    } else if (auto arrExpr = dynamic_cast<ArrayAccessExpr *>(expr->target.get())) {
+        compile(arrExpr->array.get());
+        compile(arrExpr->index.get());
+        emit(OP_SET_INDEX, addToken(arrExpr->bracket));
+    } else {
+        throw std::runtime_error("Invalid assignment target.");
+    }
+}
+
+void Compiler::visitBinaryExpr(BinaryExpr *expr) {
+    compile(expr->left.get());
+    compile(expr->right.get());
+    emit(binaryOpCode(expr), addToken(expr->op));
+}
+
+void Compiler::visitCallExpr(CallExpr *expr) {
+    if (auto getExpr = dynamic_cast<GetExpr *>(expr->callee.get())) {
+        // Method call: the VM dispatches list methods without binding them first
+        compile(getExpr->object.get());
+        for (const auto &arg : expr->args) {
+            compile(arg.get());
+        }
+        emit(OP_INVOKE, (int32_t) expr->args.size(), addToken(getExpr->name),
+             addToken(expr->paren));
+        return;
+    }
+    emitCall(OP_CALL, expr);
+}
+
+void Compiler::visitGetExpr(GetExpr *expr) {
+    compile(expr->object.get());
+    emit(OP_GET_PROP, addToken(expr->name));
+}
+
+void Compiler::visitArrayAccessExpr(ArrayAccessExpr *expr) {
+    compile(expr->array.get());
+    compile(expr->index.get());
+    emit(operandTypes(expr).left == StaticType::List ? OP_INDEX_LIST : OP_GET_INDEX,
+         addToken(expr->bracket));
+}
+
+void Compiler::visitArrayLitExpr(ArrayLitExpr *expr) {
+    for (const auto &el : expr->elements) {
+        compile(el.get());
+    }
+    emit(OP_ARRAY, (int32_t) expr->elements.size());
+}
+
+void Compiler::visitSliceExpr(SliceExpr *expr) {
+    compile(expr->array.get());
+    int32_t bounds = 0;
+    if (expr->start) {
+        compile(expr->start.get());
+        bounds |= 1;
+    }
+    if (expr->end) {
+        compile(expr->end.get());
+        bounds |= 2;
+    }
+    emit(OP_SLICE, addToken(expr->bracket), bounds);
+}
+
+void Compiler::visitNewExpr(NewExpr *expr) {
+    emit(OP_GET_VAR, addToken(expr->className));
+    for (const auto &arg : expr->args) {
+        compile(arg.get());
+    }
+    emit(OP_NEW, (int32_t) expr->args.size(), addToken(expr->className));
+}
+
+// --- StmtVisitor Implementation ---
+
+void Compiler::visitExpressionStmt(ExpressionStmt *stmt) {
+    compile(stmt->expression.get());
+    emit(OP_POP);
+}
+
+void Compiler::visitPrintStmt(PrintStmt *stmt) {
+    compile(stmt->expression.get());
+    emit(OP_PRINT);
+}
+
+void Compiler::visitReturnStmt(ReturnStmt *stmt) {
+    // 'RETURN f(...)' replaces the current frame when f is a user function
+    auto call = dynamic_cast<CallExpr *>(stmt->value.get());
+    if (call && inFunction && !dynamic_cast<GetExpr *>(call->callee.get())) {
+        emitCall(OP_TAIL_CALL, call);
+    } else if (stmt->value) {
+        compile(stmt->value.get());
+    } else {
+        emit(OP_NIL);
+    }
+    emit(OP_RETURN);
+}
+
+void Compiler::visitBlockStmt(BlockStmt *stmt) {
+    emit(OP_PUSH_SCOPE);
+    compile(stmt->statements);
+    emit(OP_POP_SCOPE);
+}
+
+void Compiler::visitIfStmt(IfStmt *stmt) {
+    compile(stmt->condition.get());
+    size_t elseJump = emit(OP_JUMP_IF_FALSE);
+    compile(stmt->thenBranch);
+    if (stmt->elseBranch.empty()) {
+        patchJump(elseJump);
+        return;
+    }
+    size_t endJump = emit(OP_JUMP);
+    patchJump(elseJump);
+    compile(stmt->elseBranch);
+    patchJump(endJump);
+}
+
+void Compiler::visitWhileStmt(WhileStmt *stmt) {
+    int32_t loopStart = (int32_t) chunk->code.size();
+    compile(stmt->condition.get());
+    size_t exitJump = emit(OP_JUMP_IF_FALSE);
+    compile(stmt->body);
+    emit(OP_LOOP, loopStart, addToken(stmt->keyword));
+    patchJump(exitJump);
+}
+
+void Compiler::visitFunctionStmt(FunctionStmt *stmt) {
+    chunk->functions.push_back(stmt);
+    emit(OP_FUNCTION, (int32_t) chunk->functions.size() - 1);
+}
+
+void Compiler::visitClassStmt(ClassStmt *stmt) {
+    // Classes hold no code yet, so the tree walker declares them
+    chunk->statements.push_back(stmt);
+    emit(OP_EXEC_STMT, (int32_t) chunk->statements.size() - 1);
+}
+
+void Compiler::visitForInStmt(ForInStmt *stmt) {
+    if (stmt->parallel) {
+        // Iterations run on worker interpreters; the tree walker schedules them
+        chunk->statements.push_back(stmt);
+        emit(OP_EXEC_STMT, (int32_t) chunk->statements.size() - 1);
+        return;
+    }
+
+    // The list and the current position stay on the stack for the whole loop
+    int32_t variable = addToken(stmt->variable);
+    compile(stmt->iterable.get());
+    emit(OP_FOR_PREP, variable);
+
+    int32_t loopStart = (int32_t) chunk->code.size();
+    size_t exitJump   = emit(OP_FOR_NEXT, 0, variable);
+    compile(stmt->body);
+    emit(OP_POP_SCOPE);
+    emit(OP_JUMP, loopStart);
+    patchJump(exitJump);
+
+    emit(OP_POP);
+    emit(OP_POP);
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "ast.hpp"
+#include "bytecode.hpp"
+#include "types.hpp"
+
+#include <memory>
+#include <vector>
+
+/**
+ * Compiler - lowers the AST into bytecode for the stack VM
+ * Implements the Visitor pattern like the Interpreter, but emits instructions instead of
+ * evaluating, so running the result never recurses on the native stack.
+ */
+class Compiler : public ExprVisitor, public StmtVisitor {
+public:
+    /**
+     * Compile top-level statements into a chunk that ends by returning nil
+     * @param statements The parsed program
+     */
+    std::unique_ptr<Chunk> compileScript(const std::vector<StmtPtr> &statements);
+
+    /**
+     * Compile the body of a user function
+     * @param function The function declaration
+     */
+    std::unique_ptr<Chunk> compileFunction(FunctionStmt *function);
+
+    // --- ExprVisitor Implementation ---
+    void visitLiteralExpr(LiteralExpr *expr) override;
+    void visitVariableExpr(VariableExpr *expr) override;
+    void visitAssignExpr(AssignExpr *expr) override;
+    void visitBinaryExpr(BinaryExpr *expr) override;
+    void visitCallExpr(CallExpr *expr) override;
+    void visitGetExpr(GetExpr *expr) override;
+    void visitArrayAccessExpr(ArrayAccessExpr *expr) override;
+    void visitArrayLitExpr(ArrayLitExpr *expr) override;
+    void visitSliceExpr(SliceExpr *expr) override;
+    void visitNewExpr(NewExpr *expr) override;
+
+    // --- StmtVisitor Implementation ---
+    void visitExpressionStmt(ExpressionStmt *stmt) override;
+    void visitPrintStmt(PrintStmt *stmt) override;
+    void visitReturnStmt(ReturnStmt *stmt) override;
+    void visitBlockStmt(BlockStmt *stmt) override;
+    void visitIfStmt(IfStmt *stmt) override;
+    void visitWhileStmt(WhileStmt *stmt) override;
+    void visitFunctionStmt(FunctionStmt *stmt) override;
+    void visitClassStmt(ClassStmt *stmt) override;
+    void visitForInStmt(ForInStmt *stmt) override;
+
+private:
+    std::unique_ptr<Chunk> chunk; // The chunk being written
+    bool inFunction = false;      // Tail calls are only emitted inside function bodies
+    SiteTypes types;              // Operand types inferred for the body being compiled
+
+    void compile(Expr *expr);
+    void compile(const std::vector<StmtPtr> &statements);
+
+    /**
+     * Append an instruction
+     * @return Its position, for patching jump targets
+     */
+    size_t emit(OpCode op, int32_t a = 0, int32_t b = 0, int32_t c = 0);
+
+    /**
+     * Point the jump at 'position' to the next instruction to be emitted
+     */
+    void patchJump(size_t position);
+
+    int32_t addConstant(RuntimeValue value);
+    int32_t addToken(const Token &token);
+    void emitCall(OpCode op, CallExpr *expr);
+
+    /**
+     * Pick the opcode for a binary operator from its inferred operand types
+     * Proven numbers get an unchecked opcode, operands that may be numbers a guarded one.
+     */
+    OpCode binaryOpCode(BinaryExpr *expr) const;
+    OperandTypes operandTypes(const Expr *expr) const;
+};
@@ -1,13 +1,15 @@
 #include "errors.hpp"
 
+#include <cstring>
+
 /**
  * Berate the user because they had an error
  */
-void printAtarMessage() {
-    std::cout << C_RED << "[SCSA] Your ATAR is cooked, -99999 marks." << std::endl
-              << "[SCSA] Congratulations, you are the first student"
-              << " to ever get a negative study score! 😭" << std::endl
-              << "[SCSA] Say goodbye to your future. L + ratio 😂 😂" << C_RESET << std::endl;
+void printAtarMessage(std::ostream &out) {
+    out << C_RED << "[SCSA] Your ATAR is cooked, -99999 marks." << std::endl
+        << "[SCSA] Congratulations, you are the first student"
+        << " to ever get a negative study score! 😭" << std::endl
+        << "[SCSA] Say goodbye to your future. L + ratio 😂 😂" << C_RESET << std::endl;
 }
 
 /**
@@ -17,22 +19,28 @@ void printAtarMessage() {
  * @param stageRef Reference to the current InterpreterStage
  * @param file The source filename being processed
  * @param source The full source code for context generation
+ * @param errors The stream error reports are written to
  */
 ErrorReporter::ErrorReporter(InterpreterStage &stageRef, const std::string &file,
-                             const std::string &source)
-    : stage(stageRef), filename(file) {
-    // Split the source code into lines
-    std::string currentLine;
-    for (char c : source) {
-        if (c == '\n') {
-            lines.push_back(currentLine);
-            currentLine.clear();
-        } else {
-            currentLine += c;
-        }
+                             std::string_view source, std::ostream &errors)
+    : stage(stageRef), filename(file), source(source), stream(&errors) {
+}
+
+/**
+ * Record the offset of every line start
+ * memchr is vectorized by the C library, so this runs far faster than a byte-by-byte loop
+ */
+void ErrorReporter::indexLines() {
+    lineStarts.push_back(0);
+    const char *begin = source.data();
+    const char *end   = begin + source.size();
+    for (const char *at = begin; at < end;) {
+        const char *newline = static_cast<const char *>(std::memchr(at, '\n', end - at));
+        if (!newline)
+            break;
+        lineStarts.push_back(newline + 1 - begin);
+        at = newline + 1;
     }
-    // Add the last line if it's not empty or if source ends with newline
-    lines.push_back(currentLine);
 }
 
 /**
@@ -75,11 +83,16 @@ std::string ErrorReporter::getStageLabel() {
  * @param lineNum The 1-based line number to extract
  * @return The source code line, or empty string if out of range
  */
-std::string ErrorReporter::getSourceLine(size_t lineNum) {
-    if (lines.empty() || lineNum < 1 || lineNum > lines.size()) {
-        return "";
+std::string_view ErrorReporter::getSourceLine(size_t lineNum) {
+    if (lineStarts.empty())
+        indexLines();
+    if (lineNum < 1 || lineNum > lineStarts.size()) {
+        return {};
     }
-    return lines[lineNum - 1];
+    // Every line but the last ends just before the next one's start, at its newline
+    size_t start = lineStarts[lineNum - 1];
+    size_t end   = lineNum < lineStarts.size() ? lineStarts[lineNum] - 1 : source.size();
+    return source.substr(start, end - start);
 }
 
 /**
@@ -98,13 +111,15 @@ std::string ErrorReporter::getSourceLine(size_t lineNum) {
  */
 void ErrorReporter::report(ErrorType type, size_t line, size_t column, const std::string &message,
                            size_t length) {
+    reported = true;
+
     // Print which stage the interpreter is in
     std::string stageLabel = getStageLabel();
-    std::cerr << C_RED << "[An error has occurred during the stage: '" << stageLabel << "']"
-              << std::endl;
+    *stream << C_RED << "[An error has occurred during the stage: '" << stageLabel << "']"
+            << std::endl;
 
     // Get the error line
-    std::string errorLine = getSourceLine(line);
+    std::string_view errorLine = getSourceLine(line);
 
     // Create coordinate string
     std::string lineStr   = std::to_string(line);
@@ -114,8 +129,8 @@ void ErrorReporter::report(ErrorType type, size_t line, size_t column, const std
     // Print filename (Aligned)
     if (!filename.empty()) {
         std::string indent(gutterWidth - 2, ' ');
-        std::cerr << C_BLUE << indent << "┌──[" << filename << ":" << line << ":" << column + 1
-                  << "]" << C_RESET << std::endl;
+        *stream << C_BLUE << indent << "┌──[" << filename << ":" << line << ":" << column + 1
+                << "]" << C_RESET << std::endl;
     }
 
     // Print previous two lines (if they exist)
@@ -124,77 +139,77 @@ void ErrorReporter::report(ErrorType type, size_t line, size_t column, const std
         size_t startContext = (line > 2) ? line - 2 : 1;
 
         for (size_t i = startContext; i < line; i++) {
-            std::string prevLine = getSourceLine(i);
+            std::string_view prevLine = getSourceLine(i);
 
             if (!prevLine.empty()) {
                 std::string prevLineString = std::to_string(i);
-                std::cerr << C_GRAY << prevLineString << C_RESET;
+                *stream << C_GRAY << prevLineString << C_RESET;
 
                 // Pad to match the width of the main error line number
                 for (size_t j = prevLineString.length(); j < lineStr.length(); j++) {
-                    std::cerr << " ";
+                    *stream << " ";
                 }
 
-                std::cerr << C_BLUE << separator << C_RESET << C_GRAY << prevLine << C_RESET
-                          << std::endl;
+                *stream << C_BLUE << separator << C_RESET << C_GRAY << prevLine << C_RESET
+                        << std::endl;
             }
         }
     }
 
     // Print the error line with highlighting
-    std::cerr << C_BLUE << lineStr << separator << C_RESET;
+    *stream << C_BLUE << lineStr << separator << C_RESET;
 
     // Print the line up to the error
-    std::cerr << errorLine.substr(0, column);
+    *stream << errorLine.substr(0, column);
 
     // Print the erroneous token in red
-    std::cerr << C_RED << errorLine.substr(column, length) << C_RESET;
+    *stream << C_RED << errorLine.substr(column, length) << C_RESET;
 
     // Print the rest of the line
     if (column + length < errorLine.length()) {
-        std::cerr << errorLine.substr(column + length);
+        *stream << errorLine.substr(column + length);
     }
-    std::cerr << std::endl;
+    *stream << std::endl;
 
     // Generate the caret alignment on error line
     // Print spaces equal to the width of the gutter
     // Print empty line to seperate
     for (size_t i = 0; i < lineStr.length(); i++) {
-        std::cerr << " ";
+        *stream << " ";
     }
-    std::cerr << C_BLUE << separator << C_RESET;
+    *stream << C_BLUE << separator << C_RESET;
 
     // Account for tab characters inside the source code itself
     for (size_t i = 0; i < column; i++) {
         if (i < errorLine.length() && errorLine[i] == '\t') {
-            std::cerr << '\t';
+            *stream << '\t';
         } else {
-            std::cerr << ' ';
+            *stream << ' ';
         }
     }
 
     // Draw the underline carets
-    std::cerr << C_RED;
+    *stream << C_RED;
     for (size_t i = 0; i < length; i++) {
-        std::cerr << '^';
+        *stream << '^';
     }
 
     // Print error label and message next to the carets
     std::string label = getErrorLabel(type);
-    std::cerr << " " << label << ": " << C_RESET << message << std::endl;
+    *stream << " " << label << ": " << C_RESET << message << std::endl;
 
     // Print line after
-    std::string nextLine = getSourceLine(line + 1);
+    std::string_view nextLine = getSourceLine(line + 1);
     if (!nextLine.empty()) {
         std::string nextLineString = std::to_string(line + 1);
-        std::cerr << C_GRAY << nextLineString << C_RESET;
+        *stream << C_GRAY << nextLineString << C_RESET;
 
         // Pad if necessary (though usually next line number is >= current line number width)
         for (size_t i = nextLineString.length(); i < lineStr.length(); i++) {
-            std::cerr << " ";
+            *stream << " ";
         }
 
-        std::cerr << C_BLUE << separator << C_RESET << C_GRAY << nextLine << C_RESET << std::endl;
+        *stream << C_BLUE << separator << C_RESET << C_GRAY << nextLine << C_RESET << std::endl;
     }
 
     // // Lovely message from our overlords SCSA
@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
 
 // Forward declaration to break circular dependency
@@ -22,8 +23,9 @@ enum class ErrorType {
 
 /**
  * Print an error message from our benevolent overlord SCSA
+ * @param out The stream to print the message to
  */
-void printAtarMessage();
+void printAtarMessage(std::ostream &out = std::cout);
 
 /**
  * ErrorReporter class handles all error reporting and formatting
@@ -35,8 +37,14 @@ private:
     InterpreterStage &stage;
     // Current source file being processed
     std::string filename;
-    // Source code split by lines for O(1) access
-    std::vector<std::string> lines;
+    // Source code errors are shown in; owned by the caller
+    std::string_view source;
+    // Offset where each line of the source starts, built by the first report
+    std::vector<size_t> lineStarts;
+    // Where reports are written; standard error unless a caller captures them
+    std::ostream *stream;
+    // Set once any error has been reported
+    bool reported = false;
 
     /**
      * Get human-readable error type label
@@ -48,22 +56,30 @@ private:
      */
     std::string getStageLabel();
 
+    /**
+     * Find where every line starts, so lines can be looked up in O(1)
+     * Runs on the first report only; most programs never pay for it.
+     */
+    void indexLines();
+
     /**
      * Get a specific line from the source code
      * @param lineNum The 1-based line number to extract
-     * @return The source code line, or empty string if out of range
+     * @return The source code line, or empty if out of range
      */
-    std::string getSourceLine(size_t lineNum);
+    std::string_view getSourceLine(size_t lineNum);
 
 public:
     /**
      * Construct error reporter with reference to current stage, filename, and source code
      * @param stageRef Reference to the interpreter stage
      * @param file The source filename for error context
-     * @param source The full source code for context generation
+     * @param source The full source code for context generation; it is not copied, so it must
+     * outlive the reporter
+     * @param errors The stream error reports are written to
      */
     ErrorReporter(InterpreterStage &stageRef, const std::string &file = "",
-                  const std::string &source = "");
+                  std::string_view source = "", std::ostream &errors = std::cerr);
 
     /**
      * Report an error with full context including surrounding lines
@@ -75,4 +91,11 @@ public:
      */
     void report(ErrorType type, size_t line, size_t column, const std::string &message,
                 size_t length = 1);
+
+    /**
+     * Whether any error has been reported, including ones the parser recovered from
+     */
+    bool hadError() const {
+        return reported;
+    }
 };
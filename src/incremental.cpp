@@ -0,0 +1,333 @@
+#include "incremental.hpp"
+
+#include "errors.hpp"
+#include "lexer.hpp"
+#include "parser.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <sstream>
+
+// --- Line Shifting ---
+
+/**
+ * LineShifter - moves every token in a statement by a number of lines
+ * Applied to the statements after an edit that added or removed lines, so their runtime errors
+ * still point at the right place without re-parsing them.
+ */
+class LineShifter : public ExprVisitor, public StmtVisitor {
+public:
+    explicit LineShifter(int delta) : delta(delta) {
+    }
+
+    void shift(Stmt *stmt) {
+        if (stmt)
+            stmt->accept(*this);
+    }
+
+    // --- ExprVisitor Implementation ---
+    void visitLiteralExpr(LiteralExpr *expr) override {
+        shift(expr->token);
+    }
+    void visitVariableExpr(VariableExpr *expr) override {
+        shift(expr->name);
+    }
+    void visitAssignExpr(AssignExpr *expr) override {
+        shift(expr->target.get());
+        shift(expr->value.get());
+    }
+    void visitBinaryExpr(BinaryExpr *expr) override {
+        shift(expr->left.get());
+        shift(expr->op);
+        shift(expr->right.get());
+    }
+    void visitCallExpr(CallExpr *expr) override {
+        shift(expr->callee.get());
+        shift(expr->args);
+        shift(expr->paren);
+    }
+    void visitGetExpr(GetExpr *expr) override {
+        shift(expr->object.get());
+        shift(expr->name);
+    }
+    void visitArrayAccessExpr(ArrayAccessExpr *expr) override {
+        shift(expr->array.get());
+        shift(expr->index.get());
+        shift(expr->bracket);
+    }
+    void visitArrayLitExpr(ArrayLitExpr *expr) override {
+        shift(expr->elements);
+    }
+    void visitSliceExpr(SliceExpr *expr) override {
+        shift(expr->array.get());
+        shift(expr->start.get());
+        shift(expr->end.get());
+        shift(expr->bracket);
+    }
+    void visitNewExpr(NewExpr *expr) override {
+        shift(expr->className);
+        shift(expr->args);
+    }
+
+    // --- StmtVisitor Implementation ---
+    void visitExpressionStmt(ExpressionStmt *stmt) override {
+        shift(stmt->expression.get());
+    }
+    void visitPrintStmt(PrintStmt *stmt) override {
+        shift(stmt->expression.get());
+    }
+    void visitReturnStmt(ReturnStmt *stmt) override {
+        shift(stmt->value.get());
+    }
+    void visitBlockStmt(BlockStmt *stmt) override {
+        shift(stmt->statements);
+    }
+    void visitIfStmt(IfStmt *stmt) override {
+        shift(stmt->condition.get());
+        shift(stmt->thenBranch);
+        shift(stmt->elseBranch);
+    }
+    void visitWhileStmt(WhileStmt *stmt) override {
+        shift(stmt->keyword);
+        shift(stmt->condition.get());
+        shift(stmt->body);
+    }
+    void visitFunctionStmt(FunctionStmt *stmt) override {
+        shift(stmt->name);
+        for (Token &param : stmt->params)
+            shift(param);
+        shift(stmt->body);
+    }
+    void visitClassStmt(ClassStmt *stmt) override {
+        shift(stmt->name);
+        shift(stmt->superclass);
+        shift(stmt->methods);
+    }
+    void visitForInStmt(ForInStmt *stmt) override {
+        shift(stmt->variable);
+        shift(stmt->iterable.get());
+        shift(stmt->body);
+    }
+
+private:
+    int delta;
+
+    void shift(Token &token) {
+        token.line += delta;
+    }
+    void shift(Expr *expr) {
+        if (expr)
+            expr->accept(*this);
+    }
+    void shift(const std::vector<ExprPtr> &expressions) {
+        for (const auto &expr : expressions)
+            shift(expr.get());
+    }
+    void shift(const std::vector<StmtPtr> &statements) {
+        for (const auto &stmt : statements)
+            shift(stmt.get());
+    }
+};
+
+// --- IncrementalParser ---
+
+IncrementalParser::IncrementalParser(const std::string &file) : filename(file) {
+}
+
+size_t IncrementalParser::segmentAt(size_t offset) const {
+    // The last segment starting at or before 'offset'; text before the first belongs to it
+    auto after = std::upper_bound(
+        segments.begin(), segments.end(), offset,
+        [](size_t value, const Segment &segment) { return value < segment.offset; });
+    return after == segments.begin() ? 0 : (size_t) (after - segments.begin()) - 1;
+}
+
+void IncrementalParser::edit(size_t offset, size_t removed, const std::string &text) {
+    offset  = std::min(offset, buffer.size());
+    removed = std::min(removed, buffer.size() - offset);
+
+    // How far the text after the edit moves, in bytes and in lines
+    long byteDelta = (long) text.size() - (long) removed;
+    int lineDelta  = (int) std::count(text.begin(), text.end(), '\n') -
+                    (int) std::count(buffer.begin() + offset,
+                                     buffer.begin() + offset + removed, '\n');
+    size_t oldEnd = offset + removed;
+    size_t newEnd = offset + text.size();
+    buffer.replace(offset, removed, text);
+
+    // Re-parsing starts at the statement holding the character before the edit, since text
+    // added straight after a statement can extend it (e.g. '+ 1' after 'x = 2'). The parser
+    // looks one token past a statement's end, so in case the edit changed that statement's first
+    // token (e.g. 'IF' into 'IFFY'), the statement before it is always parsed again as well.
+    size_t first = segments.empty() ? 0 : segmentAt(offset == 0 ? 0 : offset - 1);
+    if (first > 0)
+        first--;
+
+    // Old statements parsing may line up with again: they must start after the edit and on a
+    // later line (so their columns are unchanged). If lines moved, none may follow with errors,
+    // whose reports would show the old line numbers.
+    size_t sync = first + 1;
+    while (sync < segments.size() && segments[sync].offset < oldEnd)
+        sync++;
+    while (sync < segments.size() &&
+           !std::memchr(buffer.data() + newEnd, '\n', segments[sync].offset + byteDelta - newEnd))
+        sync++;
+    if (lineDelta != 0) {
+        for (size_t i = segments.size(); i > sync; --i) {
+            if (!segments[i - 1].errors.empty()) {
+                sync = i;
+                break;
+            }
+        }
+    }
+
+    std::ostringstream errors;
+    InterpreterStage stage = InterpreterStage::Lexing;
+    ErrorReporter reporter(stage, filename, buffer, errors);
+
+    // Parse a region ending one old statement past the first sync candidate. If parsing runs
+    // off the end of the region without lining up, retry with a region twice the size.
+    size_t last = sync;
+    std::vector<Segment> parsed;
+    size_t resume;
+    while (true) {
+        size_t begin = first == 0 ? 0 : segments[first].offset;
+        int line     = first == 0 ? 1 : segments[first].line;
+        int column   = first == 0 ? 0 : segments[first].column;
+        size_t end   = last + 1 < segments.size() ? segments[last + 1].offset + byteDelta
+                                                  : buffer.size();
+
+        // A lexer error ends lexing, and with it the program: like a full run, nothing after
+        // it is parsed, so the error's statement takes in the rest of the buffer
+        stage = InterpreterStage::Lexing;
+        std::streampos lexStart = errors.tellp();
+        Lexer lexer(buffer.substr(begin, end - begin), reporter, line, column);
+        std::vector<Token> tokens;
+        try {
+            tokens = lexer.scanTokens();
+        } catch (const std::runtime_error &) {
+            if (end < buffer.size()) {
+                last = segments.size() - 1;
+                continue;
+            }
+            parsed.clear();
+            parsed.push_back({begin, line, column, nullptr, errors.str().substr((size_t) lexStart),
+                              false});
+            resume = segments.size();
+            break;
+        }
+        const std::vector<size_t> &offsets = lexer.tokenOffsets();
+
+        stage = InterpreterStage::Parsing;
+        Parser parser(tokens, buffer, reporter);
+        parser.trace = trace;
+        parsed.clear();
+        resume           = segments.size();
+        size_t candidate = sync;
+        size_t counted   = begin; // Newlines are counted up to here, which is on 'countedLine'
+        int countedLine  = line;
+        while (!parser.done()) {
+            size_t at = begin + offsets[parser.position()];
+            while (candidate < segments.size() && segments[candidate].offset + byteDelta < at)
+                candidate++;
+            if (candidate < segments.size() && segments[candidate].offset + byteDelta == at) {
+                resume = candidate;
+                break;
+            }
+
+            // Tokens carry the line they end on, so a segment's own line is counted instead
+            countedLine += (int) std::count(buffer.begin() + counted, buffer.begin() + at, '\n');
+            counted = at;
+
+            std::streampos reported = errors.tellp();
+            Segment segment{at, countedLine, tokens[parser.position()].column, nullptr, "", false};
+            segment.statement    = parser.parseDeclaration();
+            segment.errors       = errors.str().substr((size_t) reported);
+            segment.unfinished   = parser.unexpectedEnd;
+            parser.unexpectedEnd = false;
+            parsed.push_back(std::move(segment));
+        }
+
+        // Lined up with nothing parsed: the statement before the region may now run on
+        // into the text the edit left behind, so it has to be parsed again too
+        if (resume < segments.size() && parsed.empty() && first > 0) {
+            first--;
+            continue;
+        }
+        // Ran off a region that ends before the buffer does
+        if (resume == segments.size() && end < buffer.size()) {
+            last = std::min(segments.size() - 1, last + 2 * (last - first + 1));
+            continue;
+        }
+
+        break;
+    }
+    lastReparsed = parsed.size();
+
+    // Keep the statements after the region, moved to where the edit left their text
+    LineShifter shifter(lineDelta);
+    for (size_t i = resume; i < segments.size(); ++i) {
+        segments[i].offset += byteDelta;
+        if (lineDelta != 0) {
+            segments[i].line += lineDelta;
+            shifter.shift(segments[i].statement.get());
+        }
+    }
+    segments.erase(segments.begin() + first, segments.begin() + resume);
+    segments.insert(segments.begin() + first, std::make_move_iterator(parsed.begin()),
+                    std::make_move_iterator(parsed.end()));
+}
+
+void IncrementalParser::update(const std::string &source) {
+    size_t prefix = 0;
+    size_t limit  = std::min(source.size(), buffer.size());
+    while (prefix < limit && source[prefix] == buffer[prefix])
+        prefix++;
+    size_t suffix = 0;
+    while (suffix < limit - prefix &&
+           source[source.size() - 1 - suffix] == buffer[buffer.size() - 1 - suffix])
+        suffix++;
+    edit(prefix, buffer.size() - prefix - suffix,
+         source.substr(prefix, source.size() - prefix - suffix));
+}
+
+std::vector<StmtPtr> IncrementalParser::take() {
+    std::vector<StmtPtr> taken;
+    taken.reserve(segments.size());
+    for (auto &segment : segments) {
+        taken.push_back(std::move(segment.statement));
+    }
+    segments.clear();
+    buffer.clear();
+    return taken;
+}
+
+std::vector<Stmt *> IncrementalParser::statements() const {
+    std::vector<Stmt *> result;
+    result.reserve(segments.size());
+    for (const auto &segment : segments) {
+        result.push_back(segment.statement.get());
+    }
+    return result;
+}
+
+std::string IncrementalParser::diagnostics() const {
+    std::string result;
+    for (const auto &segment : segments) {
+        result += segment.errors;
+    }
+    return result;
+}
+
+bool IncrementalParser::hadError() const {
+    for (const auto &segment : segments) {
+        if (!segment.errors.empty())
+            return true;
+    }
+    return false;
+}
+
+bool IncrementalParser::incomplete() const {
+    return !segments.empty() && segments.back().unfinished;
+}
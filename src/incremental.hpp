@@ -0,0 +1,93 @@
+#pragma once
+
+#include "ast.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * IncrementalParser - keeps a program parsed while its text is edited
+ *
+ * The buffer is divided into segments, one per top-level statement, each remembering where its
+ * text starts and the syntax errors found in it. An edit re-lexes and re-parses only from the
+ * segment it touches until parsing lines up with an old segment boundary again; the segments
+ * after that are kept, with their line numbers shifted when the edit added or removed lines.
+ * Used by the REPL to read multi-line blocks, and by editor integrations that re-parse a large
+ * file on every keystroke.
+ */
+class IncrementalParser {
+public:
+    /**
+     * @param file File name shown in error reports
+     */
+    explicit IncrementalParser(const std::string &file = "");
+
+    /**
+     * Replace 'removed' bytes at 'offset' with 'text' and re-parse what the edit affects
+     */
+    void edit(size_t offset, size_t removed, const std::string &text);
+
+    /**
+     * Replace the whole buffer; only the range that differs from the old text is re-parsed
+     */
+    void update(const std::string &source);
+
+    /**
+     * Empty the buffer and return its statements, e.g. once the REPL has run them
+     */
+    std::vector<StmtPtr> take();
+
+    const std::string &source() const {
+        return buffer;
+    }
+
+    /**
+     * The buffer's top-level statements in order; null where a statement failed to parse
+     */
+    std::vector<Stmt *> statements() const;
+
+    /**
+     * Reports of every syntax error in the buffer, in source order
+     * A report is kept from when its statement was parsed, so the neighbouring lines it quotes
+     * for context are not refreshed until that statement is parsed again.
+     */
+    std::string diagnostics() const;
+
+    bool hadError() const;
+
+    /**
+     * Whether the buffer ends part-way through a statement, e.g. a FUNCTION without its END
+     */
+    bool incomplete() const;
+
+    /**
+     * Number of statements parsed by the last edit; the rest were reused
+     */
+    size_t reparsed() const {
+        return lastReparsed;
+    }
+
+    // Stream that parsing functions are traced to, as with Parser::trace
+    std::ostream *trace = nullptr;
+
+private:
+    struct Segment {
+        size_t offset;       // Where the segment's text starts in the buffer
+        int line;            // Line and lexer column at that offset
+        int column;
+        StmtPtr statement;   // May be null after a syntax error
+        std::string errors;  // Reports of the segment's syntax errors
+        bool unfinished;     // Parsing ran out of input part-way through the statement
+    };
+
+    std::string filename;
+    std::string buffer;
+    std::vector<Segment> segments;
+    size_t lastReparsed = 0;
+
+    /**
+     * Index of the segment whose text contains 'offset'
+     */
+    size_t segmentAt(size_t offset) const;
+};
@@ -1,4 +1,58 @@
 #include "interpreter.hpp"
+#include "vm.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+// --- Construction ---
+
+Interpreter::Interpreter(const NativeRegistry &natives) {
+    globals     = std::make_shared<Environment>();
+    environment = globals;
+
+    natives.defineAll(*globals);
+}
+
+// Out of line so VM can stay an incomplete type in the header
+Interpreter::~Interpreter() = default;
+
+void Interpreter::runOnVM(const std::vector<StmtPtr> &statements) {
+    if (!vm)
+        vm = std::make_unique<VM>(*this);
+    vm->run(statements);
+}
+
+RuntimeValue Interpreter::callOnVM(LoxFunction &function, std::vector<RuntimeValue> &arguments) {
+    if (!vm)
+        vm = std::make_unique<VM>(*this);
+    return vm->call(function, arguments);
+}
+
+// --- Execution Limits ---
+
+void Interpreter::startBudget() {
+    if (limits.maxMemory > 0 && !heap)
+        heap = std::make_shared<HeapAccount>(limits.maxMemory);
+    bool timed = limits.maxSteps > 0 || limits.timeout.count() > 0;
+    useBudget(timed ? std::make_shared<ExecutionBudget>(limits) : nullptr);
+}
+
+void Interpreter::useBudget(std::shared_ptr<ExecutionBudget> shared) {
+    budget          = std::move(shared);
+    tickInterval    = budget ? budget->interval() : ExecutionBudget::CHECK_INTERVAL;
+    ticksUntilCheck = tickInterval;
+}
+
+/**
+ * Report the steps taken since the last check to the budget, which throws once a limit is passed
+ * @param where The token a limit error is reported at
+ */
+void Interpreter::checkLimits(const Token &where) {
+    if (budget)
+        tickInterval = budget->spend(tickInterval, where);
+    ticksUntilCheck = tickInterval;
+}
 
 // --- Helper Functions ---
 
@@ -21,18 +75,7 @@ bool Interpreter::isTruthy(const RuntimeValue &object) {
 }
 
 bool Interpreter::isEqual(const RuntimeValue &a, const RuntimeValue &b) {
-    // Rely on variant equality operators or implement specific logic
-    if (a.value.index() != b.value.index())
-        return false;
-    if (a.is<std::monostate>())
-        return true;
-    if (a.is<double>())
-        return a.as<double>() == b.as<double>();
-    if (a.is<bool>())
-        return a.as<bool>() == b.as<bool>();
-    if (a.is<std::string>())
-        return a.as<std::string>() == b.as<std::string>();
-    return false; // For objects/arrays, this implies reference equality checks usually
+    return valuesEqual(a, b);
 }
 
 void Interpreter::checkNumberOperand(const Token &operatorToken, const RuntimeValue &operand) {
@@ -48,6 +91,18 @@ void Interpreter::checkNumberOperands(const Token &operatorToken, const RuntimeV
     throw RuntimeError(operatorToken, "Operands must be numbers.");
 }
 
+void Interpreter::checkArgumentCount(const Token &paren, Callable &callee, size_t count) {
+    int maxArgs = callee.arity();
+    int minArgs = callee.minArity();
+    if ((int) count < minArgs || (int) count > maxArgs) {
+        std::string expected = std::to_string(maxArgs);
+        if (minArgs != maxArgs)
+            expected = std::to_string(minArgs) + " to " + expected;
+        throw RuntimeError(paren, "Expected " + expected + " arguments but got " +
+                                      std::to_string(count) + ".");
+    }
+}
+
 void Interpreter::executeBlock(const std::vector<StmtPtr> &statements,
                                std::shared_ptr<Environment> env) {
     std::shared_ptr<Environment> previous = this->environment;
@@ -64,6 +119,352 @@ void Interpreter::executeBlock(const std::vector<StmtPtr> &statements,
     this->environment = previous;
 }
 
+// --- Native List Methods ---
+
+// Whether a number can be used as a list position: finite, with no fractional part
+static bool isWholeNumber(double value) {
+    return std::isfinite(value) && std::trunc(value) == value;
+}
+
+// Convert an index argument to a position in [0, upper], reporting bad indices at 'token'
+static size_t checkIndex(const Token &token, const RuntimeValue &index, size_t upper) {
+    if (!index.is<double>()) {
+        throw RuntimeError(token, "List index must be a number.");
+    }
+    double position = index.as<double>();
+    if (!isWholeNumber(position)) {
+        throw RuntimeError(token, "List index must be a whole number.");
+    }
+    if (position < 0 || position > (double) upper) {
+        throw RuntimeError(token, "List index out of bounds.");
+    }
+    return (size_t) position;
+}
+
+static void checkArity(const Token &name, size_t expected, size_t got) {
+    if (got != expected) {
+        throw RuntimeError(name, "Expected " + std::to_string(expected) + " arguments but got " +
+                                     std::to_string(got) + ".");
+    }
+}
+
+RuntimeValue Interpreter::callArrayMethod(Array &array, const Token &name,
+                                          std::vector<RuntimeValue> &arguments) {
+    // Every list method modifies the list
+    if (array.isFrozen()) {
+        throw RuntimeError(name, "Cannot modify a shared list inside a PARALLEL FOR loop.");
+    }
+    if (name.lexeme == "append") {
+        // Storage grows geometrically, so appending is amortized O(1)
+        checkArity(name, 1, arguments.size());
+        try {
+            array.push(std::move(arguments[0]));
+        } catch (const NativeError &error) {
+            throw RuntimeError(name, error.what()); // Over the memory limit
+        }
+        return {std::monostate{}};
+    }
+    if (name.lexeme == "insert") {
+        checkArity(name, 2, arguments.size());
+        size_t index = checkIndex(name, arguments[0], array.size());
+        try {
+            array.insert(index, std::move(arguments[1]));
+        } catch (const NativeError &error) {
+            throw RuntimeError(name, error.what());
+        }
+        return {std::monostate{}};
+    }
+    if (name.lexeme == "pop") {
+        checkArity(name, 0, arguments.size());
+        if (array.size() == 0) {
+            throw RuntimeError(name, "Cannot pop from an empty list.");
+        }
+        return array.pop();
+    }
+    if (name.lexeme == "remove") {
+        checkArity(name, 1, arguments.size());
+        if (array.size() == 0) {
+            throw RuntimeError(name, "Cannot remove from an empty list.");
+        }
+        size_t index = checkIndex(name, arguments[0], array.size() - 1);
+        return array.erase(index);
+    }
+    throw RuntimeError(name, "Undefined list method '" + name.lexeme + "'.");
+}
+
+// --- Native Set and Dictionary Methods ---
+
+RuntimeValue Interpreter::callSetMethod(Set &set, const Token &name,
+                                        std::vector<RuntimeValue> &arguments) {
+    try {
+        if (name.lexeme == "add") {
+            checkArity(name, 1, arguments.size());
+            return {set.add(arguments[0])};
+        }
+        if (name.lexeme == "remove") {
+            checkArity(name, 1, arguments.size());
+            return {set.remove(arguments[0])};
+        }
+    } catch (const NativeError &error) {
+        throw RuntimeError(name, error.what()); // Unhashable, frozen or over the memory limit
+    }
+    throw RuntimeError(name, "Undefined set method '" + name.lexeme + "'.");
+}
+
+RuntimeValue Interpreter::callDictionaryMethod(Dictionary &dictionary, const Token &name,
+                                               std::vector<RuntimeValue> &arguments) {
+    try {
+        if (name.lexeme == "remove") {
+            checkArity(name, 1, arguments.size());
+            RuntimeValue removed;
+            if (!dictionary.remove(arguments[0], removed)) {
+                throw RuntimeError(name, "Key " + stringify(arguments[0]) +
+                                             " is not in the dictionary.");
+            }
+            return removed;
+        }
+        if (name.lexeme == "keys") {
+            checkArity(name, 0, arguments.size());
+            return {dictionary.keys()};
+        }
+        if (name.lexeme == "values") {
+            checkArity(name, 0, arguments.size());
+            return {dictionary.values()};
+        }
+    } catch (const NativeError &error) {
+        throw RuntimeError(name, error.what());
+    }
+    throw RuntimeError(name, "Undefined dictionary method '" + name.lexeme + "'.");
+}
+
+RuntimeValue Interpreter::callNativeMethod(const RuntimeValue &receiver, const Token &name,
+                                           std::vector<RuntimeValue> &arguments) {
+    if (receiver.is<SetPtr>())
+        return callSetMethod(*receiver.as<SetPtr>(), name, arguments);
+    if (receiver.is<DictionaryPtr>())
+        return callDictionaryMethod(*receiver.as<DictionaryPtr>(), name, arguments);
+    return callArrayMethod(*receiver.as<ArrayPtr>(), name, arguments);
+}
+
+ArrayPtr Interpreter::iterationList(const Token &variable, const RuntimeValue &iterable) {
+    try {
+        if (iterable.is<ArrayPtr>())
+            return iterable.as<ArrayPtr>();
+        if (iterable.is<SetPtr>())
+            return iterable.as<SetPtr>()->keys();
+        if (iterable.is<DictionaryPtr>())
+            return iterable.as<DictionaryPtr>()->keys();
+    } catch (const NativeError &error) {
+        throw RuntimeError(variable, error.what()); // Snapshot over the memory limit
+    }
+    throw RuntimeError(variable, "For-in loop requires a list, set or dictionary.");
+}
+
+/**
+ * The 'IN' operator: membership in a list, set or dictionary (by key), or a substring test
+ * Sets and dictionaries answer in O(1); lists are searched in order.
+ */
+bool Interpreter::contains(const Token &op, const RuntimeValue &collection,
+                           const RuntimeValue &element) {
+    if (collection.is<SetPtr>())
+        return collection.as<SetPtr>()->contains(element);
+    if (collection.is<DictionaryPtr>())
+        return collection.as<DictionaryPtr>()->contains(element);
+    if (collection.is<ArrayPtr>()) {
+        const Array &list = *collection.as<ArrayPtr>();
+        if (list.kind() == Array::Kind::Number) {
+            // Packed numbers can only match a number
+            if (!element.is<double>())
+                return false;
+            const std::vector<double> &numbers = list.numbers();
+            return std::find(numbers.begin(), numbers.end(), element.as<double>()) !=
+                   numbers.end();
+        }
+        for (size_t i = 0; i < list.size(); ++i) {
+            if (isEqual(list.get(i), element))
+                return true;
+        }
+        return false;
+    }
+    if (collection.is<std::string>()) {
+        if (!element.is<std::string>())
+            throw RuntimeError(op, "Only a string can be looked for in a string.");
+        return collection.as<std::string>().find(element.as<std::string>()) != std::string::npos;
+    }
+    throw RuntimeError(op, "Right operand of 'IN' must be a list, set, dictionary or string.");
+}
+
+// --- Shared Operations ---
+// The language semantics of each operator, used by both the tree walker and the stack VM
+
+RuntimeValue Interpreter::binaryOp(const Token &op, const RuntimeValue &left,
+                                   const RuntimeValue &right) {
+    switch (op.type) {
+    case TOK_GREATER_THAN:
+        checkNumberOperands(op, left, right);
+        return {left.as<double>() > right.as<double>()};
+    case TOK_GT_OR_EQ:
+        checkNumberOperands(op, left, right);
+        return {left.as<double>() >= right.as<double>()};
+    case TOK_LESS_THAN:
+        checkNumberOperands(op, left, right);
+        return {left.as<double>() < right.as<double>()};
+    case TOK_LT_OR_EQ:
+        checkNumberOperands(op, left, right);
+        return {left.as<double>() <= right.as<double>()};
+    case TOK_MINUS:
+        checkNumberOperands(op, left, right);
+        return {left.as<double>() - right.as<double>()};
+    case TOK_DIVIDE:
+        checkNumberOperands(op, left, right);
+        if (right.as<double>() == 0)
+            throw RuntimeError(op, "Division by zero.");
+        return {left.as<double>() / right.as<double>()};
+    case TOK_MULTIPLY:
+        checkNumberOperands(op, left, right);
+        return {left.as<double>() * right.as<double>()};
+    case TOK_PLUS:
+        if (left.is<double>() && right.is<double>()) {
+            return {left.as<double>() + right.as<double>()};
+        } else if (left.is<std::string>() && right.is<std::string>()) {
+            if (const auto &heap = HeapAccount::current())
+                heap->require(left.as<std::string>().size() + right.as<std::string>().size(), op);
+            return {left.as<std::string>() + right.as<std::string>()};
+        }
+        throw RuntimeError(op, "Operands must be two numbers or two strings.");
+    case TOK_EQUAL:
+        return {isEqual(left, right)};
+    case TOK_IN:
+        return {contains(op, right, left)};
+    default:
+        throw RuntimeError(op, "Operator '" + op.lexeme + "' is not supported yet.");
+    }
+}
+
+RuntimeValue Interpreter::getIndex(const Token &bracket, const RuntimeValue &array,
+                                   const RuntimeValue &index) {
+    if (array.is<DictionaryPtr>()) {
+        const RuntimeValue *value = array.as<DictionaryPtr>()->get(index);
+        if (!value) {
+            throw RuntimeError(bracket, "Key " + stringify(index) + " is not in the dictionary.");
+        }
+        return *value;
+    }
+    if (!array.is<ArrayPtr>()) {
+        throw RuntimeError(bracket, "Operand not an array.");
+    }
+
+    auto vec = array.as<ArrayPtr>();
+    if (vec->size() == 0) {
+        throw RuntimeError(bracket, "List index out of bounds.");
+    }
+    return vec->get(checkIndex(bracket, index, vec->size() - 1));
+}
+
+void Interpreter::setIndex(const Token &bracket, const RuntimeValue &array,
+                           const RuntimeValue &index, RuntimeValue value) {
+    if (array.is<DictionaryPtr>()) {
+        try {
+            array.as<DictionaryPtr>()->set(index, std::move(value));
+        } catch (const NativeError &error) {
+            // Unhashable, frozen or over the memory limit
+            throw RuntimeError(bracket, error.what());
+        }
+        return;
+    }
+    if (!array.is<ArrayPtr>()) {
+        throw RuntimeError(bracket, "Cannot assign to non-array subscript.");
+    }
+
+    auto vec = array.as<ArrayPtr>();
+    if (vec->size() == 0) {
+        throw RuntimeError(bracket, "List index out of bounds.");
+    }
+    size_t position = checkIndex(bracket, index, vec->size() - 1);
+    try {
+        vec->set(position, std::move(value));
+    } catch (const NativeError &error) {
+        throw RuntimeError(bracket, error.what()); // Frozen or over the memory limit
+    }
+}
+
+RuntimeValue Interpreter::sliceArray(const Token &bracket, const RuntimeValue &array,
+                                     const RuntimeValue *start, const RuntimeValue *end) {
+    if (!array.is<ArrayPtr>()) {
+        throw RuntimeError(bracket, "Only lists can be sliced.");
+    }
+    auto vec = array.as<ArrayPtr>();
+
+    // Bounds are clamped to the list, so out-of-range slices are simply shorter
+    size_t from = 0;
+    size_t to   = vec->size();
+    if (start) {
+        if (!start->is<double>() || !isWholeNumber(start->as<double>()))
+            throw RuntimeError(bracket, "Slice bounds must be whole numbers.");
+        from = (size_t) std::clamp(start->as<double>(), 0.0, (double) vec->size());
+    }
+    if (end) {
+        if (!end->is<double>() || !isWholeNumber(end->as<double>()))
+            throw RuntimeError(bracket, "Slice bounds must be whole numbers.");
+        to = (size_t) std::clamp(end->as<double>(), 0.0, (double) vec->size());
+    }
+    if (to < from)
+        to = from;
+
+    try {
+        return {vec->slice(from, to)};
+    } catch (const NativeError &error) {
+        throw RuntimeError(bracket, error.what());
+    }
+}
+
+void Interpreter::setProperty(const RuntimeValue &object, const Token &name, RuntimeValue value) {
+    if (!object.is<std::shared_ptr<Instance>>()) {
+        throw RuntimeError(name, "Only instances have fields.");
+    }
+    object.as<std::shared_ptr<Instance>>()->set(name, std::move(value));
+}
+
+void Interpreter::printValue(const RuntimeValue &value) {
+    *output << stringify(value) << std::endl;
+}
+
+RuntimeValue Interpreter::getProperty(const RuntimeValue &object, const Token &name) {
+    if (object.is<std::shared_ptr<Instance>>()) {
+        return object.as<std::shared_ptr<Instance>>()->get(name);
+    }
+    if (object.is<ArrayPtr>()) {
+        auto vec = object.as<ArrayPtr>();
+        if (name.lexeme == "length") {
+            return {(double) vec->size()};
+        }
+        if (name.lexeme == "append" || name.lexeme == "insert" || name.lexeme == "pop" ||
+            name.lexeme == "remove") {
+            return {std::make_shared<CollectionMethod>(object, name)};
+        }
+        throw RuntimeError(name, "Undefined list property '" + name.lexeme + "'.");
+    }
+    if (object.is<SetPtr>()) {
+        if (name.lexeme == "length") {
+            return {(double) object.as<SetPtr>()->size()};
+        }
+        if (name.lexeme == "add" || name.lexeme == "remove") {
+            return {std::make_shared<CollectionMethod>(object, name)};
+        }
+        throw RuntimeError(name, "Undefined set property '" + name.lexeme + "'.");
+    }
+    if (object.is<DictionaryPtr>()) {
+        if (name.lexeme == "length") {
+            return {(double) object.as<DictionaryPtr>()->size()};
+        }
+        if (name.lexeme == "remove" || name.lexeme == "keys" || name.lexeme == "values") {
+            return {std::make_shared<CollectionMethod>(object, name)};
+        }
+        throw RuntimeError(name, "Undefined dictionary property '" + name.lexeme + "'.");
+    }
+    throw RuntimeError(name, "Only instances have properties.");
+}
+
 // --- ExprVisitor Implementation ---
 
 void Interpreter::visitLiteralExpr(LiteralExpr *expr) {
@@ -96,42 +497,21 @@ void Interpreter::visitAssignExpr(AssignExpr *expr) {
 
     // Check if target is a simple variable
     if (auto varExpr = dynamic_cast<VariableExpr *>(expr->target.get())) {
-        try {
-            environment->assign(varExpr->name, value);
-        } catch (const RuntimeError &) {
-            // Variable doesn't exist, define it
-            environment->define(varExpr->name.lexeme, value);
+        // Variable doesn't exist yet, define it in the current scope
+        if (!environment->assignExisting(varExpr->name, value)) {
+            environment->define(varExpr->name, value);
         }
     }
     // Check if target is a property set (object.prop = val)
     else if (auto getExpr = dynamic_cast<GetExpr *>(expr->target.get())) {
         RuntimeValue object = evaluate(getExpr->object.get());
-        if (object.is<std::shared_ptr<Instance>>()) {
-            object.as<std::shared_ptr<Instance>>()->set(getExpr->name, value);
-        } else {
-            throw RuntimeError(getExpr->name, "Only instances have fields.");
-        }
+        setProperty(object, getExpr->name, value);
     }
     // Check if target is array index (arr[i] = val)
     else if (auto arrExpr = dynamic_cast<ArrayAccessExpr *>(expr->target.get())) {
         RuntimeValue arrVal = evaluate(arrExpr->array.get());
         RuntimeValue idxVal = evaluate(arrExpr->index.get());
-
-        if (!arrVal.is<std::shared_ptr<std::vector<RuntimeValue>>>()) {
-            // We need a token for error reporting, simplified here
-            throw std::runtime_error("Cannot assign to non-array subscript.");
-        }
-        if (!idxVal.is<double>()) {
-            throw std::runtime_error("Array index must be a number.");
-        }
-
-        auto vec  = arrVal.as<std::shared_ptr<std::vector<RuntimeValue>>>();
-        int index = (int) idxVal.as<double>();
-
-        if (index < 0 || index >= (int) vec->size()) {
-            throw std::runtime_error("Array index out of bounds.");
-        }
-        (*vec)[index] = value;
+        setIndex(arrExpr->bracket, arrVal, idxVal, value);
     } else {
         throw std::runtime_error("Invalid assignment target.");
     }
@@ -142,108 +522,97 @@ void Interpreter::visitAssignExpr(AssignExpr *expr) {
 void Interpreter::visitBinaryExpr(BinaryExpr *expr) {
     RuntimeValue left  = evaluate(expr->left.get());
     RuntimeValue right = evaluate(expr->right.get());
+    result             = binaryOp(expr->op, left, right);
+}
 
-    switch (expr->op.type) {
-    case TOK_GREATER_THAN:
-        checkNumberOperands(expr->op, left, right);
-        result = {left.as<double>() > right.as<double>()};
-        break;
-    case TOK_LESS_THAN:
-        checkNumberOperands(expr->op, left, right);
-        result = {left.as<double>() < right.as<double>()};
-        break;
-    case TOK_MINUS:
-        checkNumberOperands(expr->op, left, right);
-        result = {left.as<double>() - right.as<double>()};
-        break;
-    case TOK_DIVIDE:
-        checkNumberOperands(expr->op, left, right);
-        if (right.as<double>() == 0)
-            throw RuntimeError(expr->op, "Division by zero.");
-        result = {left.as<double>() / right.as<double>()};
-        break;
-    case TOK_MULTIPLY:
-        checkNumberOperands(expr->op, left, right);
-        result = {left.as<double>() * right.as<double>()};
-        break;
-    case TOK_PLUS:
-        if (left.is<double>() && right.is<double>()) {
-            result = {left.as<double>() + right.as<double>()};
-        } else if (left.is<std::string>() && right.is<std::string>()) {
-            result = {left.as<std::string>() + right.as<std::string>()};
-        } else {
-            throw RuntimeError(expr->op, "Operands must be two numbers or two strings.");
+void Interpreter::visitCallExpr(CallExpr *expr) {
+    RuntimeValue callee;
+    if (auto getExpr = dynamic_cast<GetExpr *>(expr->callee.get())) {
+        // Method call: list, set and dictionary methods are dispatched directly on the receiver
+        RuntimeValue object = evaluate(getExpr->object.get());
+        if (hasNativeMethods(object)) {
+            std::vector<RuntimeValue> args;
+            for (const auto &arg : expr->args) {
+                args.push_back(evaluate(arg.get()));
+            }
+            result = callNativeMethod(object, getExpr->name, args);
+            return;
         }
-        break;
-    case TOK_EQUAL:
-        result = {isEqual(left, right)};
-        break;
-    default:
-        break;
+        callee = getProperty(object, getExpr->name);
+    } else {
+        callee = evaluate(expr->callee.get());
     }
+    finishCall(expr, callee);
 }
 
-void Interpreter::visitCallExpr(CallExpr *expr) {
-    RuntimeValue callee = evaluate(expr->callee.get());
+void Interpreter::finishCall(CallExpr *expr, const RuntimeValue &callee) {
+    if (!callee.is<std::shared_ptr<Callable>>()) {
+        throw RuntimeError(expr->paren, "Can only call functions and classes.");
+    }
+    auto function = callee.as<std::shared_ptr<Callable>>();
+
+    // Natives read their arguments straight out of a small on-stack buffer
+    constexpr size_t INLINE_ARGS = 8;
+    auto native                  = dynamic_cast<NativeFunction *>(function.get());
+    if (native && expr->args.size() <= INLINE_ARGS) {
+        std::array<RuntimeValue, INLINE_ARGS> buffer;
+        for (size_t i = 0; i < expr->args.size(); ++i) {
+            buffer[i] = evaluate(expr->args[i].get());
+        }
+        checkArgumentCount(expr->paren, *function, expr->args.size());
+        try {
+            result = native->invoke(*this, ArgSpan(buffer.data(), expr->args.size()));
+        } catch (const NativeError &error) {
+            throw RuntimeError(expr->paren, error.what());
+        }
+        return;
+    }
 
     std::vector<RuntimeValue> args;
+    args.reserve(expr->args.size());
     for (const auto &arg : expr->args) {
         args.push_back(evaluate(arg.get()));
     }
+    checkArgumentCount(expr->paren, *function, args.size());
 
-    if (!callee.is<std::shared_ptr<Callable>>()) {
-        // Can't locate token easily from CallExpr without storing it,
-        // assuming callee expression has location info or throw generic
-        throw std::runtime_error("Can only call functions and classes.");
-    }
-
-    auto function = callee.as<std::shared_ptr<Callable>>();
-    if ((int) args.size() != function->arity()) {
-        throw std::runtime_error("Expected " + std::to_string(function->arity()) +
-                                 " arguments but got " + std::to_string(args.size()) + ".");
+    try {
+        result = function->call(*this, std::move(args));
+    } catch (const NativeError &error) {
+        throw RuntimeError(expr->paren, error.what());
     }
-
-    result = function->call(*this, args);
 }
 
 void Interpreter::visitGetExpr(GetExpr *expr) {
     RuntimeValue object = evaluate(expr->object.get());
-    if (object.is<std::shared_ptr<Instance>>()) {
-        result = object.as<std::shared_ptr<Instance>>()->get(expr->name);
-        return;
-    }
-    throw RuntimeError(expr->name, "Only instances have properties.");
+    result              = getProperty(object, expr->name);
 }
 
 void Interpreter::visitArrayAccessExpr(ArrayAccessExpr *expr) {
     RuntimeValue arr = evaluate(expr->array.get());
     RuntimeValue idx = evaluate(expr->index.get());
-
-    if (!arr.is<std::shared_ptr<std::vector<RuntimeValue>>>()) {
-        throw std::runtime_error("Operand not an array.");
-    }
-    if (!idx.is<double>()) {
-        throw std::runtime_error("Index must be a number.");
-    }
-
-    auto vec  = arr.as<std::shared_ptr<std::vector<RuntimeValue>>>();
-    int index = (int) idx.as<double>();
-
-    if (index < 0 || index >= (int) vec->size()) {
-        throw std::runtime_error("Index out of bounds.");
-    }
-
-    result = (*vec)[index];
+    result           = getIndex(expr->bracket, arr, idx);
 }
 
 void Interpreter::visitArrayLitExpr(ArrayLitExpr *expr) {
-    auto vec = std::make_shared<std::vector<RuntimeValue>>();
+    auto vec = std::make_shared<Array>();
+    vec->reserve(expr->elements.size());
     for (const auto &el : expr->elements) {
-        vec->push_back(evaluate(el.get()));
+        vec->push(evaluate(el.get()));
     }
     result = {vec};
 }
 
+void Interpreter::visitSliceExpr(SliceExpr *expr) {
+    RuntimeValue arr = evaluate(expr->array.get());
+    RuntimeValue start, end;
+    if (expr->start)
+        start = evaluate(expr->start.get());
+    if (expr->end)
+        end = evaluate(expr->end.get());
+    result = sliceArray(expr->bracket, arr, expr->start ? &start : nullptr,
+                        expr->end ? &end : nullptr);
+}
+
 void Interpreter::visitNewExpr(NewExpr *expr) {
     // Look up class
     RuntimeValue klassVal = environment->get(expr->className);
@@ -269,10 +638,31 @@ void Interpreter::visitExpressionStmt(ExpressionStmt *stmt) {
 
 void Interpreter::visitPrintStmt(PrintStmt *stmt) {
     RuntimeValue val = evaluate(stmt->expression.get());
-    std::cout << stringify(val) << std::endl;
+    printValue(val);
 }
 
 void Interpreter::visitReturnStmt(ReturnStmt *stmt) {
+    // 'RETURN f(...)' inside a function: hand the call back to the running LoxFunction,
+    // which reuses its frame instead of nesting a new one
+    auto call = dynamic_cast<CallExpr *>(stmt->value.get());
+    if (call && callDepth > 0 && !dynamic_cast<GetExpr *>(call->callee.get())) {
+        RuntimeValue callee = evaluate(call->callee.get());
+        if (callee.is<std::shared_ptr<Callable>>() &&
+            dynamic_cast<LoxFunction *>(callee.as<std::shared_ptr<Callable>>().get())) {
+            auto function = callee.as<std::shared_ptr<Callable>>();
+            std::vector<RuntimeValue> args;
+            args.reserve(call->args.size());
+            for (const auto &arg : call->args) {
+                args.push_back(evaluate(arg.get()));
+            }
+            checkArgumentCount(call->paren, *function, args.size());
+            throw TailCallException(std::move(function), std::move(args));
+        }
+        // Not a user function: finish the call here, without evaluating the callee twice
+        finishCall(call, callee);
+        throw ReturnException(result);
+    }
+
     RuntimeValue value = {std::monostate{}};
     if (stmt->value) {
         value = evaluate(stmt->value.get());
@@ -296,6 +686,7 @@ void Interpreter::visitIfStmt(IfStmt *stmt) {
 
 void Interpreter::visitWhileStmt(WhileStmt *stmt) {
     while (isTruthy(evaluate(stmt->condition.get()))) {
+        tick(stmt->keyword);
         for (const auto &s : stmt->body)
             execute(s.get());
     }
@@ -303,18 +694,20 @@ void Interpreter::visitWhileStmt(WhileStmt *stmt) {
 
 void Interpreter::visitForInStmt(ForInStmt *stmt) {
     RuntimeValue iterable = evaluate(stmt->iterable.get());
+    ArrayPtr vec          = iterationList(stmt->variable, iterable);
 
-    if (!iterable.is<std::shared_ptr<std::vector<RuntimeValue>>>()) {
-        throw RuntimeError(stmt->variable, "For-in loop requires an array.");
+    // Loops nested inside a parallel iteration already run on a worker, so they stay sequential
+    if (stmt->parallel && !parallelWorker) {
+        runParallelForIn(stmt, vec);
+        return;
     }
 
-    auto vec = iterable.as<std::shared_ptr<std::vector<RuntimeValue>>>();
-
-    // Iterate through C++ vector
-    for (const auto &val : *vec) {
+    // Iterate by position so the body may safely append to the list
+    for (size_t i = 0; i < vec->size(); ++i) {
+        tick(stmt->variable);
         // Create a new scope for the loop variable
         auto loopEnv = std::make_shared<Environment>(environment);
-        loopEnv->define(stmt->variable.lexeme, val);
+        loopEnv->define(stmt->variable, vec->get(i));
 
         executeBlock(stmt->body, loopEnv);
     }
@@ -323,37 +716,61 @@ void Interpreter::visitForInStmt(ForInStmt *stmt) {
 // --- Function & Class Definitions ---
 
 // User Defined Function Implementation
-class LoxFunction : public Callable {
-    FunctionStmt *declaration;
-    std::shared_ptr<Environment> closure;
+int LoxFunction::arity() {
+    return declaration->params.size();
+}
 
-public:
-    LoxFunction(FunctionStmt *decl, std::shared_ptr<Environment> closure)
-        : declaration(decl), closure(closure) {
+RuntimeValue LoxFunction::call(Interpreter &interpreter, std::vector<RuntimeValue> arguments) {
+    RuntimeValue native;
+    if (callNative(interpreter, arguments.data(), native))
+        return native;
+    if (interpreter.useVM) {
+        return interpreter.callOnVM(*this, arguments);
     }
 
-    int arity() override {
-        return declaration->params.size();
+    MemoKey memoKey;
+    bool memoize = interpreter.memo &&
+                   interpreter.memo->prepare(*this, arguments.data(), arguments.size(), memoKey);
+    if (memoize) {
+        if (const RuntimeValue *cached = interpreter.memo->find(memoKey))
+            return *cached;
     }
 
-    RuntimeValue call(Interpreter &interpreter, std::vector<RuntimeValue> arguments) override {
-        auto environment = std::make_shared<Environment>(closure);
-        for (size_t i = 0; i < declaration->params.size(); ++i) {
-            environment->define(declaration->params[i].lexeme, arguments[i]);
+    CallDepthGuard depth(interpreter, declaration->name);
+
+    // Tail calls replace the running function and its arguments, then loop, so
+    // 'RETURN f(...)' chains run in constant native stack space
+    LoxFunction *function = this;
+    std::shared_ptr<Callable> tailTarget;
+    RuntimeValue result = {std::monostate{}};
+    while (true) {
+        interpreter.tick(function->declaration->name);
+        auto environment = std::make_shared<Environment>(function->closure);
+        for (size_t i = 0; i < function->declaration->params.size(); ++i) {
+            environment->define(function->declaration->params[i], std::move(arguments[i]));
         }
 
         try {
-            interpreter.executeBlock(declaration->body, environment);
-        } catch (const ReturnException &returnValue) {
-            return returnValue.value;
+            interpreter.executeBlock(function->declaration->body, environment);
+        } catch (ReturnException &returnValue) {
+            result = returnValue.value;
+        } catch (TailCallException &tailCall) {
+            tailTarget = std::move(tailCall.function);
+            function   = static_cast<LoxFunction *>(tailTarget.get());
+            arguments  = std::move(tailCall.arguments);
+            continue;
         }
-        return {std::monostate{}};
+        break;
     }
 
-    std::string toString() override {
-        return "<fn " + declaration->name.lexeme + ">";
-    }
-};
+    if (memoize)
+        interpreter.memo->store(std::move(memoKey), result);
+    return result;
+}
+
+std::string LoxFunction::toString() {
+    return "<fn " + declaration->name.lexeme + ">";
+}
 
 void Interpreter::visitFunctionStmt(FunctionStmt *stmt) {
     auto function = std::make_shared<LoxFunction>(stmt, environment);
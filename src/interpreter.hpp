@@ -1,37 +1,143 @@
 #pragma once
 
 #include "ast.hpp"
+#include "builtins.hpp"
 #include "errors.hpp"
+#include "jit.hpp"
+#include "limits.hpp"
+#include "memo.hpp"
 #include "runtime.hpp"
 #include <memory>
 #include <vector>
 
+class LoxFunction;
+class VM;
+
 class Interpreter : public ExprVisitor, public StmtVisitor {
 public:
     std::shared_ptr<Environment> globals;
     std::shared_ptr<Environment> environment;
 
-    Interpreter() {
-        globals     = std::make_shared<Environment>();
-        environment = globals;
+    // Number of pseudocode function calls currently active (tail calls don't add to it)
+    int callDepth = 0;
+    // Calls nested deeper than this raise a RuntimeError instead of overflowing the native stack
+    int maxCallDepth = 1000;
+    // Run programs on the stack VM, whose frames live on the heap, instead of the tree walker
+    bool useVM = false;
+    // Compile hot numeric functions to native code (see jit.hpp)
+    bool useJit = true;
+    // Cache of pure function results; null unless memoization is enabled
+    std::unique_ptr<MemoCache> memo;
+    // Where PRINT writes; each PARALLEL FOR iteration writes to its own buffer
+    std::ostream *output = &std::cout;
+    // Where uncaught runtime errors are reported
+    std::ostream *errorOutput = &std::cerr;
+    // Set on the interpreters running PARALLEL FOR iterations, whose nested loops stay sequential
+    bool parallelWorker = false;
+    // Caps on steps and time for each call to interpret(), and on live memory; none by default
+    ExecutionLimits limits;
+    // What the current run has left of its step and time limits; null when neither is set
+    std::shared_ptr<ExecutionBudget> budget;
+    // Memory held by this program's lists, objects and strings; null unless limits.maxMemory is set
+    std::shared_ptr<HeapAccount> heap;
 
-        // Define native functions (e.g., clock, print) in globals here if needed
-    }
+    /**
+     * Create an interpreter whose global scope holds every function in 'natives'
+     * @param natives Registry of C++ builtins; the standard library by default
+     */
+    Interpreter(const NativeRegistry &natives = NativeRegistry::standard());
+    ~Interpreter();
 
-    void interpret(const std::vector<StmtPtr> &statements) {
+    /**
+     * Run top-level statements, reporting a runtime error to errorOutput
+     * @return false if the program stopped on a runtime error
+     */
+    bool interpret(const std::vector<StmtPtr> &statements) {
         try {
+            startBudget();
+            HeapAccount::Scope heapScope(heap);
+            if (useVM) {
+                runOnVM(statements);
+                return true;
+            }
             for (const auto &stmt : statements) {
                 execute(stmt.get());
             }
         } catch (const RuntimeError &error) {
-            std::cerr << "[Runtime Error] " << error.what() << "\n[Line " << error.token.line << "]"
-                      << std::endl;
+            *errorOutput << "[Runtime Error] " << error.what() << "\n[Line " << error.token.line
+                         << "]" << std::endl;
+            return false;
+        } catch (const NativeError &error) {
+            // Raised where no token is at hand, e.g. building a list literal past the memory limit
+            *errorOutput << "[Runtime Error] " << error.what() << std::endl;
+            return false;
         }
+        return true;
+    }
+
+    /**
+     * Count one step (a loop iteration or a call); the limits are checked every few hundred
+     * @param where The token a limit error is reported at
+     */
+    void tick(const Token &where) {
+        if (--ticksUntilCheck == 0)
+            checkLimits(where);
     }
 
+    // Steps left before tick() next checks the limits; native code counts them down itself
+    uint32_t stepsUntilCheck() const { return ticksUntilCheck; }
+    void setStepsUntilCheck(uint32_t steps) { ticksUntilCheck = steps; }
+
+    /**
+     * Count steps against 'shared' from now on (also used for PARALLEL FOR workers)
+     */
+    void useBudget(std::shared_ptr<ExecutionBudget> shared);
+
+    // Run top-level statements on the stack VM
+    void runOnVM(const std::vector<StmtPtr> &statements);
+
+    // Call a user function on the stack VM (used by LoxFunction when useVM is set)
+    RuntimeValue callOnVM(LoxFunction &function, std::vector<RuntimeValue> &arguments);
+
     // Public API for executing blocks (used by Callables)
     void executeBlock(const std::vector<StmtPtr> &statements, std::shared_ptr<Environment> env);
 
+    // Truthiness logic (false and nil are false, everything else true)
+    bool isTruthy(const RuntimeValue &object);
+
+    // Dispatch a native list method (append, insert, pop, remove) on an array
+    RuntimeValue callArrayMethod(Array &array, const Token &name,
+                                 std::vector<RuntimeValue> &arguments);
+
+    // Whether 'value' is a list, set or dictionary, whose methods are native
+    static bool hasNativeMethods(const RuntimeValue &value) {
+        return value.is<ArrayPtr>() || value.is<SetPtr>() || value.is<DictionaryPtr>();
+    }
+
+    // Dispatch a native method on a list, set or dictionary
+    RuntimeValue callNativeMethod(const RuntimeValue &receiver, const Token &name,
+                                  std::vector<RuntimeValue> &arguments);
+
+    // The list a FOR loop walks: a list itself, or a snapshot of a set's elements or a
+    // dictionary's keys, so the body may change the collection
+    ArrayPtr iterationList(const Token &variable, const RuntimeValue &iterable);
+
+    // --- Shared Operations (used by both the tree walker and the stack VM) ---
+    RuntimeValue binaryOp(const Token &op, const RuntimeValue &left, const RuntimeValue &right);
+    RuntimeValue getProperty(const RuntimeValue &object, const Token &name);
+    void setProperty(const RuntimeValue &object, const Token &name, RuntimeValue value);
+    RuntimeValue getIndex(const Token &bracket, const RuntimeValue &array,
+                          const RuntimeValue &index);
+    void setIndex(const Token &bracket, const RuntimeValue &array, const RuntimeValue &index,
+                  RuntimeValue value);
+    RuntimeValue sliceArray(const Token &bracket, const RuntimeValue &array,
+                            const RuntimeValue *start, const RuntimeValue *end);
+    void checkArgumentCount(const Token &paren, Callable &callee, size_t count);
+    void printValue(const RuntimeValue &value);
+
+    // Execute a single statement on the tree walker (the VM delegates class declarations)
+    void execute(Stmt *stmt);
+
     // --- ExprVisitor ---
     void visitLiteralExpr(LiteralExpr *expr) override;
     void visitVariableExpr(VariableExpr *expr) override;
@@ -41,6 +147,7 @@ public:
     void visitGetExpr(GetExpr *expr) override;
     void visitArrayAccessExpr(ArrayAccessExpr *expr) override;
     void visitArrayLitExpr(ArrayLitExpr *expr) override;
+    void visitSliceExpr(SliceExpr *expr) override;
     void visitNewExpr(NewExpr *expr) override;
 
     // --- StmtVisitor ---
@@ -58,13 +165,109 @@ private:
     // Helper to hold the result of expression evaluation
     RuntimeValue result;
 
-    void execute(Stmt *stmt);
+    // Stack VM, created on first use when useVM is set
+    std::unique_ptr<VM> vm;
+
+    // Steps left before the limits are next checked, and how many the current interval allows
+    uint32_t ticksUntilCheck = ExecutionBudget::CHECK_INTERVAL;
+    uint32_t tickInterval    = ExecutionBudget::CHECK_INTERVAL;
+
+    // Start a fresh step and time budget for a run, and the heap account on first use
+    void startBudget();
+    void checkLimits(const Token &where);
+
     RuntimeValue evaluate(Expr *expr);
 
-    // Truthiness logic (false and nil are false, everything else true)
-    bool isTruthy(const RuntimeValue &object);
+    /**
+     * Run the iterations of a PARALLEL FOR loop on the shared thread pool (see parallel.cpp)
+     */
+    void runParallelForIn(ForInStmt *stmt, const ArrayPtr &list);
+
     bool isEqual(const RuntimeValue &a, const RuntimeValue &b);
+    bool contains(const Token &op, const RuntimeValue &collection, const RuntimeValue &element);
+    RuntimeValue callSetMethod(Set &set, const Token &name, std::vector<RuntimeValue> &arguments);
+    RuntimeValue callDictionaryMethod(Dictionary &dictionary, const Token &name,
+                                      std::vector<RuntimeValue> &arguments);
+    void finishCall(CallExpr *expr, const RuntimeValue &callee);
     void checkNumberOperand(const Token &operatorToken, const RuntimeValue &operand);
     void checkNumberOperands(const Token &operatorToken, const RuntimeValue &left,
                              const RuntimeValue &right);
 };
+
+// User defined function (FUNCTION ... END name) closed over its defining scope
+class LoxFunction : public Callable {
+public:
+    FunctionStmt *declaration;
+    std::shared_ptr<Environment> closure;
+
+    LoxFunction(FunctionStmt *decl, std::shared_ptr<Environment> closure)
+        : declaration(decl), closure(closure) {
+    }
+
+    /**
+     * Count a call and run it as native code once the function is hot, if its body allows
+     * @return false if the call must be interpreted; 'result' is set otherwise
+     */
+    bool callNative(Interpreter &interpreter, const RuntimeValue *args, RuntimeValue &result) {
+        return hot.call(interpreter, declaration, *closure, args, result);
+    }
+
+    int arity() override;
+    RuntimeValue call(Interpreter &interpreter, std::vector<RuntimeValue> arguments) override;
+    std::string toString() override;
+
+private:
+    jit::HotFunction hot;
+};
+
+// A list, set or dictionary method bound to its receiver, produced when a method is read without
+// calling it (e.g. 'add = list.append'). Direct calls like 'list.append(x)' never allocate one.
+class CollectionMethod : public Callable {
+    RuntimeValue collection;
+    Token name;
+
+public:
+    CollectionMethod(RuntimeValue collection, Token name) : collection(collection), name(name) {
+    }
+
+    int arity() override {
+        if (name.lexeme == "insert")
+            return 2;
+        if (name.lexeme == "pop" || name.lexeme == "keys" || name.lexeme == "values")
+            return 0;
+        return 1;
+    }
+
+    RuntimeValue call(Interpreter &interpreter, std::vector<RuntimeValue> arguments) override {
+        return interpreter.callNativeMethod(collection, name, arguments);
+    }
+
+    std::string toString() override {
+        const char *kind = collection.is<ArrayPtr>() ? "list"
+                           : collection.is<SetPtr>() ? "set"
+                                                     : "dictionary";
+        return std::string("<") + kind + " method " + name.lexeme + ">";
+    }
+
+    const RuntimeValue &receiver() const {
+        return collection;
+    }
+};
+
+// RAII guard counting one level of pseudocode recursion
+struct CallDepthGuard {
+    Interpreter &interpreter;
+
+    CallDepthGuard(Interpreter &interp, const Token &function) : interpreter(interp) {
+        if (interpreter.callDepth >= interpreter.maxCallDepth) {
+            throw RuntimeError(function, "Maximum recursion depth of " +
+                                             std::to_string(interpreter.maxCallDepth) +
+                                             " exceeded in '" + function.lexeme + "'.");
+        }
+        interpreter.callDepth++;
+    }
+
+    ~CallDepthGuard() {
+        interpreter.callDepth--;
+    }
+};
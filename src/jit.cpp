@@ -0,0 +1,627 @@
+#include "jit.hpp"
+#include "interpreter.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__x86_64__) && defined(__linux__)
+#include <sys/mman.h>
+#define JIT_X86_64 1
+#endif
+
+namespace jit {
+namespace {
+
+// Most parameters and locals a compiled function may have; their values live in a stack array
+constexpr size_t MAX_SLOTS = 64;
+
+/**
+ * State shared by a running native function and the C++ it calls out to
+ * The generated code reaches 'countdown' and 'result' at fixed offsets.
+ */
+struct NativeState {
+    uint32_t countdown; // The interpreter's steps left before its next limit check
+    uint32_t unused;
+    double result; // The value of a RETURN
+    Interpreter *interpreter;
+    std::exception_ptr *error; // Set when the budget stops the program
+    const Token *divisor;      // The '/' that divided by zero
+};
+
+static_assert(offsetof(NativeState, countdown) == 0, "countdown is addressed as [r12]");
+static_assert(offsetof(NativeState, result) == 8, "result is addressed as [r12 + 8]");
+static_assert(offsetof(NativeState, divisor) == 32, "divisor is addressed as [r12 + 32]");
+
+// How native code leaves, in eax
+enum Status : int {
+    RETURNED_NUMBER  = 0, // RETURN with a value, which is in NativeState::result
+    RETURNED_NOTHING = 1, // A bare RETURN, or the end of the body
+    DIVIDED_BY_ZERO  = 2, // A division by zero at NativeState::divisor
+    STOPPED          = 3, // A step or time limit was hit; NativeState::error holds the error
+};
+
+using Entry = int (*)(double *slots, NativeState *state);
+
+} // namespace
+
+/**
+ * Code - an executable mapping holding one compiled function
+ */
+class Code {
+public:
+    Code(void *memory, size_t length, std::vector<std::string> locals)
+        : memory(memory), length(length), locals(std::move(locals)) {
+    }
+    ~Code();
+
+    Code(const Code &)            = delete;
+    Code &operator=(const Code &) = delete;
+
+    /**
+     * Compile a function body, or return null if it is outside the numeric subset
+     */
+    static std::unique_ptr<Code> compile(FunctionStmt *declaration);
+
+    bool run(Interpreter &interpreter, FunctionStmt *declaration, const Environment &closure,
+             const RuntimeValue *args, RuntimeValue &result) const;
+
+private:
+    void *memory;
+    size_t length;
+    // Names the body assigns that are not parameters; see run()
+    std::vector<std::string> locals;
+};
+
+#ifdef JIT_X86_64
+
+// ============================================================
+// x86-64 Code Generation
+// ============================================================
+
+namespace {
+
+/**
+ * Check the limits on the loop iteration that used up the countdown, called from native code
+ * Exceptions cannot unwind through generated frames, so the limit error is handed back instead.
+ * @return 0 to keep going, 1 to stop
+ */
+int reportSteps(NativeState *state, const Token *where) {
+    try {
+        // This iteration is the interpreter's last step before its check, so ticking it checks
+        state->interpreter->setStepsUntilCheck(1);
+        state->interpreter->tick(*where);
+    } catch (...) {
+        *state->error = std::current_exception();
+        return 1;
+    }
+    state->countdown = state->interpreter->stepsUntilCheck();
+    return 0;
+}
+
+// Register use: rbx points at the slot array, r12 at the NativeState, and expressions are
+// evaluated into xmm0 (with xmm1 holding a binary operator's right operand). Deeper
+// intermediate values are pushed on the machine stack.
+
+// Condition codes for Assembler::jump
+enum Condition : uint8_t {
+    ALWAYS      = 0,
+    BELOW       = 0x82,
+    EQUAL       = 0x84,
+    NOT_EQUAL   = 0x85,
+    BELOW_EQUAL = 0x86,
+    PARITY      = 0x8A,
+};
+
+class Assembler {
+public:
+    std::vector<uint8_t> bytes;
+
+    void emit(std::initializer_list<uint8_t> code) {
+        bytes.insert(bytes.end(), code);
+    }
+    void emit32(uint32_t value) {
+        for (int i = 0; i < 4; ++i)
+            bytes.push_back(uint8_t(value >> (8 * i)));
+    }
+    void emit64(uint64_t value) {
+        for (int i = 0; i < 8; ++i)
+            bytes.push_back(uint8_t(value >> (8 * i)));
+    }
+    size_t here() const {
+        return bytes.size();
+    }
+
+    /**
+     * Emit a jump with a placeholder target
+     * @return The position to hand to bind() once the target is known
+     */
+    size_t jump(Condition condition) {
+        if (condition == ALWAYS)
+            emit({0xE9});
+        else
+            emit({0x0F, condition});
+        emit32(0);
+        return here() - 4;
+    }
+    void bind(size_t jump, size_t target) {
+        uint32_t offset = uint32_t(int32_t(target) - int32_t(jump + 4));
+        std::memcpy(&bytes[jump], &offset, 4);
+    }
+
+    // movsd xmm<reg>, [rbx + 8 * slot]
+    void loadSlot(int reg, size_t slot) {
+        emit({0xF2, 0x0F, 0x10, uint8_t(0x83 | reg << 3)});
+        emit32(uint32_t(slot * 8));
+    }
+    // movsd [rbx + 8 * slot], xmm0
+    void storeSlot(size_t slot) {
+        emit({0xF2, 0x0F, 0x11, 0x83});
+        emit32(uint32_t(slot * 8));
+    }
+    // mov rax, bits; movq xmm<reg>, rax
+    void loadConstant(int reg, double value) {
+        uint64_t bits;
+        std::memcpy(&bits, &value, 8);
+        emit({0x48, 0xB8});
+        emit64(bits);
+        emit({0x66, 0x48, 0x0F, 0x6E, uint8_t(0xC0 | reg << 3)});
+    }
+    // sub rsp, 8; movsd [rsp], xmm0
+    void pushXmm0() {
+        emit({0x48, 0x83, 0xEC, 0x08, 0xF2, 0x0F, 0x11, 0x04, 0x24});
+    }
+    // movapd xmm1, xmm0; movsd xmm0, [rsp]; add rsp, 8
+    void popLeftOperand() {
+        emit({0x66, 0x0F, 0x28, 0xC8, 0xF2, 0x0F, 0x10, 0x04, 0x24, 0x48, 0x83, 0xC4, 0x08});
+    }
+    // addsd/subsd/mulsd/divsd xmm0, xmm1
+    void arithmetic(uint8_t opcode) {
+        emit({0xF2, 0x0F, opcode, 0xC1});
+    }
+    // ucomisd xmm<a>, xmm<b>
+    void compare(int a, int b) {
+        emit({0x66, 0x0F, 0x2E, uint8_t(0xC0 | a << 3 | b)});
+    }
+    // mov eax, status
+    void status(Status value) {
+        emit({0xB8});
+        emit32(uint32_t(value));
+    }
+};
+
+/**
+ * Translator - checks that a function body is in the numeric subset while emitting its code
+ *
+ * Every value is a number; comparisons only appear as IF and WHILE conditions. A local must be
+ * assigned on every path before it is read, as reading it earlier would find an outer variable
+ * (or none) on the interpreter.
+ */
+class Translator {
+public:
+    explicit Translator(FunctionStmt *function) : function(function) {
+    }
+
+    /**
+     * Emit the whole function
+     * @return false if the body is outside the subset
+     */
+    bool translate() {
+        for (const Token &param : function->params) {
+            size_t slot = slots.size();
+            if (slots.count(param.lexeme) || slot == MAX_SLOTS)
+                return false;
+            slots[param.lexeme] = slot;
+        }
+        std::vector<bool> assigned(slots.size(), true);
+
+        // push rbp; mov rbp, rsp; push rbx; push r12; mov rbx, rdi; mov r12, rsi
+        a.emit({0x55, 0x48, 0x89, 0xE5, 0x53, 0x41, 0x54, 0x48, 0x89, 0xFB, 0x49, 0x89, 0xF4});
+
+        bool returns = false;
+        if (!block(function->body, assigned, returns))
+            return false;
+        a.status(RETURNED_NOTHING);
+        exits.push_back(a.jump(ALWAYS));
+
+        size_t dividedByZero = a.here();
+        a.status(DIVIDED_BY_ZERO);
+        exits.push_back(a.jump(ALWAYS));
+        for (size_t jump : zeroDivisors)
+            a.bind(jump, dividedByZero);
+
+        size_t stopped = a.here();
+        a.status(STOPPED);
+        for (size_t jump : stops)
+            a.bind(jump, stopped);
+
+        // Temporaries may still be pushed, so rsp is restored from rbp:
+        // lea rsp, [rbp - 16]; pop r12; pop rbx; pop rbp; ret
+        size_t epilogue = a.here();
+        a.emit({0x48, 0x8D, 0x65, 0xF0, 0x41, 0x5C, 0x5B, 0x5D, 0xC3});
+        for (size_t jump : exits)
+            a.bind(jump, epilogue);
+        return true;
+    }
+
+    const std::vector<uint8_t> &code() const {
+        return a.bytes;
+    }
+
+    std::vector<std::string> locals() const {
+        std::vector<std::string> names;
+        for (const auto &[name, slot] : slots) {
+            if (slot >= function->params.size())
+                names.push_back(name);
+        }
+        return names;
+    }
+
+private:
+    FunctionStmt *function;
+    Assembler a;
+    std::unordered_map<std::string, size_t> slots;
+    std::vector<size_t> exits;        // Jumps to the epilogue
+    std::vector<size_t> zeroDivisors; // Jumps to the DIVIDED_BY_ZERO exit
+    std::vector<size_t> stops;        // Jumps to the STOPPED exit
+
+    // --- Statements ---
+
+    /**
+     * @param assigned Which slots hold a value; updated as the statements assign more
+     * @param returns Set when every path through the statements ends in RETURN
+     */
+    bool block(const std::vector<StmtPtr> &statements, std::vector<bool> &assigned,
+               bool &returns) {
+        for (const auto &stmt : statements) {
+            if (returns)
+                return true; // Unreachable
+            if (!statement(stmt.get(), assigned, returns))
+                return false;
+        }
+        return true;
+    }
+
+    bool statement(Stmt *stmt, std::vector<bool> &assigned, bool &returns) {
+        if (auto expression = dynamic_cast<ExpressionStmt *>(stmt)) {
+            auto assign = dynamic_cast<AssignExpr *>(expression->expression.get());
+            if (!assign)
+                return false;
+            auto target = dynamic_cast<VariableExpr *>(assign->target.get());
+            if (!target || !number(assign->value.get(), assigned))
+                return false;
+            auto slot = slots.find(target->name.lexeme);
+            if (slot == slots.end()) {
+                if (slots.size() == MAX_SLOTS)
+                    return false;
+                slot = slots.emplace(target->name.lexeme, slots.size()).first;
+                assigned.push_back(false);
+            }
+            a.storeSlot(slot->second);
+            assigned[slot->second] = true;
+            return true;
+        }
+        if (auto ret = dynamic_cast<ReturnStmt *>(stmt)) {
+            if (ret->value) {
+                if (!number(ret->value.get(), assigned))
+                    return false;
+                // movsd [r12 + 8], xmm0
+                a.emit({0xF2, 0x41, 0x0F, 0x11, 0x44, 0x24, 0x08});
+                a.status(RETURNED_NUMBER);
+            } else {
+                a.status(RETURNED_NOTHING);
+            }
+            exits.push_back(a.jump(ALWAYS));
+            returns = true;
+            return true;
+        }
+        if (auto branch = dynamic_cast<IfStmt *>(stmt))
+            return ifStatement(branch, assigned, returns);
+        if (auto loop = dynamic_cast<WhileStmt *>(stmt))
+            return whileStatement(loop, assigned);
+        return false;
+    }
+
+    bool ifStatement(IfStmt *stmt, std::vector<bool> &assigned, bool &returns) {
+        std::vector<size_t> toElse;
+        if (!condition(stmt->condition.get(), assigned, toElse))
+            return false;
+
+        std::vector<bool> thenAssigned = assigned;
+        bool thenReturns               = false;
+        if (!block(stmt->thenBranch, thenAssigned, thenReturns))
+            return false;
+        size_t toEnd = a.jump(ALWAYS);
+
+        for (size_t jump : toElse)
+            a.bind(jump, a.here());
+        std::vector<bool> elseAssigned = assigned;
+        elseAssigned.resize(thenAssigned.size(), false);
+        bool elseReturns = false;
+        if (!block(stmt->elseBranch, elseAssigned, elseReturns))
+            return false;
+        a.bind(toEnd, a.here());
+
+        // Slots either branch added are unassigned on the other; a branch that returns doesn't
+        // reach the code after the IF, so only the other one counts
+        thenAssigned.resize(elseAssigned.size(), false);
+        assigned.resize(elseAssigned.size(), false);
+        for (size_t i = 0; i < assigned.size(); ++i) {
+            assigned[i] = thenReturns   ? elseAssigned[i]
+                          : elseReturns ? thenAssigned[i]
+                                        : thenAssigned[i] && elseAssigned[i];
+        }
+        returns = thenReturns && elseReturns;
+        return true;
+    }
+
+    bool whileStatement(WhileStmt *stmt, std::vector<bool> &assigned) {
+        size_t top = a.here();
+        std::vector<size_t> toEnd;
+        if (!condition(stmt->condition.get(), assigned, toEnd))
+            return false;
+
+        // Count the iteration as the interpreter does, checking the limits when it would:
+        // dec dword [r12]; jnz body
+        a.emit({0x41, 0xFF, 0x0C, 0x24});
+        size_t toBody = a.jump(NOT_EQUAL);
+        // mov rdi, r12; mov rsi, &keyword; mov rax, reportSteps; call rax; test eax, eax
+        a.emit({0x4C, 0x89, 0xE7, 0x48, 0xBE});
+        a.emit64(reinterpret_cast<uint64_t>(&stmt->keyword));
+        a.emit({0x48, 0xB8});
+        a.emit64(reinterpret_cast<uint64_t>(&reportSteps));
+        a.emit({0xFF, 0xD0, 0x85, 0xC0});
+        stops.push_back(a.jump(NOT_EQUAL));
+        a.bind(toBody, a.here());
+
+        // The body may not run at all, so what it assigns doesn't count after the loop
+        std::vector<bool> bodyAssigned = assigned;
+        bool returns                   = false;
+        if (!block(stmt->body, bodyAssigned, returns))
+            return false;
+        a.bind(a.jump(ALWAYS), top);
+        for (size_t jump : toEnd)
+            a.bind(jump, a.here());
+        assigned.resize(bodyAssigned.size(), false);
+        return true;
+    }
+
+    // --- Expressions ---
+
+    /**
+     * Emit the jumps taken when a condition is false
+     */
+    bool condition(Expr *expr, const std::vector<bool> &assigned, std::vector<size_t> &whenFalse) {
+        if (auto literal = dynamic_cast<LiteralExpr *>(expr)) {
+            if (literal->token.type == TOK_FALSE)
+                whenFalse.push_back(a.jump(ALWAYS));
+            return literal->token.type == TOK_TRUE || literal->token.type == TOK_FALSE;
+        }
+        auto binary = dynamic_cast<BinaryExpr *>(expr);
+        if (!binary)
+            return false;
+        TokenType op = binary->op.type;
+        if (op != TOK_LESS_THAN && op != TOK_LT_OR_EQ && op != TOK_GREATER_THAN &&
+            op != TOK_GT_OR_EQ && op != TOK_EQUAL)
+            return false;
+        if (!operands(binary, assigned))
+            return false;
+
+        // ucomisd sets every flag for NaN, so each test is arranged to be false then, as the
+        // interpreter's comparisons are
+        switch (op) {
+        case TOK_LESS_THAN: // right > left
+            a.compare(1, 0);
+            whenFalse.push_back(a.jump(BELOW_EQUAL));
+            break;
+        case TOK_LT_OR_EQ: // right >= left
+            a.compare(1, 0);
+            whenFalse.push_back(a.jump(BELOW));
+            break;
+        case TOK_GREATER_THAN:
+            a.compare(0, 1);
+            whenFalse.push_back(a.jump(BELOW_EQUAL));
+            break;
+        case TOK_GT_OR_EQ:
+            a.compare(0, 1);
+            whenFalse.push_back(a.jump(BELOW));
+            break;
+        default: // TOK_EQUAL
+            a.compare(0, 1);
+            whenFalse.push_back(a.jump(PARITY));
+            whenFalse.push_back(a.jump(NOT_EQUAL));
+            break;
+        }
+        return true;
+    }
+
+    /**
+     * Emit a number-valued expression into xmm0
+     */
+    bool number(Expr *expr, const std::vector<bool> &assigned) {
+        if (leaf(expr, 0, assigned))
+            return true;
+        auto binary = dynamic_cast<BinaryExpr *>(expr);
+        if (!binary)
+            return false;
+        switch (binary->op.type) {
+        case TOK_PLUS:
+            if (!operands(binary, assigned))
+                return false;
+            a.arithmetic(0x58);
+            return true;
+        case TOK_MINUS:
+            if (!operands(binary, assigned))
+                return false;
+            a.arithmetic(0x5C);
+            return true;
+        case TOK_MULTIPLY:
+            if (!operands(binary, assigned))
+                return false;
+            a.arithmetic(0x59);
+            return true;
+        case TOK_DIVIDE: {
+            if (!operands(binary, assigned))
+                return false;
+            // Division by zero leaves with the operator, raised as the interpreter would:
+            // xorpd xmm2, xmm2; ucomisd xmm1, xmm2; jp divide; jne divide;
+            // mov rax, &op; mov [r12 + 32], rax; jmp divided by zero
+            a.emit({0x66, 0x0F, 0x57, 0xD2});
+            a.compare(1, 2);
+            size_t toDivide  = a.jump(PARITY);
+            size_t isNonzero = a.jump(NOT_EQUAL);
+            a.emit({0x48, 0xB8});
+            a.emit64(reinterpret_cast<uint64_t>(&binary->op));
+            a.emit({0x49, 0x89, 0x44, 0x24, 0x20});
+            zeroDivisors.push_back(a.jump(ALWAYS));
+            a.bind(toDivide, a.here());
+            a.bind(isNonzero, a.here());
+            a.arithmetic(0x5E);
+            return true;
+        }
+        default:
+            return false;
+        }
+    }
+
+    /**
+     * Emit a binary expression's left operand into xmm0 and its right operand into xmm1
+     */
+    bool operands(BinaryExpr *binary, const std::vector<bool> &assigned) {
+        if (!number(binary->left.get(), assigned))
+            return false;
+        if (leaf(binary->right.get(), 1, assigned))
+            return true;
+        a.pushXmm0();
+        if (!number(binary->right.get(), assigned))
+            return false;
+        a.popLeftOperand();
+        return true;
+    }
+
+    /**
+     * Load a number literal or an assigned variable straight into xmm<reg>
+     */
+    bool leaf(Expr *expr, int reg, const std::vector<bool> &assigned) {
+        if (auto literal = dynamic_cast<LiteralExpr *>(expr)) {
+            if (literal->token.type != TOK_INTEGER && literal->token.type != TOK_FLOAT)
+                return false;
+            a.loadConstant(reg, std::stod(literal->token.lexeme));
+            return true;
+        }
+        if (auto variable = dynamic_cast<VariableExpr *>(expr)) {
+            auto slot = slots.find(variable->name.lexeme);
+            if (slot == slots.end() || !assigned[slot->second])
+                return false;
+            a.loadSlot(reg, slot->second);
+            return true;
+        }
+        return false;
+    }
+};
+
+} // namespace
+
+std::unique_ptr<Code> Code::compile(FunctionStmt *declaration) {
+    Translator translator(declaration);
+    if (!translator.translate())
+        return nullptr;
+
+    // Written while writable, then made executable (never both at once)
+    const std::vector<uint8_t> &bytes = translator.code();
+    void *memory = mmap(nullptr, bytes.size(), PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED)
+        return nullptr;
+    std::memcpy(memory, bytes.data(), bytes.size());
+    if (mprotect(memory, bytes.size(), PROT_READ | PROT_EXEC) != 0) {
+        munmap(memory, bytes.size());
+        return nullptr;
+    }
+    return std::make_unique<Code>(memory, bytes.size(), translator.locals());
+}
+
+Code::~Code() {
+    munmap(memory, length);
+}
+
+#else
+
+std::unique_ptr<Code> Code::compile(FunctionStmt *) {
+    return nullptr;
+}
+
+Code::~Code() {
+}
+
+#endif // JIT_X86_64
+
+/**
+ * Run the compiled body, or decline so the interpreter runs the call
+ */
+bool Code::run(Interpreter &interpreter, FunctionStmt *declaration, const Environment &closure,
+               const RuntimeValue *args, RuntimeValue &result) const {
+    size_t params = declaration->params.size();
+    for (size_t i = 0; i < params; ++i) {
+        if (!args[i].is<double>())
+            return false;
+    }
+    // Assigning a name an enclosing scope defines changes that variable, not a local
+    for (const std::string &name : locals) {
+        if (closure.contains(name))
+            return false;
+    }
+    // Let the interpreter raise the recursion error
+    if (interpreter.callDepth >= interpreter.maxCallDepth)
+        return false;
+
+    double slots[MAX_SLOTS];
+    for (size_t i = 0; i < params; ++i)
+        slots[i] = args[i].as<double>();
+
+    interpreter.tick(declaration->name);
+    std::exception_ptr error;
+    NativeState state{interpreter.stepsUntilCheck(), 0, 0.0, &interpreter, &error, nullptr};
+    int status = reinterpret_cast<Entry>(memory)(slots, &state);
+    if (status == STOPPED)
+        std::rethrow_exception(error);
+
+    // Hand the steps left over back to the interpreter
+    interpreter.setStepsUntilCheck(state.countdown);
+
+    switch (status) {
+    case RETURNED_NUMBER:
+        result = {state.result};
+        return true;
+    case RETURNED_NOTHING:
+        result = {std::monostate{}};
+        return true;
+    default:
+        // Raised here rather than by rerunning the call, so its steps are counted once
+        throw RuntimeError(*state.divisor, "Division by zero.");
+    }
+}
+
+// --- HotFunction ---
+
+HotFunction::HotFunction() = default;
+HotFunction::~HotFunction() = default;
+
+bool HotFunction::call(Interpreter &interpreter, FunctionStmt *declaration,
+                       const Environment &closure, const RuntimeValue *args,
+                       RuntimeValue &result) {
+    if (!interpreter.useJit)
+        return false;
+    if (calls.load(std::memory_order_relaxed) < HOT_CALLS) {
+        calls.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    // Concurrent PARALLEL FOR iterations wait for a single compilation
+    std::call_once(compiled, [&] { code = Code::compile(declaration); });
+    return code && code->run(interpreter, declaration, closure, args, result);
+}
+
+} // namespace jit
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "ast.hpp"
+#include "runtime.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+class Interpreter;
+
+/**
+ * Baseline JIT for numeric functions
+ *
+ * Once a function has been called HOT_CALLS times, its body is compiled to x86-64 machine code
+ * if it stays within a numeric subset: number parameters and locals, + - * /, comparisons, IF,
+ * WHILE and RETURN. The code is stitched together from a fixed instruction template per AST node,
+ * so no compiler is needed at run time. Bodies outside the subset, calls with arguments that are
+ * not numbers, and every platform but x86-64 Linux keep running on the interpreter.
+ *
+ * Compiled code has no side effects beyond counting loop iterations against the step budget.
+ * A division by zero leaves the native code and is reported at its operator, just as the
+ * interpreter reports it, after the iterations so far have been counted.
+ */
+namespace jit {
+
+// Calls a function takes before its body is compiled
+constexpr uint32_t HOT_CALLS = 50;
+
+class Code;
+
+/**
+ * HotFunction - one function's call counter and, once it is hot, its native code
+ */
+class HotFunction {
+public:
+    HotFunction();
+    ~HotFunction();
+
+    /**
+     * Count a call and, if the function is hot and compiled, run it natively
+     * @param declaration The function being called
+     * @param closure The scope it was defined in
+     * @param args The arguments; their count must already match the parameters
+     * @param result Set to the return value when the call ran natively
+     * @return false if the call must be interpreted instead
+     */
+    bool call(Interpreter &interpreter, FunctionStmt *declaration, const Environment &closure,
+              const RuntimeValue *args, RuntimeValue &result);
+
+private:
+    std::atomic<uint32_t> calls{0};
+    std::once_flag compiled;
+    std::unique_ptr<Code> code; // Null if the body is outside the subset
+};
+
+} // namespace jit
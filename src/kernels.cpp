@@ -0,0 +1,326 @@
+#include "kernels.hpp"
+
+#include <cmath>
+#include <limits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define KERNELS_X86 1
+#endif
+
+namespace kernels {
+namespace {
+
+// Every implementation fills in one of these; the best available table is chosen at startup
+struct KernelTable {
+    double (*sum)(const double *, size_t);
+    double (*min)(const double *, size_t);
+    double (*max)(const double *, size_t);
+    double (*dot)(const double *, const double *, size_t);
+    void (*addScalar)(const double *, double, double *, size_t);
+    void (*mulScalar)(const double *, double, double *, size_t);
+    const char *name;
+};
+
+// MIN and MAX propagate NaN: a NaN anywhere in the input makes the result NaN, in every
+// implementation. The vector min/max instructions alone return their second operand when
+// either is NaN, so the vector kernels track NaN lanes separately.
+
+constexpr double NOT_A_NUMBER = std::numeric_limits<double>::quiet_NaN();
+
+double lesser(double a, double b) {
+    if (std::isnan(a) || std::isnan(b))
+        return NOT_A_NUMBER;
+    return b < a ? b : a;
+}
+
+double greater(double a, double b) {
+    if (std::isnan(a) || std::isnan(b))
+        return NOT_A_NUMBER;
+    return b > a ? b : a;
+}
+
+// ============================================================
+// Scalar Fallback
+// ============================================================
+
+double sumScalar(const double *data, size_t n) {
+    double total = 0;
+    for (size_t i = 0; i < n; ++i)
+        total += data[i];
+    return total;
+}
+
+double minScalar(const double *data, size_t n) {
+    double best = data[0];
+    for (size_t i = 1; i < n; ++i)
+        best = lesser(best, data[i]);
+    return best;
+}
+
+double maxScalar(const double *data, size_t n) {
+    double best = data[0];
+    for (size_t i = 1; i < n; ++i)
+        best = greater(best, data[i]);
+    return best;
+}
+
+double dotScalar(const double *a, const double *b, size_t n) {
+    double total = 0;
+    for (size_t i = 0; i < n; ++i)
+        total += a[i] * b[i];
+    return total;
+}
+
+void addScalarScalar(const double *in, double k, double *out, size_t n) {
+    for (size_t i = 0; i < n; ++i)
+        out[i] = in[i] + k;
+}
+
+void mulScalarScalar(const double *in, double k, double *out, size_t n) {
+    for (size_t i = 0; i < n; ++i)
+        out[i] = in[i] * k;
+}
+
+#ifdef KERNELS_X86
+
+// ============================================================
+// SSE2 (2 doubles per register)
+// ============================================================
+
+__attribute__((target("sse2"))) double sumSse2(const double *data, size_t n) {
+    // Two independent accumulators hide the latency of the vector add
+    __m128d acc0 = _mm_setzero_pd();
+    __m128d acc1 = _mm_setzero_pd();
+    size_t i     = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc0 = _mm_add_pd(acc0, _mm_loadu_pd(data + i));
+        acc1 = _mm_add_pd(acc1, _mm_loadu_pd(data + i + 2));
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_add_pd(acc0, acc1));
+    return lanes[0] + lanes[1] + sumScalar(data + i, n - i);
+}
+
+__attribute__((target("sse2"))) double minSse2(const double *data, size_t n) {
+    if (n < 2)
+        return data[0];
+    __m128d best      = _mm_loadu_pd(data);
+    __m128d unordered = _mm_cmpunord_pd(best, best);
+    size_t i          = 2;
+    for (; i + 2 <= n; i += 2) {
+        __m128d next = _mm_loadu_pd(data + i);
+        best         = _mm_min_pd(best, next);
+        unordered    = _mm_or_pd(unordered, _mm_cmpunord_pd(next, next));
+    }
+    if (_mm_movemask_pd(unordered))
+        return NOT_A_NUMBER;
+    double lanes[2];
+    _mm_storeu_pd(lanes, best);
+    double result = lesser(lanes[0], lanes[1]);
+    return i < n ? lesser(result, data[i]) : result;
+}
+
+__attribute__((target("sse2"))) double maxSse2(const double *data, size_t n) {
+    if (n < 2)
+        return data[0];
+    __m128d best      = _mm_loadu_pd(data);
+    __m128d unordered = _mm_cmpunord_pd(best, best);
+    size_t i          = 2;
+    for (; i + 2 <= n; i += 2) {
+        __m128d next = _mm_loadu_pd(data + i);
+        best         = _mm_max_pd(best, next);
+        unordered    = _mm_or_pd(unordered, _mm_cmpunord_pd(next, next));
+    }
+    if (_mm_movemask_pd(unordered))
+        return NOT_A_NUMBER;
+    double lanes[2];
+    _mm_storeu_pd(lanes, best);
+    double result = greater(lanes[0], lanes[1]);
+    return i < n ? greater(result, data[i]) : result;
+}
+
+__attribute__((target("sse2"))) double dotSse2(const double *a, const double *b, size_t n) {
+    __m128d acc0 = _mm_setzero_pd();
+    __m128d acc1 = _mm_setzero_pd();
+    size_t i     = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+        acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2)));
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_add_pd(acc0, acc1));
+    return lanes[0] + lanes[1] + dotScalar(a + i, b + i, n - i);
+}
+
+__attribute__((target("sse2"))) void addScalarSse2(const double *in, double k, double *out,
+                                                   size_t n) {
+    __m128d vk = _mm_set1_pd(k);
+    size_t i   = 0;
+    for (; i + 2 <= n; i += 2)
+        _mm_storeu_pd(out + i, _mm_add_pd(_mm_loadu_pd(in + i), vk));
+    addScalarScalar(in + i, k, out + i, n - i);
+}
+
+__attribute__((target("sse2"))) void mulScalarSse2(const double *in, double k, double *out,
+                                                   size_t n) {
+    __m128d vk = _mm_set1_pd(k);
+    size_t i   = 0;
+    for (; i + 2 <= n; i += 2)
+        _mm_storeu_pd(out + i, _mm_mul_pd(_mm_loadu_pd(in + i), vk));
+    mulScalarScalar(in + i, k, out + i, n - i);
+}
+
+// ============================================================
+// AVX2 (4 doubles per register)
+// ============================================================
+
+__attribute__((target("avx2"))) double sumAvx2(const double *data, size_t n) {
+    // Four accumulators keep enough adds in flight to saturate memory bandwidth
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    __m256d acc2 = _mm256_setzero_pd();
+    __m256d acc3 = _mm256_setzero_pd();
+    size_t i     = 0;
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(data + i));
+        acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(data + i + 4));
+        acc2 = _mm256_add_pd(acc2, _mm256_loadu_pd(data + i + 8));
+        acc3 = _mm256_add_pd(acc3, _mm256_loadu_pd(data + i + 12));
+    }
+    __m256d acc = _mm256_add_pd(_mm256_add_pd(acc0, acc1), _mm256_add_pd(acc2, acc3));
+    double lanes[4];
+    _mm256_storeu_pd(lanes, acc);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + sumScalar(data + i, n - i);
+}
+
+__attribute__((target("avx2"))) double minAvx2(const double *data, size_t n) {
+    if (n < 4)
+        return minScalar(data, n);
+    __m256d best      = _mm256_loadu_pd(data);
+    __m256d unordered = _mm256_cmp_pd(best, best, _CMP_UNORD_Q);
+    size_t i          = 4;
+    for (; i + 4 <= n; i += 4) {
+        __m256d next = _mm256_loadu_pd(data + i);
+        best         = _mm256_min_pd(best, next);
+        unordered    = _mm256_or_pd(unordered, _mm256_cmp_pd(next, next, _CMP_UNORD_Q));
+    }
+    if (_mm256_movemask_pd(unordered))
+        return NOT_A_NUMBER;
+    double lanes[4];
+    _mm256_storeu_pd(lanes, best);
+    double result = minScalar(lanes, 4);
+    for (; i < n; ++i)
+        result = lesser(result, data[i]);
+    return result;
+}
+
+__attribute__((target("avx2"))) double maxAvx2(const double *data, size_t n) {
+    if (n < 4)
+        return maxScalar(data, n);
+    __m256d best      = _mm256_loadu_pd(data);
+    __m256d unordered = _mm256_cmp_pd(best, best, _CMP_UNORD_Q);
+    size_t i          = 4;
+    for (; i + 4 <= n; i += 4) {
+        __m256d next = _mm256_loadu_pd(data + i);
+        best         = _mm256_max_pd(best, next);
+        unordered    = _mm256_or_pd(unordered, _mm256_cmp_pd(next, next, _CMP_UNORD_Q));
+    }
+    if (_mm256_movemask_pd(unordered))
+        return NOT_A_NUMBER;
+    double lanes[4];
+    _mm256_storeu_pd(lanes, best);
+    double result = maxScalar(lanes, 4);
+    for (; i < n; ++i)
+        result = greater(result, data[i]);
+    return result;
+}
+
+__attribute__((target("avx2"))) double dotAvx2(const double *a, const double *b, size_t n) {
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    size_t i     = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+        acc1 = _mm256_add_pd(acc1,
+                             _mm256_mul_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4)));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(acc0, acc1));
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + dotScalar(a + i, b + i, n - i);
+}
+
+__attribute__((target("avx2"))) void addScalarAvx2(const double *in, double k, double *out,
+                                                   size_t n) {
+    __m256d vk = _mm256_set1_pd(k);
+    size_t i   = 0;
+    for (; i + 4 <= n; i += 4)
+        _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_loadu_pd(in + i), vk));
+    addScalarScalar(in + i, k, out + i, n - i);
+}
+
+__attribute__((target("avx2"))) void mulScalarAvx2(const double *in, double k, double *out,
+                                                   size_t n) {
+    __m256d vk = _mm256_set1_pd(k);
+    size_t i   = 0;
+    for (; i + 4 <= n; i += 4)
+        _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_loadu_pd(in + i), vk));
+    mulScalarScalar(in + i, k, out + i, n - i);
+}
+
+#endif // KERNELS_X86
+
+// ============================================================
+// Runtime Dispatch
+// ============================================================
+
+KernelTable selectKernels() {
+#ifdef KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return {sumAvx2, minAvx2, maxAvx2, dotAvx2, addScalarAvx2, mulScalarAvx2, "avx2"};
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return {sumSse2, minSse2, maxSse2, dotSse2, addScalarSse2, mulScalarSse2, "sse2"};
+    }
+#endif
+    return {sumScalar, minScalar, maxScalar, dotScalar, addScalarScalar, mulScalarScalar, "scalar"};
+}
+
+const KernelTable &kernelTable() {
+    // Initialised once, thread-safely, on first use
+    static const KernelTable table = selectKernels();
+    return table;
+}
+
+} // namespace
+
+double sum(const double *data, size_t n) {
+    return kernelTable().sum(data, n);
+}
+
+double min(const double *data, size_t n) {
+    return kernelTable().min(data, n);
+}
+
+double max(const double *data, size_t n) {
+    return kernelTable().max(data, n);
+}
+
+double dot(const double *a, const double *b, size_t n) {
+    return kernelTable().dot(a, b, n);
+}
+
+void addScalar(const double *in, double k, double *out, size_t n) {
+    kernelTable().addScalar(in, k, out, n);
+}
+
+void mulScalar(const double *in, double k, double *out, size_t n) {
+    kernelTable().mulScalar(in, k, out, n);
+}
+
+const char *isaName() {
+    return kernelTable().name;
+}
+
+} // namespace kernels
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+
+/**
+ * Numeric kernels over packed double buffers
+ *
+ * Each kernel has an AVX2, an SSE2 and a portable scalar implementation. The widest one the
+ * running CPU supports is picked once, on first use, so a single binary runs everywhere.
+ */
+namespace kernels {
+
+/**
+ * Sum of the first n elements (0 for an empty buffer)
+ */
+double sum(const double *data, size_t n);
+
+/**
+ * Smallest of the first n elements, or NaN if any of them is NaN; n must be at least 1
+ */
+double min(const double *data, size_t n);
+
+/**
+ * Largest of the first n elements, or NaN if any of them is NaN; n must be at least 1
+ */
+double max(const double *data, size_t n);
+
+/**
+ * Dot product of two buffers of length n
+ */
+double dot(const double *a, const double *b, size_t n);
+
+/**
+ * out[i] = in[i] + k for i in [0, n); 'in' and 'out' may alias
+ */
+void addScalar(const double *in, double k, double *out, size_t n);
+
+/**
+ * out[i] = in[i] * k for i in [0, n); 'in' and 'out' may alias
+ */
+void mulScalar(const double *in, double k, double *out, size_t n);
+
+/**
+ * Name of the instruction set the kernels were dispatched to ("avx2", "sse2" or "scalar")
+ */
+const char *isaName();
+
+} // namespace kernels
@@ -1,47 +1,101 @@
 #include "lexer.hpp"
+#include "scan.hpp"
+
+#include <cstring>
+
+// --- Keywords ---
+
+/**
+ * Classify an identifier as a keyword or a plain identifier
+ * Keywords are picked out by length first, so each identifier is compared against at most five
+ * candidates, in place in the source and without building a string.
+ * @param text First character of the identifier
+ * @param length Number of characters in the identifier
+ * @return The keyword's token type, or TOK_IDENTIFIER
+ */
+static TokenType keywordType(const char *text, size_t length) {
+    auto is = [&](const char *keyword) { return std::memcmp(text, keyword, length) == 0; };
+
+    switch (length) {
+    case 2:
+        if (is("IF"))
+            return TOK_IF;
+        if (is("IN"))
+            return TOK_IN;
+        break;
+    case 3:
+        if (is("END"))
+            return TOK_END;
+        if (is("FOR"))
+            return TOK_FOR;
+        if (is("NEW") || is("new"))
+            return TOK_NEW;
+        break;
+    case 4:
+        if (is("THEN"))
+            return TOK_THEN;
+        if (is("ELSE"))
+            return TOK_ELSE;
+        if (is("TRUE") || is("True"))
+            return TOK_TRUE;
+        break;
+    case 5:
+        if (is("PRINT"))
+            return TOK_PRINT;
+        if (is("WHILE"))
+            return TOK_WHILE;
+        if (is("CLASS"))
+            return TOK_CLASS;
+        if (is("FALSE") || is("False"))
+            return TOK_FALSE;
+        break;
+    case 6:
+        if (is("RETURN"))
+            return TOK_RETURN;
+        break;
+    case 7:
+        if (is("METHODS") || is("Methods"))
+            return TOK_METHODS;
+        break;
+    case 8:
+        if (is("FUNCTION"))
+            return TOK_FUNCTION;
+        if (is("PARALLEL"))
+            return TOK_PARALLEL;
+        break;
+    case 10:
+        if (is("ATTRIBUTES") || is("Attributes"))
+            return TOK_ATTRIBUTES;
+        break;
+    }
+    return TOK_IDENTIFIER;
+}
 
 /**
  * Lexer Constructor
- * Initializes the lexer with source code and sets up the keyword mapping.
+ * Initializes the lexer with source code.
  * @param src The source code to tokenize
  * @param errReporter Reference to error reporter for error handling
  */
-Lexer::Lexer(const std::string &src, ErrorReporter &errReporter)
-    : source(src), start(0), current(0), line(1), startLine(1), startColumn(0), column(0),
-      reporter(errReporter) {
+Lexer::Lexer(const std::string &src, ErrorReporter &errReporter) : Lexer(src, errReporter, 1, 0) {
+}
 
-    /**
-     * Initialize the keyword map
-     */
-    keywords["CLASS"]      = TOK_CLASS;
-    keywords["ATTRIBUTES"] = TOK_ATTRIBUTES;
-    keywords["METHODS"]    = TOK_METHODS;
-    keywords["FUNCTION"]   = TOK_FUNCTION;
-    keywords["RETURN"]     = TOK_RETURN;
-    keywords["END"]        = TOK_END;
-    keywords["NEW"]        = TOK_NEW;
-    keywords["PRINT"]      = TOK_PRINT;
-
-    keywords["WHILE"] = TOK_WHILE;
-    keywords["IF"]    = TOK_IF;
-    keywords["THEN"]  = TOK_THEN;
-    keywords["ELSE"]  = TOK_ELSE;
-    keywords["IN"]    = TOK_IN;
-    keywords["FOR"]   = TOK_FOR;
-
-    keywords["TRUE"]  = TOK_TRUE;
-    keywords["FALSE"] = TOK_FALSE;
-
-    keywords["Attributes"] = TOK_ATTRIBUTES;
-    keywords["Methods"]    = TOK_METHODS;
-    keywords["True"]       = TOK_TRUE;
-    keywords["False"]      = TOK_FALSE;
-    keywords["new"]        = TOK_NEW;
+/**
+ * Lexer Constructor for a piece of a larger source
+ * @param src The piece of source code to tokenize
+ * @param errReporter Reference to error reporter for error handling
+ * @param firstLine Line number of the piece's first character
+ * @param firstCol Column of the piece's first character
+ */
+Lexer::Lexer(const std::string &src, ErrorReporter &errReporter, int firstLine, int firstCol)
+    : source(src), start(0), current(0), line(firstLine), startLine(firstLine),
+      startColumn(firstCol), column(firstCol), firstColumn(firstCol), reporter(errReporter) {
 }
 
 /**
  * Main tokenization loop
  * Scans through the entire source code and generates a list of tokens.
+ * The tokens are moved out, so a lexer scans its source once.
  * @return Vector of tokens representing the source code
  */
 std::vector<Token> Lexer::scanTokens() {
@@ -52,7 +106,8 @@ std::vector<Token> Lexer::scanTokens() {
         scanToken();
     }
     tokens.push_back({TOK_EOF, "", line, column, 0});
-    return tokens;
+    offsets.push_back(current);
+    return std::move(tokens);
 }
 
 /**
@@ -77,6 +132,38 @@ char Lexer::advance() {
     return c;
 }
 
+/**
+ * Consume a run of characters found by a scan, keeping line and column as advance() would
+ * Lines are counted here for every newline, as the whitespace and string scanners do.
+ * @param count Number of characters to consume
+ */
+void Lexer::advanceBy(size_t count) {
+    const char *text = source.data() + current;
+    size_t breaks    = scan::newlines(text, count);
+    if (breaks == 0) {
+        column += (int) count;
+    } else {
+        // The column restarts after the last newline
+        size_t lastLine = count;
+        while (text[lastLine - 1] != '\n')
+            lastLine--;
+        line += (int) breaks;
+        column = (int) (count - lastLine);
+    }
+    current += count;
+}
+
+/**
+ * Consume characters up to, but not including, the next newline or the end of the source
+ */
+void Lexer::skipLine() {
+    const char *text = source.data() + current;
+    const char *end  = (const char *) std::memchr(text, '\n', source.size() - current);
+    size_t count     = end ? (size_t) (end - text) : source.size() - current;
+    column += (int) count;
+    current += count;
+}
+
 /**
  * Look at the current character without consuming it
  * @return The current character, or null terminator if at end
@@ -108,7 +195,8 @@ bool Lexer::match(char expected) {
 void Lexer::addToken(TokenType type) {
     std::string text = source.substr(start, current - start);
     int length       = current - start;
-    tokens.push_back({type, text, line, startColumn, length});
+    tokens.push_back({type, std::move(text), line, startColumn, length});
+    offsets.push_back(start);
 }
 
 /**
@@ -118,7 +206,8 @@ void Lexer::addToken(TokenType type) {
  */
 void Lexer::addToken(TokenType type, std::string literal) {
     int length = current - start;
-    tokens.push_back({type, literal, line, startColumn, length});
+    tokens.push_back({type, std::move(literal), line, startColumn, length});
+    offsets.push_back(start);
 }
 
 /**
@@ -134,6 +223,8 @@ void Lexer::reportError(ErrorType type, const std::string &message) {
     }
 
     size_t errorColumn = start - lineStart;
+    if (lineStart == 0)
+        errorColumn += firstColumn; // The first line began before this piece of source
 
     // Calculate the length of the erroneous token
     size_t tokenLength = current - start;
@@ -159,12 +250,10 @@ void Lexer::reportError(ErrorType type, const std::string &message) {
  * @param quoteType The quote character that delimits the string ('\"' or '\'')
  */
 void Lexer::string(char quoteType) {
-    // Consume characters until we find the closing quote
-    while (peek() != quoteType && !isAtEnd()) {
-        if (peek() == '\n')
-            line++; // Track line numbers for multi-line strings
-        advance();
-    }
+    // Consume characters until we find the closing quote, counting lines in multi-line strings
+    const char *body  = source.data() + current;
+    const char *quote = (const char *) std::memchr(body, quoteType, source.size() - current);
+    advanceBy(quote ? (size_t) (quote - body) : source.size() - current);
 
     // Report error if string is never terminated
     if (isAtEnd()) {
@@ -208,21 +297,16 @@ void Lexer::number() {
 /**
  * Scan an identifier or keyword
  * Identifiers can contain alphanumeric characters and underscores
- * Keywords are recognized by lookup in the keyword map
+ * Keywords are recognized by keywordType() without copying the text
  */
 void Lexer::identifier() {
     // Consume all alphanumeric characters and underscores
-    while (isalnum(peek()) || peek() == '_')
-        advance();
-
-    std::string text = source.substr(start, current - start);
-    TokenType type   = TOK_IDENTIFIER;
+    size_t length = scan::identifier(source.data() + current, source.size() - current);
+    column += (int) length;
+    current += length;
 
     // Check if the identifier is actually a reserved keyword
-    if (keywords.find(text) != keywords.end()) {
-        type = keywords[text];
-    }
-    addToken(type);
+    addToken(keywordType(source.data() + start, current - start));
 }
 
 /**
@@ -274,11 +358,8 @@ void Lexer::scanToken() {
         // Division and comments are handled together
         if (match('/')) {
             // A comment goes until the end of the line.
-            // We keep advancing until we hit a newline or EOF.
             // Also don't consume \n since that's consumed elsewhere.
-            while (peek() != '\n' && !isAtEnd()) {
-                advance();
-            }
+            skipLine();
         } else {
             addToken(TOK_DIVIDE);
         }
@@ -289,9 +370,7 @@ void Lexer::scanToken() {
 
     case '#':
         // Other method for comments
-        while (peek() != '\n' && !isAtEnd()) {
-            advance();
-        }
+        skipLine();
         break;
 
     /**
@@ -316,9 +395,12 @@ void Lexer::scanToken() {
     case ' ':
     case '\r':
     case '\t':
+        // Skip the rest of the run, newlines included, in one go
+        advanceBy(scan::whitespace(source.data() + current, source.size() - current));
         break;
     case '\n':
         line++;
+        advanceBy(scan::whitespace(source.data() + current, source.size() - current));
         break;
 
     /**
@@ -4,7 +4,6 @@
 #include <iomanip>
 #include <iostream>
 #include <string>
-#include <unordered_map>
 #include <vector>
 
 #include "errors.hpp"
@@ -38,6 +37,7 @@ enum TokenType {
     TOK_WHILE,
     TOK_FOR,
     TOK_IN,
+    TOK_PARALLEL,
     TOK_PRINT,
 
     // === Operators ===
@@ -121,6 +121,8 @@ struct Token {
             return "KEYWORD(WHILE)";
         case TOK_FOR:
             return "KEYWORD(FOR)";
+        case TOK_PARALLEL:
+            return "KEYWORD(PARALLEL)";
         case TOK_PRINT:
             return "KEYWORD(PRINT)";
 
@@ -189,11 +191,13 @@ private:
     int startColumn;
     // Current column position in the current line (0-indexed)
     int column;
-    // Map of keywords to their token types
-    std::unordered_map<std::string, TokenType> keywords;
+    // Column of the source's first character, when it is a piece of a larger source
+    int firstColumn;
+    // Offset in source where each token starts
+    std::vector<size_t> offsets;
 
-    // Error reporter for communicating issues
-    ErrorReporter reporter;
+    // Error reporter for communicating issues; owned by the caller
+    ErrorReporter &reporter;
 
 public:
     /**
@@ -204,11 +208,28 @@ public:
     Lexer(const std::string &src, ErrorReporter &errReporter);
 
     /**
-     * Scan all tokens from the source code
+     * Construct a lexer for a piece of a larger source, such as a region re-lexed after an edit
+     * Tokens and errors are positioned as if the whole source had been lexed.
+     * @param src The piece to tokenize; it must begin outside any token
+     * @param errReporter Reference to an error reporter for the whole source
+     * @param line Line number of the piece's first character
+     * @param column Column of the piece's first character
+     */
+    Lexer(const std::string &src, ErrorReporter &errReporter, int line, int column);
+
+    /**
+     * Scan all tokens from the source code; call once per lexer, as the tokens are moved out
      * @return Vector of all tokens in the source
      */
     std::vector<Token> scanTokens();
 
+    /**
+     * Offset in the source where each scanned token starts, in the same order as the tokens
+     */
+    const std::vector<size_t> &tokenOffsets() const {
+        return offsets;
+    }
+
 private:
     /**
      * Check if we're at the end of source
@@ -220,6 +241,16 @@ private:
      */
     char advance();
 
+    /**
+     * Consume 'count' characters at once, counting the newlines among them
+     */
+    void advanceBy(size_t count);
+
+    /**
+     * Consume the rest of the current line, leaving its newline
+     */
+    void skipLine();
+
     /**
      * Peek at the current character without consuming
      */
@@ -0,0 +1,33 @@
+#include "limits.hpp"
+
+#include <algorithm>
+
+/**
+ * Start a budget, and the clock for its timeout
+ * @param limits The limits to enforce
+ */
+ExecutionBudget::ExecutionBudget(const ExecutionLimits &limits)
+    : limits(limits), deadline(std::chrono::steady_clock::now() + limits.timeout) {
+}
+
+uint32_t ExecutionBudget::spend(uint32_t steps, const Token &where) {
+    uint64_t taken = stepsTaken.fetch_add(steps, std::memory_order_relaxed) + steps;
+    if (limits.maxSteps > 0 && taken > limits.maxSteps) {
+        throw RuntimeError(where, "Step limit of " + std::to_string(limits.maxSteps) +
+                                      " exceeded; is there an infinite loop?");
+    }
+    if (limits.timeout.count() > 0 && std::chrono::steady_clock::now() >= deadline) {
+        throw RuntimeError(where, "Time limit of " + std::to_string(limits.timeout.count()) +
+                                      " ms exceeded.");
+    }
+    return interval();
+}
+
+uint32_t ExecutionBudget::interval() const {
+    if (limits.maxSteps == 0)
+        return CHECK_INTERVAL;
+    uint64_t taken = stepsTaken.load(std::memory_order_relaxed);
+    if (taken >= limits.maxSteps)
+        return 1;
+    return (uint32_t) std::min<uint64_t>(CHECK_INTERVAL, limits.maxSteps - taken + 1);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "runtime.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * ExecutionLimits - resource caps for running untrusted programs; 0 disables a limit
+ */
+struct ExecutionLimits {
+    uint64_t maxSteps                 = 0; // Loop iterations plus function calls
+    size_t maxMemory                  = 0; // Bytes held by lists, objects and strings
+    std::chrono::milliseconds timeout = std::chrono::milliseconds(0);
+};
+
+/**
+ * ExecutionBudget - what one run of a program has left of its step and time limits
+ *
+ * Interpreters count steps locally and only report them here every CHECK_INTERVAL steps, which
+ * is also when the clock is read, so a limit costs one decrement and branch per loop iteration
+ * or call. The budget is shared with the workers of PARALLEL FOR loops, so it counts atomically.
+ */
+class ExecutionBudget {
+public:
+    static constexpr uint32_t CHECK_INTERVAL = 1024;
+
+    explicit ExecutionBudget(const ExecutionLimits &limits);
+
+    /**
+     * Record 'steps' more steps, then check the step and time limits
+     * @param where The token any error is reported at
+     * @return The number of steps that may be taken before the next check
+     * @throws RuntimeError at 'where' if a limit has been passed
+     */
+    uint32_t spend(uint32_t steps, const Token &where);
+
+    /**
+     * Steps that may be taken before the next check; stops exactly one past the step limit
+     */
+    uint32_t interval() const;
+
+private:
+    ExecutionLimits limits;
+    std::chrono::steady_clock::time_point deadline;
+    std::atomic<uint64_t> stepsTaken{0};
+};
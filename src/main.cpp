@@ -1,5 +1,6 @@
 #include "main.hpp"
 #include "ast_printer.hpp"
+#include "transpiler.hpp"
 
 /**
  * Read the entire contents of a file into a string
@@ -19,121 +20,268 @@ std::string Pseudocode::readFile(const std::string &path) {
 }
 
 /**
- * Print a formatted table of tokens to stdout
+ * Print a formatted table of tokens
  * Displays token type, lexeme, and line number for debugging
  * @param tokens The vector of tokens to display
+ * @param out The stream to print the table to
  */
-void Pseudocode::printTokenTable(const std::vector<Token> &tokens) {
+void Pseudocode::printTokenTable(const std::vector<Token> &tokens, std::ostream &out) {
     // Print table header with column alignment
-    std::cout << std::left << std::setw(20) << "TOKEN TYPE" << std::setw(25) << "LEXEME" << "LINE"
-              << std::endl;
-    std::cout << std::string(60, '-') << std::endl;
+    out << std::left << std::setw(20) << "TOKEN TYPE" << std::setw(25) << "LEXEME" << "LINE"
+        << std::endl;
+    out << std::string(60, '-') << std::endl;
 
     // Print each token as a table row
     for (const Token &token : tokens) {
         if (token.type == TOK_EOF)
             break; // Don't display EOF token
-        std::cout << std::left << std::setw(20) << token.typeToString() << std::setw(25)
+        out << std::left << std::setw(20) << token.typeToString() << std::setw(25)
                   << (token.lexeme.empty() ? "N/A" : token.lexeme) << token.line << std::endl;
     }
 }
 
 /**
- * Run the interpreter on a file
- * Reads the file, tokenizes it, and displays the token table
- * @param path Path to the pseudocode file to execute
+ * Lex, parse and run one program in a fresh interpreter
+ * Nothing here is shared between calls, so several programs can run at once on different threads.
+ * @param name File name shown in error reports
+ * @param source The program text
+ * @param out Stream for PRINT output and the debug token table and AST
+ * @param err Stream for lexing, parsing and runtime errors and the parser trace
  * @return 0 on success, 1 on error
  */
-int Pseudocode::runFile(const std::string &path) {
+int Pseudocode::runSource(const std::string &name, const std::string &source, std::ostream &out,
+                          std::ostream &err) const {
     try {
-        std::string source = readFile(path);
-
         // Initialize error reporting at the lexing stage
         InterpreterStage stage = InterpreterStage::Lexing;
-        ErrorReporter reporter(stage, path, source);
-        Lexer lexer(source, reporter);
-
-        // Tokenize the source code
-        std::vector<Token> tokens = lexer.scanTokens();
-        if (debugTokens)
-            printTokenTable(tokens);
-
-        // Parse tokens
-        stage = InterpreterStage::Parsing;
-        Parser parser(tokens, source, reporter);
-        std::vector<StmtPtr> statements = parser.parse();
+        ErrorReporter reporter(stage, name, source, err);
+
+        // An unchanged program is loaded from its cache instead of being lexed and parsed.
+        // The token table and parser trace only exist when parsing, so they bypass the cache.
+        std::vector<StmtPtr> statements;
+        std::string cachePath = AstCache::pathFor(name);
+        bool cached           = useCache && !debugTokens && !debugTrace &&
+                      AstCache::load(cachePath, source, statements);
+
+        if (!cached) {
+            // Tokenize the source code
+            Lexer lexer(source, reporter);
+            std::vector<Token> tokens = lexer.scanTokens();
+            if (debugTokens)
+                printTokenTable(tokens, out);
+
+            // Parse tokens
+            stage = InterpreterStage::Parsing;
+            Parser parser(tokens, source, reporter);
+            if (debugTrace)
+                parser.trace = &err;
+            statements = parser.parse();
+
+            // Programs with errors are never cached, so their errors are reported every run
+            if (useCache && !reporter.hadError())
+                AstCache::save(cachePath, source, statements);
+        }
         if (debugParse) {
-            ASTPrinter printer;
+            ASTPrinter printer(out);
             printer.print(statements);
         }
 
         // Interpret the parsed statements
         stage = InterpreterStage::Runtime;
         Interpreter interpreter;
-        interpreter.interpret(statements);
+        options.configure(interpreter);
+        interpreter.output      = &out;
+        interpreter.errorOutput = &err;
+        // A program the parser recovered from still runs, but does not count as a success
+        if (!interpreter.interpret(statements) || reporter.hadError())
+            return 1;
+    } catch (const std::exception &e) {
+        err << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Run the interpreter on a file
+ * Reads the file, then lexes, parses and runs it with output on stdout and errors on stderr
+ * @param path Path to the pseudocode file to execute
+ * @return 0 on success, 1 on error
+ */
+int Pseudocode::runFile(const std::string &path) {
+    std::string source;
+    try {
+        source = readFile(path);
     } catch (const std::exception &e) {
         std::cerr << e.what() << std::endl;
         return 1;
     }
+    return runSource(path, source, std::cout, std::cerr);
+}
+
+/**
+ * Compile a script to C++ with the AOT transpiler
+ * Lexing and parsing errors are reported as when running the script, and nothing is written.
+ * @param path Path to the pseudocode file
+ * @param target Path of the C++ file written
+ * @return 0 on success, 1 on error
+ */
+int Pseudocode::emitCpp(const std::string &path, const std::string &target) {
+    try {
+        auto program = Program::compile(readFile(path), path);
+        CppEmitter emitter(path);
+        std::string cpp = emitter.emit(program->statements());
 
+        std::ofstream file(target);
+        if (!file || !(file << cpp)) {
+            throw std::runtime_error("Could not write file: " + target);
+        }
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
     return 0;
 }
 
+/**
+ * Run every .scsa file under a directory on a pool of worker threads
+ * Scripts share nothing but the read-only standard library, so each one runs in its own
+ * Interpreter with its output captured in memory. Captured output is printed in file name
+ * order once every script has finished, so results are the same whatever the job count.
+ * @param directory Directory searched (recursively) for scripts
+ * @param jobs Number of scripts run at once; 0 uses one per hardware thread
+ * @return 0 if every script succeeded, 1 otherwise
+ */
+int Pseudocode::runBatch(const std::string &directory, size_t jobs) const {
+    namespace fs = std::filesystem;
+    using Clock  = std::chrono::steady_clock;
+
+    std::vector<std::string> paths;
+    try {
+        for (const auto &entry : fs::recursive_directory_iterator(directory)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".scsa")
+                paths.push_back(entry.path().string());
+        }
+    } catch (const fs::filesystem_error &e) {
+        std::cerr << "Could not read directory: " << directory << " (" << e.what() << ")"
+                  << std::endl;
+        return 1;
+    }
+    std::sort(paths.begin(), paths.end());
+
+    struct Result {
+        int status         = 0;
+        double milliseconds = 0;
+        std::string output;
+        std::string errors;
+    };
+    std::vector<Result> results(paths.size());
+
+    ThreadPool pool(jobs);
+    Clock::time_point batchStart = Clock::now();
+
+    pool.parallelFor(paths.size(), [&](size_t index, size_t) {
+        Result &result = results[index];
+        std::ostringstream out, err;
+        Clock::time_point start = Clock::now();
+        try {
+            result.status = runSource(paths[index], readFile(paths[index]), out, err);
+        } catch (const std::exception &e) {
+            err << e.what() << std::endl;
+            result.status = 1;
+        }
+        result.milliseconds =
+            std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        result.output = out.str();
+        result.errors = err.str();
+    });
+
+    double total = std::chrono::duration<double, std::milli>(Clock::now() - batchStart).count();
+
+    // Print each script's results in order, then a summary
+    size_t failed = 0;
+    std::cout << std::fixed << std::setprecision(1);
+    for (size_t i = 0; i < paths.size(); ++i) {
+        const Result &result = results[i];
+        if (result.status != 0)
+            failed++;
+        std::cout << "=== " << paths[i] << ": " << (result.status == 0 ? "ok" : "failed")
+                  << " (exit " << result.status << ", " << result.milliseconds << " ms) ==="
+                  << std::endl;
+        std::cout << result.output << std::flush;
+        std::cerr << result.errors << std::flush;
+    }
+    std::cout << "Ran " << paths.size() << " scripts on " << pool.size() << " threads in "
+              << total << " ms: " << paths.size() - failed << " passed, " << failed << " failed"
+              << std::endl;
+
+    return failed == 0 ? 0 : 1;
+}
+
 /**
  * Run an interactive REPL (Read-Eval-Print-Loop)
  * Allows users to input pseudocode lines interactively
- * Each line is tokenized, parsed, and executed
+ * Each entry is tokenized, parsed, and executed once it is complete; an unfinished FUNCTION,
+ * CLASS, IF or loop keeps reading lines until its END (or a blank line)
  * @return Always returns 0
  */
 int Pseudocode::runRepl() {
-    InterpreterStage stage = InterpreterStage::Lexing;
-
     std::cout << "Interactive SCSA Pseudocode Interpreter" << std::endl;
     std::cout << "For help type run this program with '--help' or '-h'" << std::endl;
     std::cout << "Type 'exit' to quit" << std::endl;
 
     // Make an interpreter to keep state across this session
     Interpreter interpreter;
-    std::vector<StmtPtr> statements;
+    options.configure(interpreter);
+
+    // Every entry's AST is kept, since functions declared in it keep pointing into it
+    std::vector<std::vector<StmtPtr>> history;
+
+    // The entry being typed; each new line only re-parses the unfinished statement before it
+    IncrementalParser entry;
+    if (debugTrace)
+        entry.trace = &std::cerr;
 
     std::string line;
     while (true) {
         // Display prompt and read a line of input
-        std::cout << "[SCSA] >> " << std::flush;
+        std::cout << (entry.source().empty() ? "[SCSA] >> " : "[SCSA] .. ") << std::flush;
         if (!std::getline(std::cin, line))
             break;
-        if (line.empty())
-            continue;
-        if (line == "exit")
-            break;
-
-        // Create a new ErrorReporter for each line with the current source
-        ErrorReporter reporter(stage, "", line);
+        if (entry.source().empty()) {
+            if (line.empty())
+                continue;
+            if (line == "exit")
+                break;
+        }
 
         try {
-            // Tokenize the input line
-            stage = InterpreterStage::Lexing;
-            Lexer lexer(line, reporter);
-            std::vector<Token> tokens = lexer.scanTokens();
-            if (debugTokens)
-                printTokenTable(tokens);
+            entry.edit(entry.source().size(), 0, line + "\n");
+            if (entry.incomplete() && !line.empty())
+                continue;
 
-            // Parse tokens
-            stage = InterpreterStage::Parsing;
-            Parser parser(tokens, line, reporter);
-            std::vector<StmtPtr> parsed = parser.parse();
+            std::cerr << entry.diagnostics();
+            if (debugTokens) {
+                InterpreterStage stage = InterpreterStage::Lexing;
+                std::ostringstream ignored;
+                ErrorReporter reporter(stage, "", entry.source(), ignored);
+                printTokenTable(Lexer(entry.source(), reporter).scanTokens());
+            }
+            history.push_back(entry.take());
+            const std::vector<StmtPtr> &parsed = history.back();
             if (debugParse) {
                 ASTPrinter printer;
                 printer.print(parsed);
             }
 
             // Execute parsed statements using the same interpreter instance
-            stage = InterpreterStage::Runtime;
             interpreter.interpret(parsed);
 
         } catch (const std::exception &e) {
             // Display error without crashing the REPL
             std::cerr << e.what() << std::endl;
+            entry.take();
         }
     }
 
@@ -2,6 +2,9 @@
 
 #include <algorithm>
 #include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
@@ -9,10 +12,14 @@
 #include <string>
 #include <vector>
 
+#include "ast_cache.hpp"
 #include "errors.hpp"
+#include "incremental.hpp"
 #include "interpreter.hpp"
 #include "lexer.hpp"
 #include "parser.hpp"
+#include "scsa.hpp"
+#include "thread_pool.hpp"
 
 #ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
@@ -33,6 +40,16 @@ public:
      */
     int runFile(const std::string &path);
 
+    /**
+     * Run every .scsa file under a directory in this process, several scripts at a time
+     * Each script gets its own Interpreter and captured output. Results are printed in file
+     * name order with each script's status and run time, followed by a summary.
+     * @param directory Directory searched (recursively) for scripts
+     * @param jobs Number of scripts run at once; 0 uses one per hardware thread
+     * @return 0 if every script succeeded, 1 otherwise
+     */
+    int runBatch(const std::string &directory, size_t jobs) const;
+
     /**
      * Run an interactive REPL (Read-Eval-Print-Loop)
      * Allows users to type pseudocode lines and see tokenization
@@ -40,12 +57,36 @@ public:
      */
     int runRepl();
 
+    /**
+     * Compile a script to a standalone C++ program instead of running it (see transpiler.hpp)
+     * @param path Path to the pseudocode file
+     * @param target Path of the C++ file written
+     * @return 0 on success, 1 if the script has errors or uses an unsupported construct
+     */
+    static int emitCpp(const std::string &path, const std::string &target);
+
     /**
      * Optional debug modes for debugging tokenization and parsing
      */
     bool debugTokens = false; // Print token table after Lexing
     bool debugParse  = false; // Print AST after Parsing
+    bool debugTrace  = false; // Trace parsing functions as they run
+    bool useCache    = true;  // Load and save parsed programs in .scsac files
+
+    // Engine, memoization and limit settings for every program run
+    RunOptions options;
 private:
+    /**
+     * Lex, parse and run one program in a fresh interpreter
+     * @param name File name shown in error reports
+     * @param source The program text
+     * @param out Stream for PRINT output and debug tables
+     * @param err Stream for lexing, parsing and runtime errors and the parser trace
+     * @return 0 on success, 1 on error
+     */
+    int runSource(const std::string &name, const std::string &source, std::ostream &out,
+                  std::ostream &err) const;
+
     /**
      * Read entire file contents into a string
      * @param path Path to the file to read
@@ -56,15 +97,39 @@ private:
     /**
      * Print tokens in a formatted table
      * @param tokens Vector of tokens to display
+     * @param out Stream to print the table to
      */
-    static void printTokenTable(const std::vector<Token> &tokens);
+    static void printTokenTable(const std::vector<Token> &tokens, std::ostream &out = std::cout);
 };
 
 void help() {
-    std::cout << "Usage: scsa [--debug-tokens] [--debug-parse] [script.scsa]" << std::endl;
+    std::cout << "Usage: scsa [options] [script.scsa]" << std::endl;
+    std::cout << "       scsa [options] --batch dir [-j N]" << std::endl;
     std::cout << "Options:" << std::endl;
     std::cout << "  --debug-tokens   Print token table after lexing" << std::endl;
     std::cout << "  --debug-parse    Print AST after parsing" << std::endl;
+    std::cout << "  --debug-trace    Trace parser functions as they run" << std::endl;
+    std::cout << "  --vm             Run on the stack VM (deep recursion limited only by memory)"
+              << std::endl;
+    std::cout << "  --no-jit         Never compile hot numeric functions to native code"
+              << std::endl;
+    std::cout << "  --emit-cpp FILE  Translate the script to C++ in FILE instead of running it"
+              << std::endl;
+    std::cout << "  --memoize        Cache results of pure functions" << std::endl;
+    std::cout << "  --memo-size N    Keep at most N cached results (default 10000)" << std::endl;
+    std::cout << "  --threads N      Run PARALLEL FOR loops on N threads (default: all cores)"
+              << std::endl;
+    std::cout << "  --max-depth N    Limit nested calls to N (default 1000, 1000000 with --vm)"
+              << std::endl;
+    std::cout << "  --max-steps N    Stop a program after N loop iterations and calls" << std::endl;
+    std::cout << "  --max-memory MB  Stop a program whose lists, objects and strings pass MB "
+                 "megabytes"
+              << std::endl;
+    std::cout << "  --timeout MS     Stop a program after MS milliseconds" << std::endl;
+    std::cout << "  --no-cache       Always parse; don't read or write .scsac cache files"
+              << std::endl;
+    std::cout << "  --batch DIR      Run every .scsa file under DIR in one process" << std::endl;
+    std::cout << "  -j, --jobs N     Run N batch scripts at once (default: all cores)" << std::endl;
     std::cout << "If no script is provided, an interactive REPL is started." << std::endl;
 }
 
@@ -87,6 +152,9 @@ int main(int argc, char *argv[]) {
 #endif
 
     Pseudocode pseudocode;
+    std::string batchDirectory;
+    std::string cppTarget;
+    size_t batchJobs = 0;
 
     if (argc > 1 && (std::string(argv[1]) == "--help" || std::string(argv[1]) == "-h")) {
         help();
@@ -100,18 +168,67 @@ int main(int argc, char *argv[]) {
             pseudocode.debugTokens = true;
         } else if (arg == "--debug-parse") {
             pseudocode.debugParse = true;
+        } else if (arg == "--debug-trace") {
+            pseudocode.debugTrace = true;
+        } else if (arg == "--no-cache") {
+            pseudocode.useCache = false;
+        } else if (arg == "--vm") {
+            pseudocode.options.useVM = true;
+        } else if (arg == "--no-jit") {
+            pseudocode.options.useJit = false;
+        } else if (arg == "--memoize") {
+            pseudocode.options.memoize = true;
+        } else if (arg == "--memo-size" && i + 1 < argc) {
+            pseudocode.options.memoize  = true;
+            pseudocode.options.memoSize = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            int threads = std::atoi(argv[++i]);
+            if (threads <= 0) {
+                help();
+                return 1;
+            }
+            ThreadPool::setSharedSize(threads);
+        } else if (arg == "--max-depth" && i + 1 < argc) {
+            pseudocode.options.maxCallDepth = std::atoi(argv[++i]);
+            if (pseudocode.options.maxCallDepth <= 0) {
+                help();
+                return 1;
+            }
+        } else if (arg == "--max-steps" && i + 1 < argc) {
+            pseudocode.options.limits.maxSteps = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--max-memory" && i + 1 < argc) {
+            pseudocode.options.limits.maxMemory =
+                std::strtoull(argv[++i], nullptr, 10) * 1024 * 1024;
+        } else if (arg == "--timeout" && i + 1 < argc) {
+            pseudocode.options.limits.timeout =
+                std::chrono::milliseconds(std::atoll(argv[++i]));
+        } else if (arg == "--emit-cpp" && i + 1 < argc) {
+            cppTarget = argv[++i];
+        } else if (arg == "--batch" && i + 1 < argc) {
+            batchDirectory = argv[++i];
+        } else if ((arg == "-j" || arg == "--jobs") && i + 1 < argc) {
+            int jobs = std::atoi(argv[++i]);
+            if (jobs <= 0) {
+                help();
+                return 1;
+            }
+            batchJobs = jobs;
         } else {
             // If file ends in .scsa then treat as script
             if (arg.size() < 5 || arg.substr(arg.size() - 5) != ".scsa") {
                 help();
                 return 1;
+            } else if (!cppTarget.empty()) {
+                return Pseudocode::emitCpp(arg, cppTarget);
             } else {
                 return pseudocode.runFile(arg);
             }
         }
     }
 
-    if (argc == 1) {
-        return pseudocode.runRepl();
-    }
+    if (!batchDirectory.empty())
+        return pseudocode.runBatch(batchDirectory, batchJobs);
+
+    // No script given: options such as --vm apply to the REPL session
+    return pseudocode.runRepl();
 }
@@ -0,0 +1,324 @@
+#include "memo.hpp"
+#include "interpreter.hpp"
+
+#include <algorithm>
+
+// --- Purity Analysis ---
+
+/**
+ * Walks a function body recording what it assigns, reads and calls
+ * Anything that could observe or change state outside the call marks the body impure.
+ */
+class PurityAnalyzer : public ExprVisitor, public StmtVisitor {
+public:
+    bool pure = true;
+    std::set<std::string> assigned;
+    std::set<std::string> reads;
+    std::set<std::string> calls;
+
+    void analyze(const std::vector<StmtPtr> &statements) {
+        for (const auto &stmt : statements) {
+            if (stmt)
+                stmt->accept(*this);
+        }
+    }
+
+    // --- ExprVisitor Implementation ---
+    void visitLiteralExpr(LiteralExpr *) override {
+    }
+    void visitVariableExpr(VariableExpr *expr) override {
+        reads.insert(expr->name.lexeme);
+    }
+    void visitAssignExpr(AssignExpr *expr) override {
+        expr->value->accept(*this);
+        if (auto varExpr = dynamic_cast<VariableExpr *>(expr->target.get())) {
+            assigned.insert(varExpr->name.lexeme);
+        } else {
+            // Fields and elements can only belong to lists and instances built by this call,
+            // since arguments are primitives and outer variables are never read
+            expr->target->accept(*this);
+        }
+    }
+    void visitBinaryExpr(BinaryExpr *expr) override {
+        expr->left->accept(*this);
+        expr->right->accept(*this);
+    }
+    void visitCallExpr(CallExpr *expr) override {
+        if (auto varExpr = dynamic_cast<VariableExpr *>(expr->callee.get())) {
+            calls.insert(varExpr->name.lexeme);
+        } else {
+            expr->callee->accept(*this);
+        }
+        for (const auto &arg : expr->args) {
+            arg->accept(*this);
+        }
+    }
+    void visitGetExpr(GetExpr *expr) override {
+        expr->object->accept(*this);
+    }
+    void visitArrayAccessExpr(ArrayAccessExpr *expr) override {
+        expr->array->accept(*this);
+        expr->index->accept(*this);
+    }
+    void visitArrayLitExpr(ArrayLitExpr *expr) override {
+        for (const auto &el : expr->elements) {
+            el->accept(*this);
+        }
+    }
+    void visitSliceExpr(SliceExpr *expr) override {
+        expr->array->accept(*this);
+        if (expr->start)
+            expr->start->accept(*this);
+        if (expr->end)
+            expr->end->accept(*this);
+    }
+    void visitNewExpr(NewExpr *expr) override {
+        // Instantiating a class only allocates a fresh instance
+        for (const auto &arg : expr->args) {
+            arg->accept(*this);
+        }
+    }
+
+    // --- StmtVisitor Implementation ---
+    void visitExpressionStmt(ExpressionStmt *stmt) override {
+        stmt->expression->accept(*this);
+    }
+    void visitPrintStmt(PrintStmt *) override {
+        pure = false;
+    }
+    void visitReturnStmt(ReturnStmt *stmt) override {
+        if (stmt->value)
+            stmt->value->accept(*this);
+    }
+    void visitBlockStmt(BlockStmt *stmt) override {
+        analyze(stmt->statements);
+    }
+    void visitIfStmt(IfStmt *stmt) override {
+        stmt->condition->accept(*this);
+        analyze(stmt->thenBranch);
+        analyze(stmt->elseBranch);
+    }
+    void visitWhileStmt(WhileStmt *stmt) override {
+        stmt->condition->accept(*this);
+        analyze(stmt->body);
+    }
+    void visitFunctionStmt(FunctionStmt *) override {
+        // Nested declarations capture the call's scope
+        pure = false;
+    }
+    void visitClassStmt(ClassStmt *) override {
+        pure = false;
+    }
+    void visitForInStmt(ForInStmt *stmt) override {
+        assigned.insert(stmt->variable.lexeme);
+        stmt->iterable->accept(*this);
+        analyze(stmt->body);
+    }
+};
+
+const MemoCache::FunctionFacts &MemoCache::factsFor(FunctionStmt *function) {
+    auto found = facts.find(function);
+    if (found != facts.end())
+        return found->second;
+
+    PurityAnalyzer analyzer;
+    analyzer.analyze(function->body);
+
+    std::set<std::string> own = analyzer.assigned;
+    for (const auto &param : function->params) {
+        own.insert(param.lexeme);
+    }
+
+    FunctionFacts result;
+    result.pure = analyzer.pure;
+    // Reading an outer variable makes the result depend on state other than the arguments
+    for (const auto &name : analyzer.reads) {
+        if (!own.count(name))
+            result.pure = false;
+    }
+    for (const auto &name : analyzer.assigned) {
+        if (std::find_if(function->params.begin(), function->params.end(),
+                         [&](const Token &param) { return param.lexeme == name; }) ==
+            function->params.end())
+            result.locals.push_back(name);
+    }
+    for (const auto &name : analyzer.calls) {
+        if (!own.count(name))
+            result.calls.push_back(name);
+    }
+    return facts[function] = std::move(result);
+}
+
+bool MemoCache::Dependency::holds() const {
+    const auto &values = scope->getValues();
+    auto found         = values.find(name);
+    if (local)
+        return found == values.end();
+    Callable *current = nullptr;
+    if (found != values.end() && found->second.is<std::shared_ptr<Callable>>())
+        current = found->second.as<std::shared_ptr<Callable>>().get();
+    return current == target.get();
+}
+
+/**
+ * Decide whether 'function' and everything it can call are pure
+ * Each global name looked up is recorded in 'resolution', including the one that made the
+ * function impure, so a later rebinding of any of them is noticed.
+ */
+bool MemoCache::isPure(LoxFunction &function, Resolution &resolution,
+                       std::set<LoxFunction *> &seen) {
+    // Recursive calls are pure if the rest of the cycle is
+    if (!seen.insert(&function).second)
+        return true;
+    // Only top-level functions: nested closures could resolve their callees differently
+    if (function.closure->getEnclosing())
+        return false;
+
+    const FunctionFacts &info = factsFor(function.declaration);
+    if (!info.pure)
+        return false;
+
+    // Assigning a name that already exists outside the function would update it in place
+    for (const auto &local : info.locals) {
+        resolution.dependencies.push_back({function.closure, local, true, nullptr});
+        if (!resolution.dependencies.back().holds())
+            return false;
+    }
+
+    const auto &values = function.closure->getValues();
+    for (const auto &call : info.calls) {
+        auto found = values.find(call);
+        std::shared_ptr<Callable> callee;
+        if (found != values.end() && found->second.is<std::shared_ptr<Callable>>())
+            callee = found->second.as<std::shared_ptr<Callable>>();
+        resolution.dependencies.push_back({function.closure, call, false, callee});
+
+        if (auto native = dynamic_cast<NativeFunction *>(callee.get())) {
+            if (!native->isPure())
+                return false;
+        } else if (auto lox = dynamic_cast<LoxFunction *>(callee.get())) {
+            if (!isPure(*lox, resolution, seen))
+                return false;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+const MemoCache::Resolution &MemoCache::resolve(LoxFunction &function) {
+    auto found = resolutions.find(function.declaration);
+    if (found != resolutions.end() && found->second.closure == function.closure &&
+        std::all_of(found->second.dependencies.begin(), found->second.dependencies.end(),
+                    [](const Dependency &dependency) { return dependency.holds(); }))
+        return found->second;
+
+    Resolution resolution;
+    resolution.generation = ++generations;
+    resolution.closure    = function.closure;
+    std::set<LoxFunction *> seen;
+    resolution.pure = isPure(function, resolution, seen);
+    return resolutions[function.declaration] = std::move(resolution);
+}
+
+// --- Cache ---
+
+static bool isPrimitive(const RuntimeValue &value) {
+    return value.is<std::monostate>() || value.is<double>() || value.is<bool>() ||
+           value.is<std::string>();
+}
+
+static size_t textBytes(const RuntimeValue &value) {
+    return value.is<std::string>() ? value.as<std::string>().size() : 0;
+}
+
+static size_t hashPrimitive(const RuntimeValue &value) {
+    size_t seed = value.value.index();
+    if (value.is<double>()) {
+        double number = value.as<double>();
+        // -0 and 0 compare equal, so they must hash equally
+        seed ^= std::hash<double>{}(number == 0 ? 0.0 : number);
+    } else if (value.is<bool>()) {
+        seed ^= std::hash<bool>{}(value.as<bool>());
+    } else if (value.is<std::string>()) {
+        seed ^= std::hash<std::string>{}(value.as<std::string>());
+    }
+    return seed;
+}
+
+static bool samePrimitive(const RuntimeValue &a, const RuntimeValue &b) {
+    if (a.value.index() != b.value.index())
+        return false;
+    if (a.is<double>())
+        return a.as<double>() == b.as<double>();
+    if (a.is<bool>())
+        return a.as<bool>() == b.as<bool>();
+    if (a.is<std::string>())
+        return a.as<std::string>() == b.as<std::string>();
+    return true;
+}
+
+bool MemoCache::KeyEqual::operator()(const MemoKey *a, const MemoKey *b) const {
+    if (a->function != b->function || a->generation != b->generation ||
+        a->args.size() != b->args.size())
+        return false;
+    for (size_t i = 0; i < a->args.size(); ++i) {
+        if (!samePrimitive(a->args[i], b->args[i]))
+            return false;
+    }
+    return true;
+}
+
+bool MemoCache::prepare(LoxFunction &function, const RuntimeValue *args, size_t argc,
+                        MemoKey &key) {
+    for (size_t i = 0; i < argc; ++i) {
+        if (!isPrimitive(args[i]))
+            return false;
+    }
+    const Resolution &resolution = resolve(function);
+    if (!resolution.pure)
+        return false;
+
+    key.function   = function.declaration;
+    key.generation = resolution.generation;
+    key.args.assign(args, args + argc);
+    key.hash = std::hash<FunctionStmt *>{}(function.declaration) ^ resolution.generation;
+    for (size_t i = 0; i < argc; ++i) {
+        key.hash = key.hash * 31 + hashPrimitive(args[i]);
+    }
+    return true;
+}
+
+const RuntimeValue *MemoCache::find(const MemoKey &key) {
+    auto found = index.find(&key);
+    if (found == index.end())
+        return nullptr;
+    // Move to the front; list iterators (and so the index) stay valid
+    entries.splice(entries.begin(), entries, found->second);
+    return &found->second->result;
+}
+
+void MemoCache::store(MemoKey key, const RuntimeValue &result) {
+    if (capacity == 0 || !isPrimitive(result) || find(key))
+        return;
+
+    if (entries.size() >= capacity) {
+        index.erase(&entries.back().key);
+        entries.pop_back();
+    }
+
+    HeapCharge charge;
+    if (charge.active()) {
+        size_t bytes = textBytes(result);
+        for (const auto &arg : key.args) {
+            bytes += textBytes(arg);
+        }
+        try {
+            charge.resize(bytes);
+        } catch (const NativeError &) {
+            return; // Better to recompute later than to stop the program over a cache entry
+        }
+    }
+    entries.push_front({std::move(key), result, std::move(charge)});
+    index.emplace(&entries.front().key, entries.begin());
+}
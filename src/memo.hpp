@@ -0,0 +1,112 @@
+#pragma once
+
+#include "ast.hpp"
+#include "runtime.hpp"
+
+#include <cstdint>
+#include <list>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class LoxFunction;
+
+/**
+ * MemoKey - identifies one call of a pure function
+ * Only primitive arguments (nil, numbers, booleans, strings) can form a key. The generation
+ * names the callees the function resolved to, so rebinding one never reuses older results.
+ */
+struct MemoKey {
+    FunctionStmt *function = nullptr;
+    uint64_t generation    = 0;
+    std::vector<RuntimeValue> args;
+    size_t hash = 0;
+};
+
+/**
+ * MemoCache - bounded LRU cache of pure function results (enabled with --memoize)
+ *
+ * A function is memoized only when a purity analysis of its body proves that the result
+ * depends on nothing but its arguments: it may not print, declare functions or classes, read
+ * variables from enclosing scopes, or call anything that is not itself pure. Only primitive
+ * results are cached, so callers never share a mutable list or instance.
+ *
+ * The verdict for a function is worked out once, recording every global name it looked up on
+ * the way. Later calls only check that those names are still bound as they were, and resolve
+ * the function again under a new generation when one is not.
+ */
+class MemoCache {
+public:
+    explicit MemoCache(size_t capacity) : capacity(capacity) {
+    }
+
+    /**
+     * Build the cache key for calling 'function' with 'args'
+     * @return false if this call cannot be memoized (impure function or non-primitive argument)
+     */
+    bool prepare(LoxFunction &function, const RuntimeValue *args, size_t argc, MemoKey &key);
+
+    /**
+     * Look up a cached result, marking it as recently used
+     * @return The result, or nullptr on a miss
+     */
+    const RuntimeValue *find(const MemoKey &key);
+
+    /**
+     * Cache a result, evicting the least recently used entry when full
+     */
+    void store(MemoKey key, const RuntimeValue &result);
+
+private:
+    // What the purity analysis found out about a function body
+    struct FunctionFacts {
+        bool pure = true;
+        std::vector<std::string> locals;  // Names the body assigns; must not resolve outside it
+        std::vector<std::string> calls;  // Free names the body calls; must be pure callables
+    };
+
+    // A global name the verdict was reached on, and what it had to stay bound to
+    struct Dependency {
+        std::shared_ptr<Environment> scope;
+        std::string name;
+        bool local = false;               // Assigned by the body, so it must stay undefined
+        std::shared_ptr<Callable> target; // The callable it named; null if it named none
+
+        bool holds() const;
+    };
+
+    // Whether a function is pure, and the bindings across all it can call that this rests on
+    struct Resolution {
+        bool pure           = false;
+        uint64_t generation = 0;
+        std::shared_ptr<Environment> closure;
+        std::vector<Dependency> dependencies;
+    };
+
+    struct KeyHash {
+        size_t operator()(const MemoKey *key) const {
+            return key->hash;
+        }
+    };
+    struct KeyEqual {
+        bool operator()(const MemoKey *a, const MemoKey *b) const;
+    };
+
+    struct Entry {
+        MemoKey key;
+        RuntimeValue result;
+        HeapCharge charge; // Text of the strings in the key and result, when memory is limited
+    };
+
+    size_t capacity;
+    std::list<Entry> entries; // Most recently used first
+    std::unordered_map<const MemoKey *, std::list<Entry>::iterator, KeyHash, KeyEqual> index;
+    std::unordered_map<FunctionStmt *, FunctionFacts> facts;
+    std::unordered_map<FunctionStmt *, Resolution> resolutions;
+    uint64_t generations = 0;
+
+    const FunctionFacts &factsFor(FunctionStmt *function);
+    const Resolution &resolve(LoxFunction &function);
+    bool isPure(LoxFunction &function, Resolution &resolution, std::set<LoxFunction *> &seen);
+};
@@ -0,0 +1,202 @@
+#include "interpreter.hpp"
+#include "thread_pool.hpp"
+
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <sstream>
+
+// --- Shared State Freezing ---
+
+/**
+ * SharedStateFreezer - makes everything reachable from a scope read-only while it lives
+ *
+ * The iterations of a PARALLEL FOR loop read outer variables and collections from several
+ * threads at once. Freezing them turns any write into a RuntimeError instead of a data race,
+ * and lets the readers go without locks. Objects are thawed again when the loop finishes.
+ */
+class SharedStateFreezer {
+public:
+    void freeze(const std::shared_ptr<Environment> &scope) {
+        pendingScopes.push_back(scope.get());
+        drain();
+    }
+
+    void freeze(const RuntimeValue &value) {
+        pendingValues.push_back(value);
+        drain();
+    }
+
+    ~SharedStateFreezer() {
+        for (Environment *env : environments)
+            env->setFrozen(false);
+        for (Array *array : arrays)
+            array->setFrozen(false);
+        for (HashTable *table : tables)
+            table->setFrozen(false);
+        for (Instance *instance : instances)
+            instance->frozen = false;
+    }
+
+private:
+    // Everything frozen here is reachable from the loop's scope, which outlives the freezer
+    std::vector<Environment *> environments;
+    std::vector<Array *> arrays;
+    std::vector<HashTable *> tables;
+    std::vector<Instance *> instances;
+
+    // Worklists, so deeply nested structures never recurse on the native stack
+    std::vector<Environment *> pendingScopes;
+    std::vector<RuntimeValue> pendingValues;
+
+    void drain() {
+        while (!pendingScopes.empty() || !pendingValues.empty()) {
+            if (!pendingScopes.empty()) {
+                Environment *env = pendingScopes.back();
+                pendingScopes.pop_back();
+                visit(env);
+            } else {
+                RuntimeValue value = std::move(pendingValues.back());
+                pendingValues.pop_back();
+                visit(value);
+            }
+        }
+    }
+
+    void visit(Environment *env) {
+        // Already frozen objects have been (or are being) visited
+        if (!env || env->isFrozen())
+            return;
+        env->setFrozen(true);
+        environments.push_back(env);
+        for (const auto &entry : env->getValues()) {
+            pendingValues.push_back(entry.second);
+        }
+        pendingScopes.push_back(env->getEnclosing().get());
+    }
+
+    void visit(const RuntimeValue &value) {
+        if (value.is<ArrayPtr>()) {
+            Array *array = value.as<ArrayPtr>().get();
+            if (array->isFrozen())
+                return;
+            array->setFrozen(true);
+            arrays.push_back(array);
+            if (array->kind() == Array::Kind::Generic) {
+                for (const auto &element : array->values()) {
+                    pendingValues.push_back(element);
+                }
+            }
+        } else if (value.is<SetPtr>() || value.is<DictionaryPtr>()) {
+            HashTable *table = value.is<SetPtr>()
+                                   ? static_cast<HashTable *>(value.as<SetPtr>().get())
+                                   : static_cast<HashTable *>(value.as<DictionaryPtr>().get());
+            if (table->isFrozen())
+                return;
+            table->setFrozen(true);
+            tables.push_back(table);
+            for (const auto &entry : table->entries()) {
+                if (!entry.live)
+                    continue;
+                pendingValues.push_back(entry.key);
+                pendingValues.push_back(entry.value);
+            }
+        } else if (value.is<std::shared_ptr<Instance>>()) {
+            Instance *instance = value.as<std::shared_ptr<Instance>>().get();
+            if (instance->frozen)
+                return;
+            instance->frozen = true;
+            instances.push_back(instance);
+            pendingValues.push_back({instance->klass});
+            for (const auto &field : instance->fields) {
+                pendingValues.push_back(field.second);
+            }
+        } else if (value.is<std::shared_ptr<Callable>>()) {
+            Callable *callable = value.as<std::shared_ptr<Callable>>().get();
+            if (auto function = dynamic_cast<LoxFunction *>(callable)) {
+                pendingScopes.push_back(function->closure.get());
+            } else if (auto method = dynamic_cast<CollectionMethod *>(callable)) {
+                pendingValues.push_back(method->receiver());
+            }
+        }
+    }
+};
+
+// --- PARALLEL FOR ---
+
+/**
+ * Run each iteration of a PARALLEL FOR loop as a task on the shared thread pool
+ *
+ * Each pool worker gets its own Interpreter, so evaluation state is never shared; they all
+ * read the loop's enclosing scope, which is frozen for the duration. PRINT output is buffered
+ * per iteration and written in iteration order afterwards, so the program prints exactly what
+ * the sequential loop would. If iterations fail, the error from the earliest one is raised
+ * after the output of the iterations before it.
+ */
+void Interpreter::runParallelForIn(ForInStmt *stmt, const ArrayPtr &list) {
+    ThreadPool &pool = ThreadPool::shared();
+    size_t count     = list->size();
+
+    SharedStateFreezer freezer;
+    freezer.freeze(environment);
+    freezer.freeze(RuntimeValue{list});
+
+    // Worker interpreters resolve builtins through the shared scope, so they define none
+    static const NativeRegistry noNatives{};
+    std::vector<std::unique_ptr<Interpreter>> workers(pool.size());
+    for (auto &worker : workers) {
+        worker                 = std::make_unique<Interpreter>(noNatives);
+        worker->useVM          = useVM;
+        worker->useJit         = useJit;
+        worker->maxCallDepth   = maxCallDepth;
+        worker->callDepth      = callDepth; // The loop body runs as deep as the loop itself
+        worker->errorOutput    = errorOutput;
+        worker->parallelWorker = true;
+        worker->heap           = heap;
+        worker->useBudget(budget);
+    }
+
+    std::vector<std::string> outputs(count);
+    std::mutex errorMutex;
+    std::exception_ptr error;
+    std::atomic<size_t> firstError{count}; // Later iterations are skipped once one has failed
+
+    auto fail = [&](size_t index, std::exception_ptr exception) {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (index < firstError) {
+            firstError = index;
+            error      = exception;
+        }
+    };
+
+    pool.parallelFor(count, [&](size_t index, size_t workerIndex) {
+        if (index > firstError.load(std::memory_order_relaxed))
+            return;
+
+        Interpreter &worker = *workers[workerIndex];
+        std::ostringstream buffer;
+        worker.output = &buffer;
+        HeapAccount::Scope heapScope(heap);
+        try {
+            worker.tick(stmt->variable);
+            auto loopEnv = std::make_shared<Environment>(environment);
+            loopEnv->define(stmt->variable, list->get(index));
+            worker.executeBlock(stmt->body, loopEnv);
+        } catch (const ReturnException &) {
+            fail(index, std::make_exception_ptr(RuntimeError(
+                            stmt->variable, "RETURN is not allowed inside a PARALLEL FOR loop.")));
+        } catch (...) {
+            fail(index, std::current_exception());
+        }
+        outputs[index] = buffer.str();
+    });
+
+    size_t printed = std::min(count, firstError.load());
+    for (size_t i = 0; i < printed; ++i) {
+        *output << outputs[i];
+    }
+    output->flush();
+
+    if (error)
+        std::rethrow_exception(error);
+}
@@ -19,11 +19,11 @@ Parser::Parser(const std::vector<Token> &tokens, const std::string &source, Erro
 
 /**
  * Log parser function entry for debugging
- * Only output if TRACE is enabled
+ * Only output if a trace stream is set
  */
 void Parser::traceEnter(const std::string &name) {
-    if (TRACE) {
-        std::cerr << "[Parse] > " << name << " @ token: " << peek().lexeme << std::endl;
+    if (trace) {
+        *trace << "[Parse] > " << name << " @ token: " << peek().lexeme << std::endl;
     }
 }
 
@@ -31,8 +31,8 @@ void Parser::traceEnter(const std::string &name) {
  * Log parser function exit for debugging
  */
 void Parser::traceExit(const std::string &name) {
-    if (TRACE) {
-        std::cerr << "[Parse] < " << name << std::endl;
+    if (trace) {
+        *trace << "[Parse] < " << name << std::endl;
     }
 }
 
@@ -46,6 +46,10 @@ std::vector<StmtPtr> Parser::parse() {
     return statements;
 }
 
+StmtPtr Parser::parseDeclaration() {
+    return declaration();
+}
+
 // ============================================================
 // Pratt Parsing Engine
 //
@@ -55,7 +59,27 @@ std::vector<StmtPtr> Parser::parse() {
 // operators (binary ops, function calls, member access).
 // ============================================================
 
+void Parser::NestingGuard::deepen() {
+    if (parser.nesting >= MAX_NESTING) {
+        // Recovering would only report every enclosing construct as unterminated, so the
+        // rest of the input is skipped
+        Token at       = parser.peek();
+        parser.current = parser.tokens.size() - 1;
+        parser.errorAt(at, "Nesting is too deep (more than " + std::to_string(MAX_NESTING) +
+                               " levels).");
+    }
+    ++parser.nesting;
+    ++levels;
+}
+
 ExprPtr Parser::parseExpression(Precedence precedence) {
+    NestingGuard guard(*this);
+
+    // advance() stays put at the end, which would re-read the previous token as the prefix
+    if (isAtEnd()) {
+        errorAt(peek(), "Expected expression.");
+        return nullptr;
+    }
     advance(); // Move to the prefix token
     Token prefixToken = previous();
 
@@ -98,6 +122,7 @@ ExprPtr Parser::parseExpression(Precedence precedence) {
     // Process infix operators while they have higher precedence than context
     // This implements left-associativity for operators with same precedence
     while (precedence < getPrecedence(peek().type)) {
+        guard.deepen(); // The expression so far becomes an operand one level further down
         Token infixToken = advance();
 
         switch (infixToken.type) {
@@ -251,6 +276,7 @@ ExprPtr Parser::binary(ExprPtr left) {
  */
 ExprPtr Parser::call(ExprPtr left) {
     // left is the callee
+    Token paren = previous();
     std::vector<ExprPtr> args;
     if (!check(TOK_RPAREN)) {
         do {
@@ -258,7 +284,7 @@ ExprPtr Parser::call(ExprPtr left) {
         } while (match(TOK_COMMA));
     }
     consume(TOK_RPAREN, "Expected ')' after arguments.");
-    return std::make_unique<CallExpr>(std::move(left), std::move(args));
+    return std::make_unique<CallExpr>(std::move(left), std::move(args), paren);
 }
 
 /**
@@ -273,11 +299,28 @@ ExprPtr Parser::dot(ExprPtr left) {
 /**
  * Infix: array subscript
  * Parses array element access: array[index]
+ * or a slice with optional bounds: array[start:end], array[:end], array[start:]
  */
 ExprPtr Parser::subscript(ExprPtr left) {
-    ExprPtr index = parseExpression(PREC_NONE);
+    Token bracket = previous();
+
+    ExprPtr index = nullptr;
+    if (!check(TOK_COLON)) {
+        index = parseExpression(PREC_NONE);
+    }
+
+    if (match(TOK_COLON)) {
+        ExprPtr end = nullptr;
+        if (!check(TOK_RBRACKET)) {
+            end = parseExpression(PREC_NONE);
+        }
+        consume(TOK_RBRACKET, "Expected ']' after slice.");
+        return std::make_unique<SliceExpr>(std::move(left), std::move(index), std::move(end),
+                                           bracket);
+    }
+
     consume(TOK_RBRACKET, "Expected ']' after index.");
-    return std::make_unique<ArrayAccessExpr>(std::move(left), std::move(index));
+    return std::make_unique<ArrayAccessExpr>(std::move(left), std::move(index), bracket);
 }
 
 /**
@@ -327,6 +370,8 @@ StmtPtr Parser::declaration() {
         traceExit("declaration");
         return statement();
     } catch (const std::exception &e) {
+        // Declarations are only ever top level, so no function body is still open
+        functionDepth = 0;
         // Synchronize to next valid statement to prevent cascading errors
         synchronize();
         return nullptr;
@@ -344,8 +389,8 @@ StmtPtr Parser::classDeclaration() {
     // Start parsing class
     traceEnter("classDeclaration");
     Token name = consume(TOK_IDENTIFIER, "Expected class name.");
-    if (TRACE)
-        std::cerr << "[Parse]   class: " << name.lexeme << std::endl;
+    if (trace)
+        *trace << "[Parse]   class: " << name.lexeme << std::endl;
     Token superclass{TOK_EOF, "", 0, 0, 0};
 
     // Inheritance
@@ -406,8 +451,8 @@ StmtPtr Parser::functionDeclaration() {
 
     // Construct function name
     Token name = consume(TOK_IDENTIFIER, "Expected function name.");
-    if (TRACE)
-        std::cerr << "[Parse]   function: " << name.lexeme << std::endl;
+    if (trace)
+        *trace << "[Parse]   function: " << name.lexeme << std::endl;
     consume(TOK_LPAREN, "Expected '('.");
 
     // Construct parameters list
@@ -419,7 +464,9 @@ StmtPtr Parser::functionDeclaration() {
     }
     consume(TOK_RPAREN, "Expected ')'.");
 
+    ++functionDepth;
     std::vector<StmtPtr> body = block();
+    --functionDepth;
 
     consume(TOK_END, "Expected 'END' after function body.");
 
@@ -440,6 +487,7 @@ StmtPtr Parser::functionDeclaration() {
  */
 StmtPtr Parser::statement() {
     traceEnter("statement");
+    NestingGuard guard(*this);
     if (match(TOK_RETURN)) {
         traceExit("statement");
         return returnStatement();
@@ -454,7 +502,12 @@ StmtPtr Parser::statement() {
     }
     if (match(TOK_FOR)) {
         traceExit("statement");
-        return forInStatement();
+        return forInStatement(false);
+    }
+    if (match(TOK_PARALLEL)) {
+        consume(TOK_FOR, "Expected 'FOR' after 'PARALLEL'.");
+        traceExit("statement");
+        return forInStatement(true);
     }
     if (match(TOK_IF)) {
         traceExit("statement");
@@ -502,20 +555,22 @@ StmtPtr Parser::ifStatement() {
  */
 StmtPtr Parser::whileStatement() {
     traceEnter("whileStatement");
+    Token keyword     = previous();
     ExprPtr condition = parseExpression(PREC_NONE);
     // Pseudocode didn't strictly show "DO", but usually loop starts block
     std::vector<StmtPtr> body = block();
     consume(TOK_END, "Expected 'END' after while loop.");
     consume(TOK_WHILE, "Expected 'WHILE' after 'END'.");
     traceExit("whileStatement");
-    return std::make_unique<WhileStmt>(std::move(condition), std::move(body));
+    return std::make_unique<WhileStmt>(keyword, std::move(condition), std::move(body));
 }
 
 /**
  * For-in loop statement
- * Parses: FOR variable IN iterable statements END FOR
+ * Parses: [PARALLEL] FOR variable IN iterable statements END FOR
+ * @param parallel Whether the loop was prefixed with PARALLEL
  */
-StmtPtr Parser::forInStatement() {
+StmtPtr Parser::forInStatement(bool parallel) {
     traceEnter("forInStatement");
 
     // Get the loop variable
@@ -535,7 +590,7 @@ StmtPtr Parser::forInStatement() {
     consume(TOK_FOR, "Expected 'FOR' after 'END'.");
 
     traceExit("forInStatement");
-    return std::make_unique<ForInStmt>(variable, std::move(iterable), std::move(body));
+    return std::make_unique<ForInStmt>(variable, std::move(iterable), std::move(body), parallel);
 }
 
 /**
@@ -555,6 +610,10 @@ StmtPtr Parser::printStatement() {
  * Expression is optional
  */
 StmtPtr Parser::returnStatement() {
+    if (functionDepth == 0) {
+        // Reported here so the tree walker and the VM never have to agree on what it means
+        errorAt(previous(), "RETURN is only allowed inside a function.");
+    }
     ExprPtr value = nullptr;
     // Check if next token is start of an expression
     if (!check(TOK_END) && !check(TOK_ELSE)) {
@@ -648,6 +707,7 @@ Token Parser::consume(TokenType type, std::string message) {
  */
 void Parser::errorAt(Token token, const std::string &message) {
     if (token.type == TOK_EOF) {
+        unexpectedEnd = true;
         reporter.report(ErrorType::Syntax, token.line, 0, message + " at end", 1);
         return;
     }
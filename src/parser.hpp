@@ -29,12 +29,73 @@ public:
      */
     std::vector<StmtPtr> parse();
 
+    /**
+     * Parse the next top-level declaration only, for callers that parse a program piece by piece
+     * @return The statement, or nullptr if it could not be parsed at all
+     */
+    StmtPtr parseDeclaration();
+
+    /**
+     * Index of the next token to be parsed
+     */
+    size_t position() const {
+        return current;
+    }
+
+    /**
+     * Whether every token has been parsed
+     */
+    bool done() {
+        return isAtEnd();
+    }
+
+    // Set when a syntax error was found at the end of the tokens, i.e. the input stopped
+    // part-way through a construct and more of it may follow
+    bool unexpectedEnd = false;
+
+    // Stream that entry and exit of parsing functions is traced to; no tracing while null
+    std::ostream *trace = nullptr;
+
+    // Deepest nesting of expressions and blocks accepted. Every later stage walks the tree
+    // recursively, so this keeps them all well inside the native stack.
+    static constexpr int MAX_NESTING = 1000;
+
 private:
     const std::vector<Token> &tokens;
     const std::string &source;
     ErrorReporter &reporter;
-    size_t current              = 0;
-    static constexpr bool TRACE = false; // Set to false to disable tracing
+    size_t current = 0;
+
+    // Levels of expression and block nesting around the token being parsed
+    int nesting = 0;
+    // Function bodies around the token being parsed; RETURN is only valid inside one
+    int functionDepth = 0;
+
+    /**
+     * NestingGuard - counts levels of nesting while it lives
+     * Passing MAX_NESTING is a syntax error that ends the parse.
+     */
+    class NestingGuard {
+    public:
+        explicit NestingGuard(Parser &parser) : parser(parser) {
+            deepen();
+        }
+        ~NestingGuard() {
+            parser.nesting -= levels;
+        }
+
+        NestingGuard(const NestingGuard &)            = delete;
+        NestingGuard &operator=(const NestingGuard &) = delete;
+
+        /**
+         * Add a level, e.g. when an operator makes the expression so far its left operand
+         */
+        void deepen();
+
+    private:
+        Parser &parser;
+        int levels = 0;
+    };
 
     /**
      * Operator Precedence Levels
@@ -120,8 +181,9 @@ private:
 
     /**
      * Parse a for-in loop with variable, iterable, and body
+     * @param parallel Whether the loop was prefixed with PARALLEL
      */
-    StmtPtr forInStatement();
+    StmtPtr forInStatement(bool parallel);
 
     /**
      * Parse a print statement
@@ -200,7 +262,7 @@ private:
     ExprPtr dot(ExprPtr left);
 
     /**
-     * Parse array subscript access (array[index])
+     * Parse array subscript access (array[index]) or slicing (array[start:end])
      */
     ExprPtr subscript(ExprPtr left);
 
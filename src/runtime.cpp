@@ -0,0 +1,881 @@
+#include "runtime.hpp"
+
+#include <algorithm>
+#include <set>
+
+// --- Heap Accounting ---
+
+// Account charged by objects created on this thread
+static thread_local std::shared_ptr<HeapAccount> currentAccount;
+
+const std::shared_ptr<HeapAccount> &HeapAccount::current() {
+    return currentAccount;
+}
+
+HeapAccount::Scope::Scope(std::shared_ptr<HeapAccount> account)
+    : previous(std::move(currentAccount)) {
+    currentAccount = std::move(account);
+}
+
+HeapAccount::Scope::~Scope() {
+    currentAccount = std::move(previous);
+}
+
+std::string HeapAccount::exceededMessage() const {
+    return "Memory limit of " + std::to_string(limit) + " bytes exceeded.";
+}
+
+/**
+ * Add to the running total, backing out again if that passes the limit
+ * @param bytes The number of bytes being allocated
+ */
+void HeapAccount::charge(size_t bytes) {
+    size_t total = used.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    if (total > limit) {
+        used.fetch_sub(bytes, std::memory_order_relaxed);
+        throw NativeError(exceededMessage());
+    }
+}
+
+void HeapAccount::require(size_t bytes, const Token &where) const {
+    if (used.load(std::memory_order_relaxed) + bytes > limit)
+        throw RuntimeError(where, exceededMessage());
+}
+
+void HeapAccount::require(size_t bytes) const {
+    if (used.load(std::memory_order_relaxed) + bytes > limit)
+        throw NativeError(exceededMessage());
+}
+
+// Bytes of text a value holds outside its RuntimeValue
+static size_t textBytes(const RuntimeValue &value) {
+    return value.is<std::string>() ? value.as<std::string>().size() : 0;
+}
+
+// --- Instance Implementation ---
+
+// Bytes a field costs besides its name and text: its node in the field map
+static constexpr size_t FIELD_NODE_SIZE =
+    sizeof(std::pair<const std::string, RuntimeValue>) + 4 * sizeof(void *);
+
+/**
+ * Charge for a new or changed field
+ * A new field costs its tree node and key as well as any string it holds.
+ * @param name The field being set
+ * @param previous The field's current value, or null if it is new
+ * @param value The value about to be stored
+ */
+void Instance::recharge(const Token &name, const RuntimeValue *previous,
+                        const RuntimeValue &value) {
+    size_t added   = textBytes(value) + (previous ? 0 : FIELD_NODE_SIZE + name.lexeme.size());
+    size_t removed = previous ? textBytes(*previous) : 0;
+    try {
+        charge.resize(charge.size() + added - removed);
+    } catch (const NativeError &error) {
+        throw RuntimeError(name, error.what());
+    }
+}
+
+std::shared_ptr<Instance> Instance::copy() const {
+    auto copy    = std::make_shared<Instance>(klass);
+    copy->fields = fields;
+    copy->cachedHash.set(cachedHash.get());
+    if (copy->charge.active()) {
+        size_t bytes = 0;
+        for (const auto &field : fields)
+            bytes += FIELD_NODE_SIZE + field.first.size() + textBytes(field.second);
+        copy->charge.resize(copy->charge.size() + bytes);
+    }
+    return copy;
+}
+
+// --- Array Implementation ---
+
+/**
+ * Build an array from loose values
+ * Picks packed storage when every value is a number, or every value is a boolean.
+ * @param values The elements, in order
+ * @return A new array holding the elements
+ */
+ArrayPtr Array::fromValues(std::vector<RuntimeValue> values) {
+    auto array = std::make_shared<Array>();
+    array->reserve(values.size());
+    for (auto &value : values) {
+        array->push(std::move(value));
+    }
+    return array;
+}
+
+/**
+ * Refuse to modify a list shared with the iterations of a PARALLEL FOR loop
+ */
+void Array::checkMutable() const {
+    if (frozen) {
+        throw NativeError("Cannot modify a shared list inside a PARALLEL FOR loop.");
+    }
+}
+
+/**
+ * Charge the element buffer's capacity and the text of any strings held
+ * @param added Bytes of string text stored by the latest change
+ * @param removed Bytes of string text released by the latest change
+ */
+void Array::recharge(size_t added, size_t removed) {
+    stringBytes   = stringBytes + added - removed;
+    size_t buffer = std::visit(
+        [](const auto &elements) {
+            using Element = typename std::decay_t<decltype(elements)>::value_type;
+            return elements.capacity() * sizeof(Element);
+        },
+        *storage);
+    charge.resize(sizeof(Array) + buffer + stringBytes);
+}
+
+/**
+ * Number of elements in the array, regardless of representation
+ */
+size_t Array::size() const {
+    switch (kind()) {
+    case Kind::Number:
+        return std::get<std::vector<double>>(*storage).size();
+    case Kind::Boolean:
+        return std::get<std::vector<uint8_t>>(*storage).size();
+    default:
+        return std::get<std::vector<RuntimeValue>>(*storage).size();
+    }
+}
+
+/**
+ * Reserve capacity in the current representation
+ * @param capacity The number of elements to make room for
+ */
+void Array::reserve(size_t capacity) {
+    std::visit([capacity](auto &elements) { elements.reserve(capacity); }, own());
+    account();
+}
+
+/**
+ * Read an element, boxing packed values back into a RuntimeValue
+ * @param index Position of the element; must be in range
+ */
+RuntimeValue Array::get(size_t index) const {
+    switch (kind()) {
+    case Kind::Number:
+        return {std::get<std::vector<double>>(*storage)[index]};
+    case Kind::Boolean:
+        return {std::get<std::vector<uint8_t>>(*storage)[index] != 0};
+    default:
+        return std::get<std::vector<RuntimeValue>>(*storage)[index];
+    }
+}
+
+/**
+ * Overwrite an element
+ * @param index Position of the element; must be in range
+ * @param value The new value
+ */
+void Array::set(size_t index, RuntimeValue value) {
+    checkMutable();
+    prepareFor(value);
+    Storage &elements = own();
+    switch (kind()) {
+    case Kind::Number:
+        std::get<std::vector<double>>(elements)[index] = value.as<double>();
+        break;
+    case Kind::Boolean:
+        std::get<std::vector<uint8_t>>(elements)[index] = value.as<bool>();
+        break;
+    default: {
+        RuntimeValue &slot = std::get<std::vector<RuntimeValue>>(elements)[index];
+        size_t added       = textBytes(value);
+        size_t removed     = textBytes(slot);
+        slot               = std::move(value);
+        account(added, removed);
+        break;
+    }
+    }
+}
+
+/**
+ * Append an element to the end of the array (amortized O(1))
+ * @param value The value to append
+ */
+void Array::push(RuntimeValue value) {
+    checkMutable();
+    prepareFor(value);
+    Storage &elements = own();
+    switch (kind()) {
+    case Kind::Number:
+        std::get<std::vector<double>>(elements).push_back(value.as<double>());
+        break;
+    case Kind::Boolean:
+        std::get<std::vector<uint8_t>>(elements).push_back(value.as<bool>());
+        break;
+    default: {
+        size_t added = textBytes(value);
+        std::get<std::vector<RuntimeValue>>(elements).push_back(std::move(value));
+        account(added);
+        return;
+    }
+    }
+    account();
+}
+
+/**
+ * Insert an element before position 'index'
+ * @param index Insertion point; may equal size() to append
+ * @param value The value to insert
+ */
+void Array::insert(size_t index, RuntimeValue value) {
+    checkMutable();
+    prepareFor(value);
+    Storage &elements = own();
+    switch (kind()) {
+    case Kind::Number: {
+        auto &numbers = std::get<std::vector<double>>(elements);
+        numbers.insert(numbers.begin() + index, value.as<double>());
+        break;
+    }
+    case Kind::Boolean: {
+        auto &booleans = std::get<std::vector<uint8_t>>(elements);
+        booleans.insert(booleans.begin() + index, value.as<bool>());
+        break;
+    }
+    default: {
+        auto &values = std::get<std::vector<RuntimeValue>>(elements);
+        size_t added = textBytes(value);
+        values.insert(values.begin() + index, std::move(value));
+        account(added);
+        return;
+    }
+    }
+    account();
+}
+
+/**
+ * Remove and return the element at 'index'
+ * @param index Position of the element; must be in range
+ */
+RuntimeValue Array::erase(size_t index) {
+    checkMutable();
+    RuntimeValue removed = get(index);
+    std::visit([index](auto &elements) { elements.erase(elements.begin() + index); }, own());
+    account(0, textBytes(removed));
+    return removed;
+}
+
+/**
+ * Remove and return the last element; the array must not be empty
+ */
+RuntimeValue Array::pop() {
+    checkMutable();
+    RuntimeValue last = get(size() - 1);
+    std::visit([](auto &elements) { elements.pop_back(); }, own());
+    account(0, textBytes(last));
+    return last;
+}
+
+/**
+ * Copy a sub-range of the array, keeping the packed representation
+ * @param start First element to copy
+ * @param end One past the last element to copy
+ */
+ArrayPtr Array::slice(size_t start, size_t end) const {
+    auto copy = std::make_shared<Array>();
+    std::visit(
+        [&](const auto &elements) {
+            using Elements = std::decay_t<decltype(elements)>;
+            *copy->storage = Elements(elements.begin() + start, elements.begin() + end);
+        },
+        *storage);
+    if (copy->charge.active()) {
+        size_t text = 0;
+        if (kind() == Kind::Generic) {
+            for (const RuntimeValue &element : copy->values())
+                text += textBytes(element);
+        }
+        copy->recharge(text, 0);
+    }
+    return copy;
+}
+
+/**
+ * Share the whole element buffer with a new, unfrozen array
+ * The copy is charged as if it owned the buffer, so the memory limit still holds once the two
+ * arrays diverge.
+ */
+ArrayPtr Array::copy() const {
+    auto copy     = std::make_shared<Array>();
+    copy->storage = storage;
+    copy->cachedHash.set(cachedHash.get());
+    if (copy->charge.active()) {
+        size_t text = stringBytes;
+        if (!charge.active() && kind() == Kind::Generic) {
+            for (const RuntimeValue &element : values())
+                text += textBytes(element);
+        }
+        copy->recharge(text, 0);
+    }
+    return copy;
+}
+
+/**
+ * Ensure the current representation can hold 'value'
+ * An empty array adopts the value's type, a mismatched store falls back to generic storage.
+ * @param value The value about to be stored
+ */
+void Array::prepareFor(const RuntimeValue &value) {
+    Kind wanted = value.is<double>() ? Kind::Number
+                  : value.is<bool>() ? Kind::Boolean
+                                     : Kind::Generic;
+    if (wanted == kind() || kind() == Kind::Generic)
+        return;
+
+    if (size() == 0) {
+        switch (wanted) {
+        case Kind::Number:
+            storage = std::make_shared<Storage>(std::vector<double>());
+            break;
+        case Kind::Boolean:
+            storage = std::make_shared<Storage>(std::vector<uint8_t>());
+            break;
+        default:
+            storage = std::make_shared<Storage>(std::vector<RuntimeValue>());
+            break;
+        }
+        return;
+    }
+    despecialize();
+}
+
+/**
+ * Box every packed element into a RuntimeValue and switch to generic storage
+ * The boxed elements go into a new buffer, so a copy sharing the old one is left alone.
+ */
+void Array::despecialize() {
+    std::vector<RuntimeValue> values;
+    values.reserve(size());
+    for (size_t i = 0; i < size(); ++i) {
+        values.push_back(get(i));
+    }
+    storage = std::make_shared<Storage>(std::move(values));
+}
+
+// --- Hashing ---
+
+// Lists and objects nested deeper than this inside a hashed value contribute only their size
+static constexpr int MAX_HASH_DEPTH = 8;
+
+static bool isPrimitive(const RuntimeValue &value) {
+    return value.is<std::monostate>() || value.is<double>() || value.is<bool>() ||
+           value.is<std::string>();
+}
+
+bool isHashable(const RuntimeValue &value) {
+    return !value.is<SetPtr>() && !value.is<DictionaryPtr>();
+}
+
+/**
+ * Spread the bits of a hash over the whole word, since slots are picked by the low bits alone
+ */
+static size_t mixHash(uint64_t hash) {
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return (size_t) hash;
+}
+
+/**
+ * Fold one more hash into an order-dependent running hash
+ */
+static size_t combineHash(uint64_t seed, uint64_t hash) {
+    return (size_t) ((seed ^ hash) * 0x100000001b3ULL);
+}
+
+/**
+ * Address of the object a reference value points at, or null for primitives
+ */
+static const void *identity(const RuntimeValue &value) {
+    return std::visit(
+        [](const auto &held) -> const void * {
+            using Held = std::decay_t<decltype(held)>;
+            if constexpr (std::is_same_v<Held, ArrayPtr> ||
+                          std::is_same_v<Held, std::shared_ptr<Callable>> ||
+                          std::is_same_v<Held, std::shared_ptr<Instance>> ||
+                          std::is_same_v<Held, SetPtr> || std::is_same_v<Held, DictionaryPtr>)
+                return held.get();
+            else
+                return nullptr;
+        },
+        value.value);
+}
+
+/**
+ * Hash of a value found 'depth' levels down inside the value being hashed (before mixing)
+ */
+static size_t hashAt(const RuntimeValue &value, int depth) {
+    uint64_t hash = value.value.index();
+    if (value.is<double>()) {
+        double number = value.as<double>();
+        // -0 and 0 compare equal, so they must hash equally
+        hash ^= std::hash<double>{}(number == 0 ? 0.0 : number);
+    } else if (value.is<bool>()) {
+        hash ^= value.as<bool>() ? 0x9e3779b97f4a7c15ULL : 0;
+    } else if (value.is<std::string>()) {
+        hash ^= std::hash<std::string>{}(value.as<std::string>());
+    } else if (value.is<ArrayPtr>()) {
+        hash = combineHash(hash, value.as<ArrayPtr>()->contentHash(depth));
+    } else if (value.is<std::shared_ptr<Instance>>()) {
+        hash = combineHash(hash, value.as<std::shared_ptr<Instance>>()->contentHash(depth));
+    } else if (!value.is<std::monostate>()) {
+        // Everything else is equal only to itself
+        hash = combineHash(hash, std::hash<const void *>{}(identity(value)));
+    }
+    return (size_t) hash;
+}
+
+size_t hashValue(const RuntimeValue &value) {
+    return mixHash(hashAt(value, 0));
+}
+
+size_t Array::contentHash(int depth) const {
+    if (depth >= MAX_HASH_DEPTH)
+        return size();
+    size_t cached = cachedHash.get();
+    if (cached != 0)
+        return cached;
+
+    size_t hash = size();
+    bool flat   = true;
+    switch (kind()) {
+    case Kind::Number:
+        for (double number : numbers())
+            hash = combineHash(hash, hashAt({number}, depth + 1));
+        break;
+    case Kind::Boolean:
+        for (uint8_t boolean : booleans())
+            hash = combineHash(hash, hashAt({boolean != 0}, depth + 1));
+        break;
+    default:
+        for (const RuntimeValue &element : values()) {
+            flat = flat && isPrimitive(element);
+            hash = combineHash(hash, hashAt(element, depth + 1));
+        }
+        break;
+    }
+    // 0 marks an empty cache, so a hash of 0 is stored as 1
+    hash += hash == 0;
+    if (flat)
+        cachedHash.set(hash);
+    return hash;
+}
+
+size_t Instance::contentHash(int depth) const {
+    if (depth >= MAX_HASH_DEPTH)
+        return fields.size();
+    size_t cached = cachedHash.get();
+    if (cached != 0)
+        return cached;
+
+    size_t hash = combineHash(fields.size(), std::hash<const void *>{}(klass.get()));
+    bool flat   = true;
+    for (const auto &field : fields) {
+        flat = flat && isPrimitive(field.second);
+        hash = combineHash(hash, std::hash<std::string>{}(field.first));
+        hash = combineHash(hash, hashAt(field.second, depth + 1));
+    }
+    hash += hash == 0;
+    if (flat)
+        cachedHash.set(hash);
+    return hash;
+}
+
+// --- Equality ---
+
+/**
+ * Compare two primitives of the same type
+ */
+static bool primitivesEqual(const RuntimeValue &a, const RuntimeValue &b) {
+    if (a.is<double>())
+        return a.as<double>() == b.as<double>();
+    if (a.is<bool>())
+        return a.as<bool>() == b.as<bool>();
+    if (a.is<std::string>())
+        return a.as<std::string>() == b.as<std::string>();
+    return true; // nil
+}
+
+/**
+ * EqualityCheck - compares two values structurally without recursing on the native stack
+ *
+ * Pairs of nested lists and objects still to be compared wait on a worklist. A nested pair met
+ * a second time is taken as equal, which both skips repeated work on shared structure and ends
+ * the comparison of cyclic lists: if no difference is found along the cycle, there is none.
+ */
+class EqualityCheck {
+public:
+    bool run(const RuntimeValue &a, const RuntimeValue &b) {
+        if (!compare(a, b, false))
+            return false;
+        while (!pending.empty()) {
+            auto pair = std::move(pending.back());
+            pending.pop_back();
+            if (!compare(pair.first, pair.second, true))
+                return false;
+        }
+        return true;
+    }
+
+private:
+    std::vector<std::pair<RuntimeValue, RuntimeValue>> pending;
+    std::set<std::pair<const void *, const void *>> seen;
+
+    /**
+     * Compare one pair, queueing any nested lists and objects
+     * @param nested Whether the pair was found inside the values first compared
+     */
+    bool compare(const RuntimeValue &a, const RuntimeValue &b, bool nested) {
+        if (a.value.index() != b.value.index())
+            return false;
+        if (isPrimitive(a))
+            return primitivesEqual(a, b);
+        if (identity(a) == identity(b))
+            return true;
+        if (a.is<ArrayPtr>())
+            return compareArrays(*a.as<ArrayPtr>(), *b.as<ArrayPtr>(), nested);
+        if (a.is<std::shared_ptr<Instance>>())
+            return compareInstances(*a.as<std::shared_ptr<Instance>>(),
+                                    *b.as<std::shared_ptr<Instance>>(), nested);
+        return false;
+    }
+
+    /**
+     * Compare 'a' and 'b' now if both are primitives, otherwise queue them
+     */
+    bool compareOrQueue(RuntimeValue a, RuntimeValue b) {
+        if (isPrimitive(a) || isPrimitive(b))
+            return compare(a, b, true);
+        pending.emplace_back(std::move(a), std::move(b));
+        return true;
+    }
+
+    bool compareArrays(const Array &a, const Array &b, bool nested) {
+        if (a.size() != b.size())
+            return false;
+        // Packed lists of one type compare without boxing their elements
+        if (a.kind() == b.kind() && a.kind() == Array::Kind::Number)
+            return a.numbers() == b.numbers();
+        if (a.kind() == b.kind() && a.kind() == Array::Kind::Boolean)
+            return a.booleans() == b.booleans();
+        if (nested && !seen.insert({&a, &b}).second)
+            return true;
+        for (size_t i = 0; i < a.size(); ++i) {
+            if (!compareOrQueue(a.get(i), b.get(i)))
+                return false;
+        }
+        return true;
+    }
+
+    bool compareInstances(const Instance &a, const Instance &b, bool nested) {
+        if (a.klass != b.klass || a.fields.size() != b.fields.size())
+            return false;
+        if (nested && !seen.insert({&a, &b}).second)
+            return true;
+        // Fields are kept sorted by name, so equal objects list them in the same order
+        for (auto x = a.fields.begin(), y = b.fields.begin(); x != a.fields.end(); ++x, ++y) {
+            if (x->first != y->first || !compareOrQueue(x->second, y->second))
+                return false;
+        }
+        return true;
+    }
+};
+
+bool valuesEqual(const RuntimeValue &a, const RuntimeValue &b) {
+    // Primitives and identical references need no worklist
+    if (a.value.index() != b.value.index())
+        return false;
+    if (isPrimitive(a))
+        return primitivesEqual(a, b);
+    if (identity(a) == identity(b))
+        return true;
+    return EqualityCheck().run(a, b);
+}
+
+// --- Copying Values ---
+
+/**
+ * ValueCopy - copies a value's lists and objects, however deeply they are nested
+ *
+ * Lists are copied in O(1) with copy-on-write, and only lists and objects that hold further
+ * containers are copied element by element. Each nested container is copied once, which keeps
+ * shared structure shared and ends cycles; the copies wait on a worklist rather than recursing
+ * on the native stack.
+ */
+class ValueCopy {
+public:
+    /**
+     * @param tables Whether sets and dictionaries are copied too, rather than shared
+     */
+    explicit ValueCopy(bool tables) : tables(tables) {
+    }
+
+    RuntimeValue take(const RuntimeValue &value) {
+        RuntimeValue root = copyOf(value);
+        while (!pending.empty()) {
+            auto [original, copy] = std::move(pending.back());
+            pending.pop_back();
+            fill(original, copy);
+        }
+        return root;
+    }
+
+private:
+    bool tables;
+    // Copies made so far, by the address of the container they copy
+    std::map<const void *, RuntimeValue> copies;
+    // Originals, and copies that do not hold copies of their nested containers yet
+    std::vector<std::pair<RuntimeValue, RuntimeValue>> pending;
+
+    bool isCopied(const RuntimeValue &value) const {
+        return value.is<ArrayPtr>() || value.is<std::shared_ptr<Instance>>() ||
+               (tables && (value.is<SetPtr>() || value.is<DictionaryPtr>()));
+    }
+
+    RuntimeValue copyOf(const RuntimeValue &value) {
+        // Primitives cannot change, and functions are shared
+        if (!isCopied(value))
+            return value;
+        auto found = copies.find(identity(value));
+        if (found != copies.end())
+            return found->second;
+
+        auto copied = [this](const RuntimeValue &nested) { return isCopied(nested); };
+        RuntimeValue copy;
+        bool nested = true;
+        if (value.is<ArrayPtr>()) {
+            const Array &array = *value.as<ArrayPtr>();
+            copy               = {array.copy()};
+            nested             = array.kind() == Array::Kind::Generic &&
+                                 std::any_of(array.values().begin(), array.values().end(), copied);
+        } else if (value.is<std::shared_ptr<Instance>>()) {
+            const Instance &instance = *value.as<std::shared_ptr<Instance>>();
+            copy                     = {instance.copy()};
+            nested = std::any_of(instance.fields.begin(), instance.fields.end(),
+                                 [&](const auto &field) { return copied(field.second); });
+        } else if (value.is<SetPtr>()) {
+            copy = {std::make_shared<Set>()};
+        } else {
+            copy = {std::make_shared<Dictionary>()};
+        }
+        copies.emplace(identity(value), copy);
+        if (nested)
+            pending.emplace_back(value, copy);
+        return copy;
+    }
+
+    // Fill a copy with copies of what the original holds
+    void fill(const RuntimeValue &original, const RuntimeValue &copy) {
+        if (copy.is<ArrayPtr>()) {
+            for (RuntimeValue &element : copy.as<ArrayPtr>()->values())
+                element = copyOf(element);
+        } else if (copy.is<std::shared_ptr<Instance>>()) {
+            for (auto &field : copy.as<std::shared_ptr<Instance>>()->fields)
+                field.second = copyOf(field.second);
+        } else if (copy.is<SetPtr>()) {
+            // Keys are private to their table already, and are snapshotted again on insert
+            for (const auto &entry : original.as<SetPtr>()->entries()) {
+                if (entry.live)
+                    copy.as<SetPtr>()->add(entry.key);
+            }
+        } else {
+            for (const auto &entry : original.as<DictionaryPtr>()->entries()) {
+                if (entry.live)
+                    copy.as<DictionaryPtr>()->set(entry.key, copyOf(entry.value));
+            }
+        }
+    }
+};
+
+/**
+ * The copy of a key a set or dictionary keeps, so that nothing outside it can change the key
+ * Nested sets and dictionaries are hashed by identity, so they stay shared.
+ */
+static RuntimeValue keySnapshot(const RuntimeValue &key) {
+    return ValueCopy(false).take(key);
+}
+
+RuntimeValue isolatedCopy(const RuntimeValue &value) {
+    return ValueCopy(true).take(value);
+}
+
+// --- HashTable Implementation ---
+
+/**
+ * Refuse to modify a table shared with the iterations of a PARALLEL FOR loop
+ * @param kind "set" or "dictionary", for the message
+ */
+void HashTable::checkMutable(const char *kind) const {
+    if (frozen) {
+        throw NativeError(std::string("Cannot modify a shared ") + kind +
+                          " inside a PARALLEL FOR loop.");
+    }
+}
+
+/**
+ * Charge the entry and slot arrays and the text of any strings held
+ * @param added Bytes of string text stored by the latest change
+ * @param removed Bytes of string text released by the latest change
+ */
+void HashTable::recharge(size_t added, size_t removed) {
+    stringBytes = stringBytes + added - removed;
+    charge.resize(sizeof(HashTable) + table.capacity() * sizeof(Entry) +
+                  slots.capacity() * sizeof(uint32_t) + stringBytes);
+}
+
+size_t HashTable::find(const RuntimeValue &key) const {
+    if (count == 0 || !isHashable(key))
+        return NOT_FOUND;
+    size_t hash = hashValue(key);
+    size_t mask = slots.size() - 1;
+    for (size_t slot = hash & mask; slots[slot] != 0; slot = (slot + 1) & mask) {
+        const Entry &entry = table[slots[slot] - 1];
+        if (entry.live && entry.hash == hash && valuesEqual(entry.key, key))
+            return slots[slot] - 1;
+    }
+    return NOT_FOUND;
+}
+
+HashTable::Entry &HashTable::insert(const RuntimeValue &key, const char *role, bool &added) {
+    size_t position = find(key);
+    if (position != NOT_FOUND) {
+        added = false;
+        return table[position];
+    }
+    if (!isHashable(key)) {
+        throw NativeError(std::string(role) + " cannot be sets or dictionaries.");
+    }
+
+    // Keep at least a quarter of the slots empty, counting dead entries, so probes stay short
+    if ((table.size() + 1) * 4 > slots.size() * 3)
+        rebuild(count + 1);
+
+    size_t hash = hashValue(key);
+    size_t mask = slots.size() - 1;
+    size_t slot = hash & mask;
+    while (slots[slot] != 0)
+        slot = (slot + 1) & mask;
+    slots[slot] = (uint32_t) table.size() + 1;
+    table.push_back({keySnapshot(key), {std::monostate{}}, hash, true});
+    count++;
+    added = true;
+    account(textBytes(key));
+    return table.back();
+}
+
+bool HashTable::erase(const RuntimeValue &key, RuntimeValue *value) {
+    size_t position = find(key);
+    if (position == NOT_FOUND)
+        return false;
+
+    Entry &entry   = table[position];
+    size_t removed = textBytes(entry.key) + textBytes(entry.value);
+    if (value)
+        *value = std::move(entry.value);
+    entry.key   = {std::monostate{}};
+    entry.value = {std::monostate{}};
+    entry.live  = false;
+    count--;
+
+    // The slot keeps pointing at the dead entry, so probes for the keys after it still pass
+    if (count == 0) {
+        table.clear();
+        std::fill(slots.begin(), slots.end(), 0);
+    }
+    account(0, removed);
+    return true;
+}
+
+void HashTable::rebuild(size_t capacity) {
+    // Compact the live entries to the front, keeping their order
+    size_t kept = 0;
+    for (size_t i = 0; i < table.size(); ++i) {
+        if (table[i].live) {
+            if (kept != i)
+                table[kept] = std::move(table[i]);
+            kept++;
+        }
+    }
+    table.resize(kept);
+
+    // Room for twice the entries wanted, so many inserts follow before the next rebuild
+    size_t size = 8;
+    while (size < capacity * 2)
+        size *= 2;
+    slots.assign(size, 0);
+    size_t mask = size - 1;
+    for (size_t i = 0; i < table.size(); ++i) {
+        size_t slot = table[i].hash & mask;
+        while (slots[slot] != 0)
+            slot = (slot + 1) & mask;
+        slots[slot] = (uint32_t) i + 1;
+    }
+    table.reserve(size * 3 / 4);
+    account();
+}
+
+ArrayPtr HashTable::keys() const {
+    auto list = std::make_shared<Array>();
+    list->reserve(count);
+    for (const Entry &entry : table) {
+        // Copies, so that changing a key read back out leaves the stored one alone
+        if (entry.live)
+            list->push(keySnapshot(entry.key));
+    }
+    return list;
+}
+
+// --- Set Implementation ---
+
+bool Set::add(const RuntimeValue &element) {
+    checkMutable("set");
+    bool added;
+    insert(element, "Set elements", added);
+    return added;
+}
+
+bool Set::remove(const RuntimeValue &element) {
+    checkMutable("set");
+    return erase(element, nullptr);
+}
+
+// --- Dictionary Implementation ---
+
+const RuntimeValue *Dictionary::get(const RuntimeValue &key) const {
+    size_t position = find(key);
+    return position == NOT_FOUND ? nullptr : &entries()[position].value;
+}
+
+void Dictionary::set(const RuntimeValue &key, RuntimeValue value) {
+    checkMutable("dictionary");
+    bool added;
+    Entry &entry   = insert(key, "Dictionary keys", added);
+    size_t stored  = textBytes(value);
+    size_t removed = textBytes(entry.value);
+    entry.value    = std::move(value);
+    account(stored, removed);
+}
+
+bool Dictionary::remove(const RuntimeValue &key, RuntimeValue &value) {
+    checkMutable("dictionary");
+    return erase(key, &value);
+}
+
+ArrayPtr Dictionary::values() const {
+    auto list = std::make_shared<Array>();
+    list->reserve(size());
+    for (const Entry &entry : entries()) {
+        if (entry.live)
+            list->push(entry.value);
+    }
+    return list;
+}
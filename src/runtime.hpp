@@ -2,9 +2,12 @@
 #pragma once
 
 #include "ast.hpp"
+#include <atomic>
+#include <cstdint>
 #include <functional>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <sstream>
 #include <stdexcept>
 #include <variant>
@@ -13,21 +16,29 @@
 // Forward declarations
 struct Callable;
 struct Instance;
+class Array;
+class Set;
+class Dictionary;
 class Interpreter;
 
 // --- Value Type Definition ---
 
 // A variant to hold any supported runtime value
-using Value = std::variant<std::monostate,                                    // null
-                           double,                                            // number
-                           bool,                                              // boolean
-                           std::string,                                       // string
-                           std::shared_ptr<std::vector<struct RuntimeValue>>, // Array (shared for
-                                                                              // ref semantics)
-                           std::shared_ptr<Callable>,                         // Function/Class
-                           std::shared_ptr<Instance>                          // Object Instance
+using Value = std::variant<std::monostate,             // null
+                           double,                     // number
+                           bool,                       // boolean
+                           std::string,                // string
+                           std::shared_ptr<Array>,     // Array (shared for ref semantics)
+                           std::shared_ptr<Callable>,  // Function/Class
+                           std::shared_ptr<Instance>,  // Object Instance
+                           std::shared_ptr<Set>,       // Set (shared for ref semantics)
+                           std::shared_ptr<Dictionary> // Dictionary (shared for ref semantics)
                            >;
 
+using ArrayPtr      = std::shared_ptr<Array>;
+using SetPtr        = std::shared_ptr<Set>;
+using DictionaryPtr = std::shared_ptr<Dictionary>;
+
 // Wrapper struct to allow recursive definition in variant (for Arrays)
 struct RuntimeValue {
     Value value;
@@ -44,6 +55,486 @@ struct RuntimeValue {
     }
 };
 
+// --- Heap Accounting ---
+
+/**
+ * HeapAccount - bytes of list, object and string storage held by one program, checked against a cap
+ *
+ * Lists and objects charge the account that is current on the thread creating them and refund
+ * it as they shrink or die. Strings are charged by the scopes, VM frames and lists that hold
+ * them. The total is atomic because the iterations of a PARALLEL FOR loop
+ * allocate from several threads at once.
+ */
+class HeapAccount {
+public:
+    explicit HeapAccount(size_t limit) : limit(limit) {
+    }
+
+    /**
+     * Add 'bytes' to the total
+     * @throws NativeError (and changes nothing) if the total would pass the limit
+     */
+    void charge(size_t bytes);
+
+    void refund(size_t bytes) {
+        used.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    /**
+     * Check that 'bytes' more would fit, without charging them (e.g. before building a string)
+     * @throws RuntimeError at 'where' if they would not
+     */
+    void require(size_t bytes, const Token &where) const;
+
+    /**
+     * The same check for native builtins, which have no token of their own
+     * @throws NativeError if they would not fit
+     */
+    void require(size_t bytes) const;
+
+    size_t getLimit() const {
+        return limit;
+    }
+
+    /**
+     * The account objects created on this thread charge; null when memory is unlimited
+     */
+    static const std::shared_ptr<HeapAccount> &current();
+
+    /**
+     * Scope - makes an account current on this thread while it lives
+     */
+    class Scope {
+    public:
+        explicit Scope(std::shared_ptr<HeapAccount> account);
+        ~Scope();
+
+    private:
+        std::shared_ptr<HeapAccount> previous;
+    };
+
+private:
+    std::atomic<size_t> used{0};
+    size_t limit;
+
+    std::string exceededMessage() const;
+};
+
+/**
+ * HeapCharge - the bytes one object currently holds against a HeapAccount
+ * Binds to the current account on construction and refunds everything on destruction.
+ */
+class HeapCharge {
+public:
+    HeapCharge() : account(HeapAccount::current()) {
+    }
+    ~HeapCharge() {
+        if (account)
+            account->refund(bytes);
+    }
+
+    HeapCharge(const HeapCharge &)            = delete;
+    HeapCharge &operator=(const HeapCharge &) = delete;
+
+    // Moving swaps, so the moved-from object refunds whatever this one held before
+    HeapCharge(HeapCharge &&other) noexcept
+        : account(std::move(other.account)), bytes(other.bytes) {
+        other.bytes = 0;
+    }
+    HeapCharge &operator=(HeapCharge &&other) noexcept {
+        std::swap(account, other.account);
+        std::swap(bytes, other.bytes);
+        return *this;
+    }
+
+    bool active() const {
+        return account != nullptr;
+    }
+
+    size_t size() const {
+        return bytes;
+    }
+
+    /**
+     * Change the object's footprint to 'total' bytes, charging or refunding the difference
+     */
+    void resize(size_t total) {
+        if (total > bytes)
+            account->charge(total - bytes);
+        else
+            account->refund(bytes - total);
+        bytes = total;
+    }
+
+private:
+    std::shared_ptr<HeapAccount> account;
+    size_t bytes = 0;
+};
+
+// --- Hash Caching ---
+
+/**
+ * HashCache - a structural hash remembered until the value it belongs to changes
+ * Atomic, since frozen values are hashed by several PARALLEL FOR iterations at once. Holds 0
+ * when empty; moving the owner empties it.
+ */
+class HashCache {
+public:
+    HashCache() = default;
+    HashCache(HashCache &&) noexcept {
+    }
+    HashCache &operator=(HashCache &&) noexcept {
+        clear();
+        return *this;
+    }
+
+    size_t get() const {
+        return hash.load(std::memory_order_relaxed);
+    }
+    void set(size_t value) const {
+        hash.store(value, std::memory_order_relaxed);
+    }
+    void clear() {
+        hash.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    mutable std::atomic<size_t> hash{0};
+};
+
+// --- Arrays ---
+
+/**
+ * Array - the backing store for pseudocode lists
+ *
+ * While every element shares one primitive type the elements are kept packed in a contiguous
+ * buffer of that type (8 bytes per number, 1 byte per boolean) instead of as tagged
+ * RuntimeValues. The first store of a different type converts the array to the generic
+ * representation, where it stays. Empty arrays take on the type of their first element.
+ *
+ * The element buffer is copy-on-write: copy() shares it with the new array, and whichever array
+ * changes first while it is shared takes a private copy. An array that owns its buffer alone
+ * changes it in place.
+ */
+class Array {
+public:
+    enum class Kind { Number, Boolean, Generic };
+
+    Array() : storage(std::make_shared<Storage>()) {
+    }
+
+    /**
+     * Build an array from loose values, packing them if they all share one type
+     */
+    static ArrayPtr fromValues(std::vector<RuntimeValue> values);
+
+    Kind kind() const {
+        return static_cast<Kind>(storage->index());
+    }
+
+    size_t size() const;
+    void reserve(size_t capacity);
+
+    RuntimeValue get(size_t index) const;
+    void set(size_t index, RuntimeValue value);
+    void push(RuntimeValue value);
+    void insert(size_t index, RuntimeValue value);
+    RuntimeValue erase(size_t index);
+    RuntimeValue pop();
+
+    /**
+     * Frozen arrays are shared read-only between threads; every mutator refuses to run
+     */
+    bool isFrozen() const {
+        return frozen;
+    }
+    void setFrozen(bool value) {
+        frozen = value;
+    }
+
+    /**
+     * Copy the elements in [start, end) into a new array of the same kind
+     */
+    ArrayPtr slice(size_t start, size_t end) const;
+
+    /**
+     * A shallow copy of the whole array in O(1); the elements are copied on the first change to
+     * either array
+     */
+    ArrayPtr copy() const;
+
+    /**
+     * Direct access to packed number storage, for native kernels
+     * Only valid while kind() == Kind::Number. Mutable access assumes the elements will change,
+     * so it takes a private copy of a shared buffer.
+     */
+    const std::vector<double> &numbers() const {
+        return std::get<std::vector<double>>(*storage);
+    }
+    std::vector<double> &numbers() {
+        return std::get<std::vector<double>>(own());
+    }
+
+    /**
+     * Direct access to packed boolean storage (one byte per element)
+     * Only valid while kind() == Kind::Boolean
+     */
+    const std::vector<uint8_t> &booleans() const {
+        return std::get<std::vector<uint8_t>>(*storage);
+    }
+    std::vector<uint8_t> &booleans() {
+        return std::get<std::vector<uint8_t>>(own());
+    }
+
+    /**
+     * Direct access to boxed element storage
+     * Only valid while kind() == Kind::Generic
+     */
+    const std::vector<RuntimeValue> &values() const {
+        return std::get<std::vector<RuntimeValue>>(*storage);
+    }
+    std::vector<RuntimeValue> &values() {
+        return std::get<std::vector<RuntimeValue>>(own());
+    }
+
+    /**
+     * Hash of the elements, for hashValue
+     * Kept until the array next changes when every element is a primitive; a list holding
+     * lists or objects combines their (cached) hashes afresh each time, since they may change
+     * without this array knowing.
+     * @param depth Nesting depth of this array within the value being hashed
+     */
+    size_t contentHash(int depth) const;
+
+private:
+    using Storage = std::variant<std::vector<double>,      // Kind::Number
+                                 std::vector<uint8_t>,     // Kind::Boolean
+                                 std::vector<RuntimeValue> // Kind::Generic
+                                 >;
+
+    // Shared with copies of this array until one of them changes
+    std::shared_ptr<Storage> storage;
+    bool frozen = false;
+
+    // Element buffer plus the text of any strings held, when memory is limited
+    HeapCharge charge;
+    size_t stringBytes = 0;
+
+    // contentHash(), while every element is a primitive
+    HashCache cachedHash;
+
+    /**
+     * The buffer, ready to be changed: copied first if another array shares it
+     */
+    Storage &own() {
+        if (storage.use_count() > 1)
+            storage = std::make_shared<Storage>(*storage);
+        cachedHash.clear();
+        return *storage;
+    }
+
+    void checkMutable() const;
+
+    /**
+     * Bring the charge up to date after a change; no-op when memory is unlimited
+     * @param added Bytes of string text stored by the change
+     * @param removed Bytes of string text released by the change
+     */
+    void account(size_t added = 0, size_t removed = 0) {
+        if (charge.active())
+            recharge(added, removed);
+    }
+    void recharge(size_t added, size_t removed);
+
+    /**
+     * Make sure 'value' can be stored, converting to the generic representation if needed
+     */
+    void prepareFor(const RuntimeValue &value);
+
+    /**
+     * Convert packed storage into the generic representation
+     */
+    void despecialize();
+};
+
+// --- Hashing ---
+
+/**
+ * Whether a value can be a set element or dictionary key: anything but a set or dictionary
+ * Sets and dictionaries store their own copy of a list or object key, so its hash stays valid.
+ */
+bool isHashable(const RuntimeValue &value);
+
+/**
+ * Hash of a hashable value, consistent with valuesEqual: equal values hash equally (so 0 and -0
+ * agree, as do lists with the same elements). Lists and objects are hashed structurally down to
+ * a fixed depth, below which only their sizes count.
+ */
+size_t hashValue(const RuntimeValue &value);
+
+/**
+ * The language's '=='
+ * Values of different types are never equal. Lists are equal when their elements are, and
+ * objects when they share a class and their fields are equal; both stop at reference identity
+ * first and cope with cycles. Functions, sets and dictionaries are equal only to themselves.
+ */
+bool valuesEqual(const RuntimeValue &a, const RuntimeValue &b);
+
+/**
+ * A copy of 'value' that shares no list, object, set or dictionary with it, however deeply they
+ * are nested; lists are still copied in O(1) with copy-on-write. Functions are shared.
+ * @throws NativeError if the copies pass the memory limit
+ */
+RuntimeValue isolatedCopy(const RuntimeValue &value);
+
+// --- Sets and Dictionaries ---
+
+/**
+ * HashTable - the open-addressing table behind sets and dictionaries
+ *
+ * Entries are stored densely in insertion order, so iterating and printing are deterministic,
+ * and a power-of-two array of slots indexes them by hash with linear probing. Removing an entry
+ * leaves a dead entry that lookups step over; dead entries are squeezed out whenever the slot
+ * array is rebuilt, which keeps every operation amortized O(1).
+ */
+class HashTable {
+public:
+    struct Entry {
+        RuntimeValue key;
+        RuntimeValue value; // Unused by sets
+        size_t hash;
+        bool live;
+    };
+
+    size_t size() const {
+        return count;
+    }
+
+    bool contains(const RuntimeValue &key) const {
+        return find(key) != NOT_FOUND;
+    }
+
+    /**
+     * Every entry in insertion order, including removed ones (whose 'live' is false)
+     */
+    const std::vector<Entry> &entries() const {
+        return table;
+    }
+
+    /**
+     * The live keys in insertion order, as a new list
+     */
+    ArrayPtr keys() const;
+
+    /**
+     * Frozen tables are shared read-only between threads; every mutator refuses to run
+     */
+    bool isFrozen() const {
+        return frozen;
+    }
+    void setFrozen(bool value) {
+        frozen = value;
+    }
+
+protected:
+    static constexpr size_t NOT_FOUND = SIZE_MAX;
+
+    /**
+     * Position in entries() of the live entry holding 'key', or NOT_FOUND
+     */
+    size_t find(const RuntimeValue &key) const;
+
+    /**
+     * The entry for 'key', added with a nil value if the table does not hold it yet
+     * @param role What keys are called in error messages, e.g. "Set elements"
+     * @param added Set to whether the entry is new
+     * @throws NativeError if 'key' is not hashable or the table is frozen
+     */
+    Entry &insert(const RuntimeValue &key, const char *role, bool &added);
+
+    /**
+     * Remove the entry for 'key', moving its value into 'value' if given
+     * @return false if the table does not hold 'key'
+     */
+    bool erase(const RuntimeValue &key, RuntimeValue *value);
+
+    void checkMutable(const char *kind) const;
+
+    /**
+     * Bring the charge up to date after a change; no-op when memory is unlimited
+     * @param added Bytes of string text stored by the change
+     * @param removed Bytes of string text released by the change
+     */
+    void account(size_t added = 0, size_t removed = 0) {
+        if (charge.active())
+            recharge(added, removed);
+    }
+
+private:
+    std::vector<Entry> table;
+    // Each slot holds an index into 'table' plus one, or 0 when empty
+    std::vector<uint32_t> slots;
+    size_t count = 0;
+    bool frozen  = false;
+
+    // Entry and slot arrays plus the text of any strings held, when memory is limited
+    HeapCharge charge;
+    size_t stringBytes = 0;
+
+    void recharge(size_t added, size_t removed);
+
+    /**
+     * Drop dead entries and re-index the rest into a slot array sized for 'capacity' entries
+     */
+    void rebuild(size_t capacity);
+};
+
+/**
+ * Set - an unordered collection of distinct hashable values, iterated in insertion order
+ */
+class Set : public HashTable {
+public:
+    /**
+     * Add 'element' unless already present
+     * @return true if it was added
+     * @throws NativeError if 'element' is not hashable, or the set is frozen
+     */
+    bool add(const RuntimeValue &element);
+
+    /**
+     * @return true if 'element' was present
+     */
+    bool remove(const RuntimeValue &element);
+};
+
+/**
+ * Dictionary - a mapping from hashable keys to values, iterated in insertion order
+ */
+class Dictionary : public HashTable {
+public:
+    /**
+     * The value stored under 'key', or null if there is none
+     */
+    const RuntimeValue *get(const RuntimeValue &key) const;
+
+    /**
+     * Store 'value' under 'key', replacing any value already there
+     * @throws NativeError if 'key' is not hashable, or the dictionary is frozen
+     */
+    void set(const RuntimeValue &key, RuntimeValue value);
+
+    /**
+     * Remove 'key', moving its value into 'value'
+     * @return false if there was no such key
+     */
+    bool remove(const RuntimeValue &key, RuntimeValue &value);
+
+    /**
+     * The values in insertion order, as a new list
+     */
+    ArrayPtr values() const;
+};
+
 // --- Exceptions ---
 
 // Thrown for runtime errors (e.g., divide by zero)
@@ -55,6 +546,14 @@ public:
     }
 };
 
+// Thrown by native functions, which have no token of their own; the interpreter
+// rethrows it as a RuntimeError located at the call site
+class NativeError : public std::runtime_error {
+public:
+    NativeError(const std::string &message) : std::runtime_error(message) {
+    }
+};
+
 // Thrown to unwind stack on return statement
 class ReturnException : public std::exception {
 public:
@@ -63,11 +562,53 @@ public:
     }
 };
 
+// Thrown by 'RETURN f(...)' inside a function to have the running function
+// call 'function' in place of itself, reusing its native stack frame
+class TailCallException : public std::exception {
+public:
+    std::shared_ptr<Callable> function;
+    std::vector<RuntimeValue> arguments;
+    TailCallException(std::shared_ptr<Callable> fn, std::vector<RuntimeValue> args)
+        : function(std::move(fn)), arguments(std::move(args)) {
+    }
+};
+
 // --- Environment (Scope) ---
 
 class Environment : public std::enable_shared_from_this<Environment> {
     std::map<std::string, RuntimeValue> values;
     std::shared_ptr<Environment> enclosing;
+    bool frozen = false; // Shared read-only with the iterations of a PARALLEL FOR loop
+    HeapCharge charge;   // Text of the strings held, when memory is limited
+
+    /**
+     * Charge for the string text a variable gains or loses, before it changes
+     * Binds to the thread's account on first use, since the global scope exists before any run.
+     * @throws NativeError (and charges nothing) if the text would pass the memory limit
+     */
+    void recharge(const RuntimeValue *previous, const RuntimeValue &value) {
+        size_t added = value.is<std::string>() ? value.as<std::string>().size() : 0;
+        size_t removed =
+            previous && previous->is<std::string>() ? previous->as<std::string>().size() : 0;
+        if (added == removed)
+            return;
+        if (!charge.active()) {
+            if (!HeapAccount::current())
+                return;
+            charge = HeapCharge();
+        }
+        // Text stored before the account was bound was never charged
+        size_t total = charge.size() + added;
+        charge.resize(total > removed ? total - removed : 0);
+    }
+
+    void recharge(const Token &name, const RuntimeValue *previous, const RuntimeValue &value) {
+        try {
+            recharge(previous, value);
+        } catch (const NativeError &error) {
+            throw RuntimeError(name, error.what());
+        }
+    }
 
 public:
     Environment() : enclosing(nullptr) {
@@ -76,7 +617,23 @@ public:
     }
 
     void define(const std::string &name, RuntimeValue value) {
-        values[name] = value;
+        auto found = values.find(name);
+        if (found != values.end()) {
+            recharge(&found->second, value);
+            found->second = std::move(value);
+        } else {
+            recharge(nullptr, value);
+            values.emplace(name, std::move(value));
+        }
+    }
+
+    // Define 'name', reporting a memory limit error at its token
+    void define(const Token &name, RuntimeValue value) {
+        try {
+            define(name.lexeme, std::move(value));
+        } catch (const NativeError &error) {
+            throw RuntimeError(name, error.what());
+        }
     }
 
     RuntimeValue get(const Token &name) {
@@ -89,9 +646,59 @@ public:
         throw RuntimeError(name, "Undefined variable '" + name.lexeme + "'.");
     }
 
+    // Assign to 'name' in the nearest scope that defines it
+    // @return false (and change nothing) if no enclosing scope defines it
+    bool assignExisting(const Token &name, RuntimeValue value) {
+        for (Environment *env = this; env; env = env->enclosing.get()) {
+            auto it = env->values.find(name.lexeme);
+            if (it != env->values.end()) {
+                env->checkMutable(name);
+                env->recharge(name, &it->second, value);
+                it->second = std::move(value);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool isFrozen() const {
+        return frozen;
+    }
+    void setFrozen(bool value) {
+        frozen = value;
+    }
+
+    const std::map<std::string, RuntimeValue> &getValues() const {
+        return values;
+    }
+
+    void checkMutable(const Token &name) const {
+        if (frozen) {
+            throw RuntimeError(name, "Cannot assign to '" + name.lexeme +
+                                         "' inside a PARALLEL FOR loop; outer variables are "
+                                         "read-only there.");
+        }
+    }
+
+    // Whether 'name' is defined in this scope or any enclosing one
+    bool contains(const std::string &name) const {
+        for (const Environment *env = this; env; env = env->enclosing.get()) {
+            if (env->values.count(name))
+                return true;
+        }
+        return false;
+    }
+
+    std::shared_ptr<Environment> getEnclosing() const {
+        return enclosing;
+    }
+
     void assign(const Token &name, RuntimeValue value) {
-        if (values.count(name.lexeme)) {
-            values[name.lexeme] = value;
+        auto found = values.find(name.lexeme);
+        if (found != values.end()) {
+            checkMutable(name);
+            recharge(name, &found->second, value);
+            found->second = std::move(value);
             return;
         }
         if (enclosing) {
@@ -111,6 +718,10 @@ public:
 struct Callable {
     virtual ~Callable() = default;
     virtual int arity() = 0;
+    // Fewest arguments accepted; callables with optional parameters override this
+    virtual int minArity() {
+        return arity();
+    }
     virtual RuntimeValue call(Interpreter &interpreter, std::vector<RuntimeValue> arguments) = 0;
     virtual std::string toString()                                                           = 0;
 };
@@ -118,10 +729,24 @@ struct Callable {
 struct Instance {
     std::shared_ptr<Callable> klass; // Reference to class (which is a callable)
     std::map<std::string, RuntimeValue> fields;
+    bool frozen = false; // Shared read-only with the iterations of a PARALLEL FOR loop
+    HeapCharge charge;   // Fields held against the program's memory limit, if any
 
     Instance(std::shared_ptr<Callable> k) : klass(k) {
+        if (charge.active())
+            charge.resize(sizeof(Instance));
     }
 
+    /**
+     * Hash of the class and fields, for hashValue; cached like Array::contentHash
+     */
+    size_t contentHash(int depth) const;
+
+    /**
+     * A shallow copy: the same class, and fields holding the same values
+     */
+    std::shared_ptr<Instance> copy() const;
+
     RuntimeValue get(const Token &name) {
         if (fields.count(name.lexeme)) {
             return fields.at(name.lexeme);
@@ -132,8 +757,25 @@ struct Instance {
     }
 
     void set(const Token &name, RuntimeValue value) {
-        fields[name.lexeme] = value;
+        if (frozen) {
+            throw RuntimeError(name, "Cannot modify a shared object inside a PARALLEL FOR loop.");
+        }
+        auto field = fields.find(name.lexeme);
+        if (charge.active())
+            recharge(name, field == fields.end() ? nullptr : &field->second, value);
+        if (field == fields.end())
+            fields.emplace(name.lexeme, std::move(value));
+        else
+            field->second = std::move(value);
+        cachedHash.clear();
     }
+
+private:
+    // contentHash(), while every field holds a primitive
+    HashCache cachedHash;
+
+    // Charge for a new or changed field; defined in runtime.cpp
+    void recharge(const Token &name, const RuntimeValue *previous, const RuntimeValue &value);
 };
 
 // Helper to stringify values
@@ -152,11 +794,11 @@ inline std::string stringify(const RuntimeValue &v) {
         return v.as<bool>() ? "true" : "false";
     if (v.is<std::string>())
         return v.as<std::string>();
-    if (v.is<std::shared_ptr<std::vector<RuntimeValue>>>()) {
-        auto arr           = v.as<std::shared_ptr<std::vector<RuntimeValue>>>();
+    if (v.is<ArrayPtr>()) {
+        auto arr           = v.as<ArrayPtr>();
         std::string result = "[";
         for (size_t i = 0; i < arr->size(); ++i) {
-            result += stringify((*arr)[i]);
+            result += stringify(arr->get(i));
             if (i < arr->size() - 1)
                 result += ", ";
         }
@@ -167,5 +809,25 @@ inline std::string stringify(const RuntimeValue &v) {
         return v.as<std::shared_ptr<Callable>>()->toString();
     if (v.is<std::shared_ptr<Instance>>())
         return "Instance";
+    if (v.is<SetPtr>() || v.is<DictionaryPtr>()) {
+        // Sets print as {a, b}, dictionaries as {key: value, ...}
+        bool dictionary    = v.is<DictionaryPtr>();
+        const auto &table  = dictionary ? static_cast<const HashTable &>(*v.as<DictionaryPtr>())
+                                        : static_cast<const HashTable &>(*v.as<SetPtr>());
+        std::string result = "{";
+        bool first         = true;
+        for (const auto &entry : table.entries()) {
+            if (!entry.live)
+                continue;
+            if (!first)
+                result += ", ";
+            first = false;
+            result += stringify(entry.key);
+            if (dictionary)
+                result += ": " + stringify(entry.value);
+        }
+        result += "}";
+        return result;
+    }
     return "unknown";
 }
@@ -0,0 +1,213 @@
+#include "scan.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SCAN_X86 1
+#endif
+
+namespace scan {
+namespace {
+
+// Every implementation fills in one of these; the best available table is chosen at startup
+struct ScanTable {
+    size_t (*whitespace)(const char *, size_t);
+    size_t (*identifier)(const char *, size_t);
+    size_t (*newlines)(const char *, size_t);
+    const char *name;
+};
+
+// ============================================================
+// Scalar Fallback
+// ============================================================
+
+bool isWhitespace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+bool isIdentifierChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+           c == '_';
+}
+
+size_t whitespaceScalar(const char *text, size_t n) {
+    size_t i = 0;
+    while (i < n && isWhitespace(text[i]))
+        ++i;
+    return i;
+}
+
+size_t identifierScalar(const char *text, size_t n) {
+    size_t i = 0;
+    while (i < n && isIdentifierChar(text[i]))
+        ++i;
+    return i;
+}
+
+size_t newlinesScalar(const char *text, size_t n) {
+    size_t count = 0;
+    for (size_t i = 0; i < n; ++i)
+        count += text[i] == '\n';
+    return count;
+}
+
+#ifdef SCAN_X86
+
+// ============================================================
+// SSE2 (16 characters per register)
+// ============================================================
+
+// Each class test sets a lane to all ones where the character belongs to the class. Compares
+// are signed, so bytes of 0x80 and above (UTF-8) fall outside every range, as with isalnum.
+
+__attribute__((target("sse2"))) __m128i whitespaceLanesSse2(__m128i chunk) {
+    __m128i space   = _mm_cmpeq_epi8(chunk, _mm_set1_epi8(' '));
+    __m128i tab     = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t'));
+    __m128i ret     = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r'));
+    __m128i newline = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n'));
+    return _mm_or_si128(_mm_or_si128(space, tab), _mm_or_si128(ret, newline));
+}
+
+__attribute__((target("sse2"))) __m128i identifierLanesSse2(__m128i chunk) {
+    // Setting bit 5 folds 'A'-'Z' onto 'a'-'z' and moves no other byte into that range
+    __m128i lower  = _mm_or_si128(chunk, _mm_set1_epi8(0x20));
+    __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                                   _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+    __m128i digit  = _mm_and_si128(_mm_cmpgt_epi8(chunk, _mm_set1_epi8('0' - 1)),
+                                   _mm_cmplt_epi8(chunk, _mm_set1_epi8('9' + 1)));
+    __m128i under  = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('_'));
+    return _mm_or_si128(_mm_or_si128(letter, digit), under);
+}
+
+__attribute__((target("sse2"))) size_t whitespaceSse2(const char *text, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i));
+        unsigned outside = ~(unsigned) _mm_movemask_epi8(whitespaceLanesSse2(chunk)) & 0xFFFF;
+        if (outside)
+            return i + __builtin_ctz(outside);
+    }
+    return i + whitespaceScalar(text + i, n - i);
+}
+
+__attribute__((target("sse2"))) size_t identifierSse2(const char *text, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i));
+        unsigned outside = ~(unsigned) _mm_movemask_epi8(identifierLanesSse2(chunk)) & 0xFFFF;
+        if (outside)
+            return i + __builtin_ctz(outside);
+    }
+    return i + identifierScalar(text + i, n - i);
+}
+
+__attribute__((target("sse2"))) size_t newlinesSse2(const char *text, size_t n) {
+    __m128i newline = _mm_set1_epi8('\n');
+    size_t count    = 0;
+    size_t i        = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i));
+        count += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)));
+    }
+    return count + newlinesScalar(text + i, n - i);
+}
+
+// ============================================================
+// AVX2 (32 characters per register)
+// ============================================================
+
+__attribute__((target("avx2"))) __m256i whitespaceLanesAvx2(__m256i chunk) {
+    __m256i space   = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(' '));
+    __m256i tab     = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\t'));
+    __m256i ret     = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\r'));
+    __m256i newline = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n'));
+    return _mm256_or_si256(_mm256_or_si256(space, tab), _mm256_or_si256(ret, newline));
+}
+
+__attribute__((target("avx2"))) __m256i identifierLanesAvx2(__m256i chunk) {
+    __m256i lower  = _mm256_or_si256(chunk, _mm256_set1_epi8(0x20));
+    __m256i letter = _mm256_andnot_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('z')),
+                                         _mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)));
+    __m256i digit  = _mm256_andnot_si256(_mm256_cmpgt_epi8(chunk, _mm256_set1_epi8('9')),
+                                         _mm256_cmpgt_epi8(chunk, _mm256_set1_epi8('0' - 1)));
+    __m256i under  = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('_'));
+    return _mm256_or_si256(_mm256_or_si256(letter, digit), under);
+}
+
+__attribute__((target("avx2"))) size_t whitespaceAvx2(const char *text, size_t n) {
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + i));
+        unsigned outside = ~(unsigned) _mm256_movemask_epi8(whitespaceLanesAvx2(chunk));
+        if (outside)
+            return i + __builtin_ctz(outside);
+    }
+    return i + whitespaceSse2(text + i, n - i);
+}
+
+__attribute__((target("avx2"))) size_t identifierAvx2(const char *text, size_t n) {
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + i));
+        unsigned outside = ~(unsigned) _mm256_movemask_epi8(identifierLanesAvx2(chunk));
+        if (outside)
+            return i + __builtin_ctz(outside);
+    }
+    return i + identifierSse2(text + i, n - i);
+}
+
+__attribute__((target("avx2"))) size_t newlinesAvx2(const char *text, size_t n) {
+    __m256i newline = _mm256_set1_epi8('\n');
+    size_t count    = 0;
+    size_t i        = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + i));
+        count += __builtin_popcount(
+            (unsigned) _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, newline)));
+    }
+    return count + newlinesSse2(text + i, n - i);
+}
+
+#endif // SCAN_X86
+
+// ============================================================
+// Runtime Dispatch
+// ============================================================
+
+ScanTable selectScans() {
+#ifdef SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return {whitespaceAvx2, identifierAvx2, newlinesAvx2, "avx2"};
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return {whitespaceSse2, identifierSse2, newlinesSse2, "sse2"};
+    }
+#endif
+    return {whitespaceScalar, identifierScalar, newlinesScalar, "scalar"};
+}
+
+const ScanTable &scanTable() {
+    // Initialised once, thread-safely, on first use
+    static const ScanTable table = selectScans();
+    return table;
+}
+
+} // namespace
+
+size_t whitespace(const char *text, size_t n) {
+    return scanTable().whitespace(text, n);
+}
+
+size_t identifier(const char *text, size_t n) {
+    return scanTable().identifier(text, n);
+}
+
+size_t newlines(const char *text, size_t n) {
+    return scanTable().newlines(text, n);
+}
+
+const char *isaName() {
+    return scanTable().name;
+}
+
+} // namespace scan
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+
+/**
+ * Character-class scanning for the lexer
+ *
+ * Each scan has an AVX2 (32 bytes at a time), an SSE2 (16 bytes at a time) and a portable scalar
+ * implementation; as with the numeric kernels, the widest one the running CPU supports is picked
+ * once, on first use. Searches for a single character (a comment's line end, a string's closing
+ * quote) are left to memchr, which the C library already vectorizes.
+ */
+namespace scan {
+
+/**
+ * Length of the run of spaces, tabs, carriage returns and newlines at the start of 'text'
+ */
+size_t whitespace(const char *text, size_t n);
+
+/**
+ * Length of the run of ASCII letters, digits and underscores at the start of 'text'
+ */
+size_t identifier(const char *text, size_t n);
+
+/**
+ * Number of newlines in the first n characters of 'text'
+ */
+size_t newlines(const char *text, size_t n);
+
+/**
+ * Name of the instruction set the scans were dispatched to ("avx2", "sse2" or "scalar")
+ */
+const char *isaName();
+
+} // namespace scan
@@ -0,0 +1,78 @@
+#include "scsa.hpp"
+#include "errors.hpp"
+#include "lexer.hpp"
+#include "parser.hpp"
+
+#include <sstream>
+
+// --- RunOptions ---
+
+/**
+ * Apply the engine, memoization and limit options to an interpreter
+ * The VM keeps its frames on the heap, so it defaults to a far deeper recursion limit.
+ * @param interpreter The interpreter to configure
+ */
+void RunOptions::configure(Interpreter &interpreter) const {
+    interpreter.useVM  = useVM;
+    interpreter.useJit = useJit;
+    interpreter.limits = limits;
+    if (maxCallDepth > 0)
+        interpreter.maxCallDepth = maxCallDepth;
+    else if (useVM)
+        interpreter.maxCallDepth = 1000000;
+    if (memoize)
+        interpreter.memo = std::make_unique<MemoCache>(memoSize);
+}
+
+// --- Program ---
+
+std::shared_ptr<const Program> Program::compile(const std::string &source,
+                                                const std::string &name) {
+    // Not make_shared: the constructor is private
+    std::shared_ptr<Program> program(new Program());
+    program->source = source;
+
+    std::ostringstream report;
+    InterpreterStage stage = InterpreterStage::Lexing;
+    ErrorReporter reporter(stage, name, program->source, report);
+    try {
+        Lexer lexer(program->source, reporter);
+        std::vector<Token> tokens = lexer.scanTokens();
+
+        stage = InterpreterStage::Parsing;
+        Parser parser(tokens, program->source, reporter);
+        program->ast = parser.parse();
+    } catch (const std::exception &e) {
+        // Reported errors are already in the report; anything else is added to it
+        if (!reporter.hadError())
+            report << e.what() << std::endl;
+        throw CompileError(report.str());
+    }
+    if (reporter.hadError())
+        throw CompileError(report.str());
+    return program;
+}
+
+RunResult Program::run(const std::map<std::string, RuntimeValue> &bindings,
+                       const RunOptions &options) const {
+    std::ostringstream out, err;
+    Interpreter interpreter;
+    options.configure(interpreter);
+    interpreter.output      = &out;
+    interpreter.errorOutput = &err;
+
+    RunResult result;
+    try {
+        // Copies, so that neither the caller nor other runs see what this run changes
+        for (const auto &binding : bindings) {
+            interpreter.globals->define(binding.first, isolatedCopy(binding.second));
+        }
+        result.status = interpreter.interpret(ast) ? 0 : 1;
+    } catch (const std::exception &e) {
+        err << e.what() << std::endl;
+        result.status = 1;
+    }
+    result.output = out.str();
+    result.errors = err.str();
+    return result;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "ast.hpp"
+#include "interpreter.hpp"
+#include "limits.hpp"
+#include "runtime.hpp"
+
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * scsa.hpp - embedding API
+ *
+ * Compile a program once, then run it as many times as needed, each run in a fresh interpreter
+ * with its own input bindings and captured output:
+ *
+ *     auto program = Program::compile(source, "marker.scsa");
+ *     for (double input : inputs) {
+ *         RunResult result = program->run({{"n", {input}}});
+ *         check(result.output);
+ *     }
+ *
+ * A compiled Program is immutable, so several threads may run it at once.
+ */
+
+/**
+ * RunOptions - engine, memoization and limit settings for running a program
+ */
+struct RunOptions {
+    bool useVM      = false; // Run on the stack VM instead of the tree walker
+    bool useJit     = true;  // Compile hot numeric functions to native code
+    bool memoize    = false; // Cache results of pure functions
+    size_t memoSize = 10000; // Most results kept by the memoization cache
+
+    /**
+     * Maximum depth of nested pseudocode function calls before a RuntimeError
+     * 0 selects the engine's default: 1000 for the tree walker, 1000000 for the VM.
+     */
+    int maxCallDepth = 0;
+
+    // Step, memory and time caps; unlimited by default
+    ExecutionLimits limits;
+
+    /**
+     * Apply these options to a new interpreter
+     */
+    void configure(Interpreter &interpreter) const;
+};
+
+/**
+ * RunResult - what one run of a program produced
+ */
+struct RunResult {
+    int status = 0;     // 0 on success, 1 if the program stopped on an error
+    std::string output; // Everything the program printed
+    std::string errors; // Runtime error report, if any
+};
+
+/**
+ * CompileError - a program had lexing or parsing errors
+ * what() holds the formatted report of every error found.
+ */
+class CompileError : public std::runtime_error {
+public:
+    CompileError(const std::string &report) : std::runtime_error(report) {
+    }
+};
+
+/**
+ * Program - a lexed and parsed pseudocode program that can be run many times
+ */
+class Program {
+public:
+    /**
+     * Lex and parse a program
+     * @param source The program text
+     * @param name File name shown in error reports
+     * @throws CompileError if the source has any lexing or parsing error
+     */
+    static std::shared_ptr<const Program> compile(const std::string &source,
+                                                  const std::string &name = "");
+
+    /**
+     * Run the program in a fresh interpreter
+     * @param bindings Global variables defined before the program starts; the run gets its own
+     * copies of any lists, objects, sets and dictionaries, so it never changes the caller's
+     * @param options Engine and limit settings for this run
+     * @return The run's exit status and captured output
+     */
+    RunResult run(const std::map<std::string, RuntimeValue> &bindings = {},
+                  const RunOptions &options = {}) const;
+
+    const std::vector<StmtPtr> &statements() const {
+        return ast;
+    }
+
+private:
+    Program() = default;
+
+    std::string source;
+    std::vector<StmtPtr> ast; // Functions declared by a run point into this tree
+};
@@ -0,0 +1,323 @@
+#include "builtins.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+// ============================================================
+// Argument Helpers
+// ============================================================
+
+static double numberArg(ArgSpan args, size_t index, const char *fnName) {
+    if (!args[index].is<double>()) {
+        throw NativeError(std::string(fnName) + " expects a number.");
+    }
+    return args[index].as<double>();
+}
+
+static const std::string &stringArg(ArgSpan args, size_t index, const char *fnName) {
+    if (!args[index].is<std::string>()) {
+        throw NativeError(std::string(fnName) + " expects a string.");
+    }
+    return args[index].as<std::string>();
+}
+
+static double positionArg(ArgSpan args, size_t index, const char *fnName) {
+    double value = numberArg(args, index, fnName);
+    if (!std::isfinite(value) || std::trunc(value) != value) {
+        throw NativeError(std::string(fnName) + " expects a whole number.");
+    }
+    return value;
+}
+
+/**
+ * Check that a string of 'bytes' more would fit under the memory limit, if there is one
+ * Strings are not charged to the account, so builders check before they allocate.
+ */
+static void requireText(size_t bytes) {
+    if (const auto &heap = HeapAccount::current())
+        heap->require(bytes);
+}
+
+// ============================================================
+// Math
+// ============================================================
+
+static RuntimeValue nativeAbs(Interpreter &, ArgSpan args) {
+    return {std::fabs(numberArg(args, 0, "ABS"))};
+}
+
+static RuntimeValue nativeSqrt(Interpreter &, ArgSpan args) {
+    double x = numberArg(args, 0, "SQRT");
+    if (x < 0) {
+        throw NativeError("SQRT of a negative number.");
+    }
+    return {std::sqrt(x)};
+}
+
+static RuntimeValue nativeFloor(Interpreter &, ArgSpan args) {
+    return {std::floor(numberArg(args, 0, "FLOOR"))};
+}
+
+static RuntimeValue nativeCeil(Interpreter &, ArgSpan args) {
+    return {std::ceil(numberArg(args, 0, "CEIL"))};
+}
+
+static RuntimeValue nativeRound(Interpreter &, ArgSpan args) {
+    double x = numberArg(args, 0, "ROUND");
+    if (args.size() == 1) {
+        return {std::round(x)};
+    }
+    // ROUND(x, places)
+    double scale = std::pow(10.0, numberArg(args, 1, "ROUND"));
+    return {std::round(x * scale) / scale};
+}
+
+static RuntimeValue nativePow(Interpreter &, ArgSpan args) {
+    return {std::pow(numberArg(args, 0, "POW"), numberArg(args, 1, "POW"))};
+}
+
+static RuntimeValue nativeMod(Interpreter &, ArgSpan args) {
+    double divisor = numberArg(args, 1, "MOD");
+    if (divisor == 0) {
+        throw NativeError("MOD by zero.");
+    }
+    return {std::fmod(numberArg(args, 0, "MOD"), divisor)};
+}
+
+static RuntimeValue nativeSin(Interpreter &, ArgSpan args) {
+    return {std::sin(numberArg(args, 0, "SIN"))};
+}
+
+static RuntimeValue nativeCos(Interpreter &, ArgSpan args) {
+    return {std::cos(numberArg(args, 0, "COS"))};
+}
+
+static RuntimeValue nativeTan(Interpreter &, ArgSpan args) {
+    return {std::tan(numberArg(args, 0, "TAN"))};
+}
+
+static RuntimeValue nativeLog(Interpreter &, ArgSpan args) {
+    double x = numberArg(args, 0, "LOG");
+    if (x <= 0) {
+        throw NativeError("LOG of a non-positive number.");
+    }
+    return {std::log(x)};
+}
+
+static RuntimeValue nativeExp(Interpreter &, ArgSpan args) {
+    return {std::exp(numberArg(args, 0, "EXP"))};
+}
+
+static RuntimeValue nativeRandom(Interpreter &, ArgSpan) {
+    // One generator per thread, so concurrent interpreters never share state
+    thread_local std::mt19937_64 generator{std::random_device{}()};
+    return {std::uniform_real_distribution<double>(0.0, 1.0)(generator)};
+}
+
+// ============================================================
+// Strings
+// ============================================================
+
+static RuntimeValue nativeLength(Interpreter &, ArgSpan args) {
+    if (args[0].is<std::string>()) {
+        return {(double) args[0].as<std::string>().size()};
+    }
+    if (args[0].is<ArrayPtr>()) {
+        return {(double) args[0].as<ArrayPtr>()->size()};
+    }
+    if (args[0].is<SetPtr>()) {
+        return {(double) args[0].as<SetPtr>()->size()};
+    }
+    if (args[0].is<DictionaryPtr>()) {
+        return {(double) args[0].as<DictionaryPtr>()->size()};
+    }
+    throw NativeError("LENGTH expects a string, list, set or dictionary.");
+}
+
+static RuntimeValue nativeUpper(Interpreter &, ArgSpan args) {
+    requireText(stringArg(args, 0, "UPPER").size());
+    std::string text = args[0].as<std::string>();
+    std::transform(text.begin(), text.end(), text.begin(),
+                   [](unsigned char c) { return (char) std::toupper(c); });
+    return {text};
+}
+
+static RuntimeValue nativeLower(Interpreter &, ArgSpan args) {
+    requireText(stringArg(args, 0, "LOWER").size());
+    std::string text = args[0].as<std::string>();
+    std::transform(text.begin(), text.end(), text.begin(),
+                   [](unsigned char c) { return (char) std::tolower(c); });
+    return {text};
+}
+
+static RuntimeValue nativeSubstring(Interpreter &, ArgSpan args) {
+    // SUBSTRING(text, start [, length]); out-of-range bounds are clamped
+    const std::string &text = stringArg(args, 0, "SUBSTRING");
+    double size             = (double) text.size();
+    double start            = std::clamp(positionArg(args, 1, "SUBSTRING"), 0.0, size);
+    double length           = size - start;
+    if (args.size() > 2) {
+        length = std::clamp(positionArg(args, 2, "SUBSTRING"), 0.0, size - start);
+    }
+    requireText((size_t) length);
+    return {text.substr((size_t) start, (size_t) length)};
+}
+
+static RuntimeValue nativeString(Interpreter &, ArgSpan args) {
+    std::string text = stringify(args[0]);
+    requireText(text.size());
+    return {text};
+}
+
+static RuntimeValue nativeNumber(Interpreter &, ArgSpan args) {
+    const std::string &text = stringArg(args, 0, "NUMBER");
+    try {
+        size_t used  = 0;
+        double value = std::stod(text, &used);
+        if (used == text.size())
+            return {value};
+    } catch (const std::exception &) {
+    }
+    throw NativeError("NUMBER could not convert '" + text + "'.");
+}
+
+static RuntimeValue nativeSplit(Interpreter &, ArgSpan args) {
+    const std::string &text      = stringArg(args, 0, "SPLIT");
+    const std::string &separator = stringArg(args, 1, "SPLIT");
+    if (separator.empty()) {
+        throw NativeError("SPLIT separator must not be empty.");
+    }
+
+    auto parts   = std::make_shared<Array>();
+    size_t start = 0;
+    size_t found;
+    while ((found = text.find(separator, start)) != std::string::npos) {
+        parts->push({text.substr(start, found - start)});
+        start = found + separator.size();
+    }
+    parts->push({text.substr(start)});
+    return {parts};
+}
+
+static RuntimeValue nativeJoin(Interpreter &, ArgSpan args) {
+    if (!args[0].is<ArrayPtr>()) {
+        throw NativeError("JOIN expects a list.");
+    }
+    const Array &parts           = *args[0].as<ArrayPtr>();
+    const std::string &separator = stringArg(args, 1, "JOIN");
+
+    std::string joined;
+    for (size_t i = 0; i < parts.size(); ++i) {
+        std::string part = stringify(parts.get(i));
+        requireText(joined.size() + separator.size() + part.size());
+        if (i > 0)
+            joined += separator;
+        joined += part;
+    }
+    return {joined};
+}
+
+// ============================================================
+// Collections
+// ============================================================
+
+static RuntimeValue nativeCopy(Interpreter &, ArgSpan args) {
+    // O(1): the elements are only copied when one of the two lists is first changed
+    if (!args[0].is<ArrayPtr>()) {
+        throw NativeError("COPY expects a list.");
+    }
+    return {args[0].as<ArrayPtr>()->copy()};
+}
+
+static RuntimeValue nativeSet(Interpreter &, ArgSpan args) {
+    // SET() is empty; SET(list) holds the list's distinct elements
+    auto set = std::make_shared<Set>();
+    if (args.size() == 1) {
+        if (!args[0].is<ArrayPtr>()) {
+            throw NativeError("SET expects a list.");
+        }
+        const Array &elements = *args[0].as<ArrayPtr>();
+        for (size_t i = 0; i < elements.size(); ++i) {
+            set->add(elements.get(i));
+        }
+    }
+    return {set};
+}
+
+static RuntimeValue nativeDictionary(Interpreter &, ArgSpan args) {
+    // DICTIONARY() is empty; DICTIONARY(keys, values) pairs up two lists of the same length
+    auto dictionary = std::make_shared<Dictionary>();
+    if (args.size() > 0) {
+        if (args.size() != 2 || !args[0].is<ArrayPtr>() || !args[1].is<ArrayPtr>()) {
+            throw NativeError("DICTIONARY expects a list of keys and a list of values.");
+        }
+        const Array &keys   = *args[0].as<ArrayPtr>();
+        const Array &values = *args[1].as<ArrayPtr>();
+        if (keys.size() != values.size()) {
+            throw NativeError("DICTIONARY expects as many values as keys.");
+        }
+        for (size_t i = 0; i < keys.size(); ++i) {
+            dictionary->set(keys.get(i), values.get(i));
+        }
+    }
+    return {dictionary};
+}
+
+// ============================================================
+// Time
+// ============================================================
+
+static RuntimeValue nativeClock(Interpreter &, ArgSpan) {
+    // Seconds on a monotonic clock, for measuring elapsed time
+    using namespace std::chrono;
+    return {duration<double>(steady_clock::now().time_since_epoch()).count()};
+}
+
+static RuntimeValue nativeTime(Interpreter &, ArgSpan) {
+    // Seconds since the Unix epoch
+    using namespace std::chrono;
+    return {duration<double>(system_clock::now().time_since_epoch()).count()};
+}
+
+// ============================================================
+// Registration
+// ============================================================
+
+void registerStdlib(NativeRegistry &registry) {
+    registry.add("ABS", 1, nativeAbs);
+    registry.add("SQRT", 1, nativeSqrt);
+    registry.add("FLOOR", 1, nativeFloor);
+    registry.add("CEIL", 1, nativeCeil);
+    registry.add("ROUND", 1, 2, nativeRound);
+    registry.add("POW", 2, nativePow);
+    registry.add("MOD", 2, nativeMod);
+    registry.add("SIN", 1, nativeSin);
+    registry.add("COS", 1, nativeCos);
+    registry.add("TAN", 1, nativeTan);
+    registry.add("LOG", 1, nativeLog);
+    registry.add("EXP", 1, nativeExp);
+    registry.add("RANDOM", 0, nativeRandom);
+
+    registry.add("LENGTH", 1, nativeLength);
+    registry.add("UPPER", 1, nativeUpper);
+    registry.add("LOWER", 1, nativeLower);
+    registry.add("SUBSTRING", 2, 3, nativeSubstring);
+    registry.add("STRING", 1, nativeString);
+    registry.add("NUMBER", 1, nativeNumber);
+    registry.add("SPLIT", 2, nativeSplit);
+    registry.add("JOIN", 2, nativeJoin);
+
+    registry.add("COPY", 1, nativeCopy);
+    registry.add("SET", 0, 1, nativeSet);
+    registry.add("DICTIONARY", 0, 2, nativeDictionary);
+
+    registry.add("CLOCK", 0, nativeClock);
+    registry.add("TIME", 0, nativeTime);
+
+    // Results that change from call to call must never be memoized
+    registry.markImpure("RANDOM");
+    registry.markImpure("CLOCK");
+    registry.markImpure("TIME");
+}
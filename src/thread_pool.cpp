@@ -0,0 +1,135 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+
+// Worker index of the current thread, -1 for threads outside any pool
+static thread_local int workerIndex = -1;
+
+ThreadPool::ThreadPool(size_t threads) {
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (size_t i = 0; i < threads; ++i) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    for (size_t i = 0; i < threads; ++i) {
+        workers.emplace_back([this, i] { workerLoop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+static size_t sharedSize = 0;
+
+ThreadPool &ThreadPool::shared() {
+    static ThreadPool pool(sharedSize);
+    return pool;
+}
+
+void ThreadPool::setSharedSize(size_t threads) {
+    sharedSize = threads;
+}
+
+int ThreadPool::currentWorker() {
+    return workerIndex;
+}
+
+void ThreadPool::submit(Task task) {
+    // Spread new tasks round-robin; idle workers steal whatever lands unevenly
+    size_t target = nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+    {
+        std::lock_guard<std::mutex> lock(queues[target]->mutex);
+        queues[target]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        queued++;
+    }
+    wake.notify_one();
+}
+
+bool ThreadPool::takeTask(size_t worker, Task &task) {
+    // Own deque first, from the front
+    {
+        Queue &own = *queues[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.front());
+            own.tasks.pop_front();
+            return true;
+        }
+    }
+    // Then steal from the back of the others'
+    for (size_t offset = 1; offset < queues.size(); ++offset) {
+        Queue &victim = *queues[(worker + offset) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.back());
+            victim.tasks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(size_t worker) {
+    workerIndex = (int) worker;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wake.wait(lock, [this] { return stopping || queued > 0; });
+            if (stopping && queued == 0)
+                return;
+        }
+
+        Task task;
+        if (takeTask(worker, task)) {
+            queued--;
+            task(worker);
+        }
+    }
+}
+
+void ThreadPool::parallelFor(size_t count,
+                             const std::function<void(size_t index, size_t worker)> &body) {
+    if (count == 0)
+        return;
+    if (currentWorker() >= 0) {
+        for (size_t i = 0; i < count; ++i) {
+            body(i, 0);
+        }
+        return;
+    }
+
+    // A few chunks per worker keeps scheduling overhead low while leaving work to steal
+    size_t chunks    = std::min(count, size() * 4);
+    size_t chunkSize = (count + chunks - 1) / chunks;
+
+    std::mutex doneMutex;
+    std::condition_variable done;
+    size_t remaining = (count + chunkSize - 1) / chunkSize;
+
+    for (size_t first = 0; first < count; first += chunkSize) {
+        size_t last = std::min(count, first + chunkSize);
+        submit([&, first, last](size_t worker) {
+            for (size_t i = first; i < last; ++i) {
+                body(i, worker);
+            }
+            std::lock_guard<std::mutex> lock(doneMutex);
+            if (--remaining == 0)
+                done.notify_one();
+        });
+    }
+
+    std::unique_lock<std::mutex> lock(doneMutex);
+    done.wait(lock, [&] { return remaining == 0; });
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * ThreadPool - a fixed set of worker threads with work stealing
+ *
+ * Every worker owns a task deque. Workers take tasks from the front of their own deque and,
+ * once it is empty, steal from the back of the others', so uneven work spreads itself out.
+ */
+class ThreadPool {
+public:
+    using Task = std::function<void(size_t worker)>;
+
+    /**
+     * @param threads Number of workers; 0 uses one per hardware thread
+     */
+    explicit ThreadPool(size_t threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &)            = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * The process-wide pool, created on first use with one worker per hardware thread
+     */
+    static ThreadPool &shared();
+
+    /**
+     * Choose the shared pool's size; only effective before its first use
+     */
+    static void setSharedSize(size_t threads);
+
+    size_t size() const {
+        return workers.size();
+    }
+
+    /**
+     * Queue a task; it receives the index of the worker running it
+     */
+    void submit(Task task);
+
+    /**
+     * Run body(index, worker) for every index in [0, count) and wait for all of them
+     * The body must not throw; capture errors and report them after the loop.
+     * Called from inside a pool task, the loop runs inline (as worker 0) instead, since
+     * blocking a worker on a pool could deadlock it.
+     */
+    void parallelFor(size_t count, const std::function<void(size_t index, size_t worker)> &body);
+
+    /**
+     * The index of the pool worker running the calling thread, or -1 outside any pool
+     */
+    static int currentWorker();
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::atomic<size_t> queued{0}; // Tasks waiting in any deque
+    std::atomic<size_t> nextQueue{0};
+    bool stopping = false;
+
+    void workerLoop(size_t worker);
+    bool takeTask(size_t worker, Task &task);
+};
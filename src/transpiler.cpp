@@ -0,0 +1,1015 @@
+#include "transpiler.hpp"
+#include "builtins.hpp"
+
+#include <stdexcept>
+
+namespace {
+
+// ============================================================
+// Name Analysis
+// ============================================================
+
+/**
+ * NameScan - the variables a piece of code assigns, the names it reads and the functions it
+ * declares. A shallow scan stays in one scope: it covers IF and WHILE bodies, which share their
+ * enclosing scope, but not loops, blocks or functions, which open their own.
+ */
+struct NameScan {
+    bool deep = false;
+    std::set<std::string> assigned;
+    std::set<std::string> used;
+    std::vector<FunctionStmt *> functions;
+
+    void statements(const std::vector<StmtPtr> &body) {
+        for (const auto &stmt : body)
+            statement(stmt.get());
+    }
+
+    void statement(Stmt *stmt) {
+        if (auto expression = dynamic_cast<ExpressionStmt *>(stmt)) {
+            expr(expression->expression.get());
+        } else if (auto print = dynamic_cast<PrintStmt *>(stmt)) {
+            expr(print->expression.get());
+        } else if (auto ret = dynamic_cast<ReturnStmt *>(stmt)) {
+            expr(ret->value.get());
+        } else if (auto branch = dynamic_cast<IfStmt *>(stmt)) {
+            expr(branch->condition.get());
+            statements(branch->thenBranch);
+            statements(branch->elseBranch);
+        } else if (auto loop = dynamic_cast<WhileStmt *>(stmt)) {
+            expr(loop->condition.get());
+            statements(loop->body);
+        } else if (auto forIn = dynamic_cast<ForInStmt *>(stmt)) {
+            expr(forIn->iterable.get());
+            if (deep)
+                statements(forIn->body);
+        } else if (auto block = dynamic_cast<BlockStmt *>(stmt)) {
+            if (deep)
+                statements(block->statements);
+        } else if (auto function = dynamic_cast<FunctionStmt *>(stmt)) {
+            functions.push_back(function);
+            if (deep)
+                statements(function->body);
+        }
+    }
+
+    void expr(Expr *expr) {
+        if (!expr)
+            return;
+        if (auto variable = dynamic_cast<VariableExpr *>(expr)) {
+            used.insert(variable->name.lexeme);
+        } else if (auto assign = dynamic_cast<AssignExpr *>(expr)) {
+            if (auto target = dynamic_cast<VariableExpr *>(assign->target.get()))
+                assigned.insert(target->name.lexeme);
+            else
+                this->expr(assign->target.get());
+            this->expr(assign->value.get());
+        } else if (auto binary = dynamic_cast<BinaryExpr *>(expr)) {
+            this->expr(binary->left.get());
+            this->expr(binary->right.get());
+        } else if (auto call = dynamic_cast<CallExpr *>(expr)) {
+            this->expr(call->callee.get());
+            for (const auto &arg : call->args)
+                this->expr(arg.get());
+        } else if (auto get = dynamic_cast<GetExpr *>(expr)) {
+            this->expr(get->object.get());
+        } else if (auto access = dynamic_cast<ArrayAccessExpr *>(expr)) {
+            this->expr(access->array.get());
+            this->expr(access->index.get());
+        } else if (auto list = dynamic_cast<ArrayLitExpr *>(expr)) {
+            for (const auto &element : list->elements)
+                this->expr(element.get());
+        } else if (auto slice = dynamic_cast<SliceExpr *>(expr)) {
+            this->expr(slice->array.get());
+            this->expr(slice->start.get());
+            this->expr(slice->end.get());
+        } else if (auto instance = dynamic_cast<NewExpr *>(expr)) {
+            used.insert(instance->className.lexeme);
+            for (const auto &arg : instance->args)
+                this->expr(arg.get());
+        }
+    }
+};
+
+// The names a scope defines: what its code assigns and the functions it declares
+std::set<std::string> scopeNames(const std::vector<StmtPtr> &body) {
+    NameScan scan;
+    scan.statements(body);
+    for (FunctionStmt *function : scan.functions)
+        scan.assigned.insert(function->name.lexeme);
+    return scan.assigned;
+}
+
+[[noreturn]] void unsupported(int line, const std::string &what) {
+    throw std::runtime_error("Line " + std::to_string(line) + ": --emit-cpp does not support " +
+                             what + ".");
+}
+
+// ============================================================
+// C++ Spelling
+// ============================================================
+
+const char *tokenTypeName(TokenType type) {
+    switch (type) {
+    case TOK_EOF:
+        return "TOK_EOF";
+    case TOK_IDENTIFIER:
+        return "TOK_IDENTIFIER";
+    case TOK_STRING:
+        return "TOK_STRING";
+    case TOK_INTEGER:
+        return "TOK_INTEGER";
+    case TOK_FLOAT:
+        return "TOK_FLOAT";
+    case TOK_TRUE:
+        return "TOK_TRUE";
+    case TOK_FALSE:
+        return "TOK_FALSE";
+    case TOK_CLASS:
+        return "TOK_CLASS";
+    case TOK_INHERITS:
+        return "TOK_INHERITS";
+    case TOK_ATTRIBUTES:
+        return "TOK_ATTRIBUTES";
+    case TOK_METHODS:
+        return "TOK_METHODS";
+    case TOK_FUNCTION:
+        return "TOK_FUNCTION";
+    case TOK_RETURN:
+        return "TOK_RETURN";
+    case TOK_NEW:
+        return "TOK_NEW";
+    case TOK_END:
+        return "TOK_END";
+    case TOK_IF:
+        return "TOK_IF";
+    case TOK_THEN:
+        return "TOK_THEN";
+    case TOK_ELSE:
+        return "TOK_ELSE";
+    case TOK_WHILE:
+        return "TOK_WHILE";
+    case TOK_FOR:
+        return "TOK_FOR";
+    case TOK_IN:
+        return "TOK_IN";
+    case TOK_PARALLEL:
+        return "TOK_PARALLEL";
+    case TOK_PRINT:
+        return "TOK_PRINT";
+    case TOK_ASSIGN:
+        return "TOK_ASSIGN";
+    case TOK_PLUS:
+        return "TOK_PLUS";
+    case TOK_MINUS:
+        return "TOK_MINUS";
+    case TOK_MULTIPLY:
+        return "TOK_MULTIPLY";
+    case TOK_DIVIDE:
+        return "TOK_DIVIDE";
+    case TOK_EQUAL:
+        return "TOK_EQUAL";
+    case TOK_GREATER_THAN:
+        return "TOK_GREATER_THAN";
+    case TOK_GT_OR_EQ:
+        return "TOK_GT_OR_EQ";
+    case TOK_LESS_THAN:
+        return "TOK_LESS_THAN";
+    case TOK_LT_OR_EQ:
+        return "TOK_LT_OR_EQ";
+    case TOK_DOT:
+        return "TOK_DOT";
+    case TOK_COLON:
+        return "TOK_COLON";
+    case TOK_COMMA:
+        return "TOK_COMMA";
+    case TOK_LPAREN:
+        return "TOK_LPAREN";
+    case TOK_RPAREN:
+        return "TOK_RPAREN";
+    case TOK_LBRACKET:
+        return "TOK_LBRACKET";
+    case TOK_RBRACKET:
+        return "TOK_RBRACKET";
+    }
+    return "TOK_EOF";
+}
+
+// A C++ string literal holding 'text' byte for byte
+std::string quote(const std::string &text) {
+    static const char DIGITS[] = "01234567";
+    std::string quoted         = "\"";
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+            quoted += (char) c;
+        } else if (c == '\n') {
+            quoted += "\\n";
+        } else if (c == '\t') {
+            quoted += "\\t";
+        } else if (c < 0x20 || c >= 0x7F) {
+            // Three octal digits always end the escape, unlike \x
+            quoted += '\\';
+            quoted += DIGITS[c >> 6];
+            quoted += DIGITS[(c >> 3) & 7];
+            quoted += DIGITS[c & 7];
+        } else {
+            quoted += (char) c;
+        }
+    }
+    return quoted + "\"";
+}
+
+// A double literal for a number token; the lexer only produces plain decimals
+std::string number(const std::string &lexeme) {
+    if (lexeme.find('.') == std::string::npos)
+        return lexeme + ".0";
+    if (lexeme.back() == '.')
+        return lexeme + "0";
+    return lexeme;
+}
+
+bool isParameter(const FunctionStmt *function, const std::string &name) {
+    for (const Token &param : function->params) {
+        if (param.lexeme == name)
+            return true;
+    }
+    return false;
+}
+
+bool isComparison(TokenType type) {
+    return type == TOK_EQUAL || type == TOK_LESS_THAN || type == TOK_LT_OR_EQ ||
+           type == TOK_GREATER_THAN || type == TOK_GT_OR_EQ;
+}
+
+// A math native that numeric code calls inline, and whether it checks its argument
+struct MathNative {
+    const char *name;
+    size_t arity;
+    const char *function;
+    bool checked; // Takes the call's '(' token first, to report a bad argument
+};
+
+const MathNative MATH_NATIVES[] = {
+    {"ABS", 1, "std::fabs", false},  {"FLOOR", 1, "std::floor", false},
+    {"CEIL", 1, "std::ceil", false}, {"SIN", 1, "std::sin", false},
+    {"COS", 1, "std::cos", false},   {"TAN", 1, "std::tan", false},
+    {"EXP", 1, "std::exp", false},   {"POW", 2, "std::pow", false},
+    {"SQRT", 1, "aot::sqrt", true},  {"MOD", 2, "aot::mod", true},
+    {"LOG", 1, "aot::log", true},
+};
+
+const MathNative *findMathNative(const std::string &name) {
+    for (const MathNative &native : MATH_NATIVES) {
+        if (name == native.name)
+            return &native;
+    }
+    return nullptr;
+}
+
+} // namespace
+
+// ============================================================
+// Program
+// ============================================================
+
+std::string CppEmitter::emit(const std::vector<StmtPtr> &program) {
+    NameScan everywhere;
+    everywhere.deep = true;
+    everywhere.statements(program);
+    assignedAnywhere = everywhere.assigned;
+
+    const NativeRegistry &natives = NativeRegistry::standard();
+
+    // Globals: what the top level defines, and the natives the program mentions
+    globals.prefix = "g_";
+    globals.names  = scopeNames(program);
+    for (const std::string &name : everywhere.used) {
+        if (natives.find(name))
+            globals.names.insert(name);
+    }
+    for (const std::string &name : everywhere.assigned) {
+        if (natives.find(name))
+            globals.names.insert(name);
+    }
+
+    NameScan topLevel;
+    topLevel.statements(program);
+    std::map<std::string, int> declarations;
+    for (FunctionStmt *declaration : everywhere.functions)
+        ++declarations[declaration->name.lexeme];
+    functions.reserve(topLevel.functions.size());
+    for (FunctionStmt *declaration : topLevel.functions) {
+        const std::string &name = declaration->name.lexeme;
+        Function function;
+        function.declaration = declaration;
+        function.name        = name;
+        for (const Function &other : functions) {
+            if (other.declaration->name.lexeme == name)
+                function.name = name + "_" + std::to_string(functions.size());
+        }
+        function.scope.prefix = "l_";
+        function.scope.names  = scopeNames(declaration->body);
+        for (const Token &param : declaration->params)
+            function.scope.names.insert(param.lexeme);
+        function.direct = declarations[name] == 1 && !assignedAnywhere.count(name) &&
+                          !natives.find(name);
+        functions.push_back(std::move(function));
+    }
+    for (Function &function : functions) {
+        if (function.direct)
+            directFunctions[function.declaration->name.lexeme] = &function;
+    }
+    findNumericFunctions();
+
+    // Function bodies, then the top level
+    std::ostringstream definitions;
+    for (Function &function : functions)
+        emitFunction(function, definitions);
+
+    std::ostringstream main;
+    out    = &main;
+    indent = "    ";
+    scopes = {&globals};
+    for (const std::string &name : globals.names) {
+        if (natives.find(name))
+            line("aot::assign(rt.global(\"" + name + "\"), g_" + name + ");");
+    }
+    statements(program);
+
+    std::ostringstream file;
+    file << "// Compiled from " << sourceName << " by scsa --emit-cpp. Build against the\n"
+         << "// interpreter's library (make libscsa) with:\n"
+         << "//   g++ -O2 -std=c++17 -pthread -I<scsa>/src this.cpp <scsa>/libscsa.a\n"
+         << "#include \"aot.hpp\"\n\n"
+         << "namespace {\n\n"
+         << "aot::Runtime rt;\n\n"
+         << "// Tokens, for error reports\n"
+         << tokenDeclarations.str() << "\n"
+         << "// Globals\n";
+    for (const std::string &name : globals.names)
+        file << "aot::Var g_" << name << ";\n";
+    file << "\n";
+
+    if (!functions.empty()) {
+        file << "// Functions\n";
+        for (const Function &function : functions) {
+            size_t arity = function.declaration->params.size();
+            file << "RuntimeValue f_" << function.name << "(aot::Args<" << arity << "> args);\n";
+            if (function.numeric) {
+                file << "double n_" << function.name << "(";
+                for (size_t i = 0; i < arity; ++i)
+                    file << (i ? ", double" : "double");
+                file << ");\n";
+            }
+        }
+        file << "\n" << definitions.str();
+    }
+
+    file << "void program() {\n" << main.str() << "}\n\n"
+         << "} // namespace\n\n"
+         << "int main() {\n"
+         << "    return rt.run(program);\n"
+         << "}\n";
+    return file.str();
+}
+
+void CppEmitter::emitFunction(Function &function, std::ostringstream &file) {
+    FunctionStmt *declaration = function.declaration;
+    const auto &params        = declaration->params;
+    std::string depth         = "    CallDepthGuard depth(rt.interpreter, " +
+                        token(declaration->name) + ");\n";
+
+    if (function.numeric) {
+        file << "double n_" << function.name << "(";
+        for (size_t i = 0; i < params.size(); ++i)
+            file << (i ? ", " : "") << "double l_" << params[i].lexeme;
+        file << ") {\n" << depth;
+        for (const std::string &name : function.scope.names) {
+            if (!isParameter(declaration, name))
+                file << "    double l_" << name << " = 0;\n";
+        }
+        file << function.numericCode << "}\n\n";
+    }
+
+    size_t arity = params.size();
+    file << "RuntimeValue f_" << function.name << "(aot::Args<" << arity << ">"
+         << (arity ? " args" : "") << ") {\n";
+    if (function.numeric && arity) {
+        std::string guard, call;
+        for (size_t i = 0; i < arity; ++i) {
+            std::string arg = "args[" + std::to_string(i) + "]";
+            guard += (i ? " && " : "") + arg + ".is<double>()";
+            call += (i ? ", " : "") + arg + ".as<double>()";
+        }
+        file << "    if (" << guard << ")\n"
+             << "        return {n_" << function.name << "(" << call << ")};\n";
+    } else if (function.numeric) {
+        file << "    return {n_" << function.name << "()};\n}\n\n";
+    }
+
+    if (!function.numeric || arity) {
+        std::ostringstream body;
+        out     = &body;
+        indent  = "    ";
+        scopes  = {&globals, &function.scope};
+        current = &function;
+        statements(declaration->body);
+        current = nullptr;
+
+        file << depth;
+        for (size_t i = 0; i < arity; ++i) {
+            file << "    aot::Var l_" << params[i].lexeme << "{std::move(args[" << i
+                 << "]), true};\n";
+        }
+        for (const std::string &name : function.scope.names) {
+            if (!isParameter(declaration, name))
+                file << "    aot::Var l_" << name << ";\n";
+        }
+        if (function.tailCalls)
+            file << "top:\n";
+        file << body.str();
+        const auto &last = declaration->body;
+        if (last.empty() || !dynamic_cast<ReturnStmt *>(last.back().get()))
+            file << "    return {};\n";
+        file << "}\n\n";
+    }
+
+    file << "RuntimeValue w_" << function.name << "(std::vector<RuntimeValue> &"
+         << (arity ? "args" : "") << ") {\n"
+         << "    return f_" << function.name << "({";
+    for (size_t i = 0; i < arity; ++i)
+        file << (i ? ", " : "") << "std::move(args[" << i << "])";
+    file << "});\n}\n\n";
+}
+
+// ============================================================
+// Helpers
+// ============================================================
+
+std::string CppEmitter::expression(Expr *expr) {
+    expr->accept(*this);
+    return code;
+}
+
+void CppEmitter::statements(const std::vector<StmtPtr> &body) {
+    for (const auto &stmt : body)
+        stmt->accept(*this);
+}
+
+void CppEmitter::line(const std::string &text) {
+    *out << indent << text << "\n";
+}
+
+/**
+ * The name of a constant holding 'token', declared on first use
+ */
+std::string CppEmitter::token(const Token &token) {
+    std::string key = std::to_string(token.type) + ":" + std::to_string(token.line) + ":" +
+                      std::to_string(token.column) + ":" + token.lexeme;
+    auto found      = tokens.find(key);
+    if (found != tokens.end())
+        return found->second;
+
+    std::string name = "t" + std::to_string(tokens.size());
+    tokenDeclarations << "const Token " << name << "{" << tokenTypeName(token.type) << ", "
+                      << quote(token.lexeme) << ", " << token.line << ", " << token.column
+                      << ", " << token.length << "};\n";
+    tokens.emplace(key, name);
+    return name;
+}
+
+/**
+ * The variables that may hold 'name' where code is being emitted, innermost first
+ * @return A comma separated list, empty if no enclosing scope defines the name
+ */
+std::string CppEmitter::variables(const std::string &name) const {
+    std::string list;
+    for (auto scope = scopes.rbegin(); scope != scopes.rend(); ++scope) {
+        if ((*scope)->names.count(name))
+            list += (list.empty() ? "" : ", ") + (*scope)->prefix + name;
+    }
+    return list;
+}
+
+/**
+ * Arguments as a braced list, which C++ evaluates left to right like the interpreter
+ */
+std::string CppEmitter::arguments(const std::vector<ExprPtr> &args) {
+    std::string list = "{";
+    for (size_t i = 0; i < args.size(); ++i)
+        list += (i ? ", " : "") + expression(args[i].get());
+    return list + "}";
+}
+
+/**
+ * The top-level function a call by name reaches without a lookup, if any
+ */
+CppEmitter::Function *CppEmitter::directTarget(const Token &name, size_t arity) const {
+    auto found = directFunctions.find(name.lexeme);
+    if (found == directFunctions.end() || found->second->declaration->params.size() != arity)
+        return nullptr;
+    // A local of the same name would hide it
+    for (size_t i = 1; i < scopes.size(); ++i) {
+        if (scopes[i]->names.count(name.lexeme))
+            return nullptr;
+    }
+    return found->second;
+}
+
+// Declare a new scope's variables, bar one that is declared with its first value
+void CppEmitter::declare(const Scope &scope, const std::string &except) {
+    for (const std::string &name : scope.names) {
+        if (name != except)
+            line("aot::Var " + scope.prefix + name + ";");
+    }
+}
+
+// ============================================================
+// Expressions
+// ============================================================
+
+void CppEmitter::visitLiteralExpr(LiteralExpr *expr) {
+    switch (expr->token.type) {
+    case TOK_FALSE:
+        code = "RuntimeValue{false}";
+        break;
+    case TOK_TRUE:
+        code = "RuntimeValue{true}";
+        break;
+    case TOK_STRING:
+        code = "RuntimeValue{std::string(" + quote(expr->token.lexeme) + ")}";
+        break;
+    case TOK_INTEGER:
+    case TOK_FLOAT:
+        code = "RuntimeValue{" + number(expr->token.lexeme) + "}";
+        break;
+    default:
+        code = "RuntimeValue{}";
+        break;
+    }
+}
+
+void CppEmitter::visitVariableExpr(VariableExpr *expr) {
+    std::string name = token(expr->name);
+    std::string vars = variables(expr->name.lexeme);
+    code = vars.empty() ? "aot::undefined(" + name + ")" : "aot::read(" + name + ", " + vars + ")";
+}
+
+void CppEmitter::visitAssignExpr(AssignExpr *expr) {
+    std::string value = expression(expr->value.get());
+    if (auto variable = dynamic_cast<VariableExpr *>(expr->target.get())) {
+        // The innermost scope always defines what its code assigns (see scopeNames)
+        code = "aot::assign(" + value + ", " + variables(variable->name.lexeme) + ")";
+    } else if (auto get = dynamic_cast<GetExpr *>(expr->target.get())) {
+        code = "rt.setProperty(" + token(get->name) + ", {" + value + ", " +
+               expression(get->object.get()) + "})";
+    } else if (auto access = dynamic_cast<ArrayAccessExpr *>(expr->target.get())) {
+        std::string array = expression(access->array.get());
+        std::string index = expression(access->index.get());
+        code              = "rt.setIndex(" + token(access->bracket) + ", {" + value + ", " +
+               array + ", " + index + "})";
+    } else {
+        throw std::runtime_error("Invalid assignment target.");
+    }
+}
+
+void CppEmitter::visitBinaryExpr(BinaryExpr *expr) {
+    std::string left  = expression(expr->left.get());
+    std::string right = expression(expr->right.get());
+    code              = std::string("aot::binary<") + tokenTypeName(expr->op.type) +
+           ">(rt.interpreter, " + token(expr->op) + ", {" + left + ", " + right + "})";
+}
+
+void CppEmitter::visitCallExpr(CallExpr *expr) {
+    if (auto get = dynamic_cast<GetExpr *>(expr->callee.get())) {
+        std::string object = expression(get->object.get());
+        std::string args   = arguments(expr->args);
+        code = "rt.invoke(" + token(get->name) + ", " + token(expr->paren) + ", {" + object +
+               ", " + args + "})";
+        return;
+    }
+    auto variable = dynamic_cast<VariableExpr *>(expr->callee.get());
+    if (Function *target = variable ? directTarget(variable->name, expr->args.size()) : nullptr) {
+        code = "(aot::require(" + token(variable->name) + ", g_" + variable->name.lexeme +
+               "), f_" + target->name + "(" + arguments(expr->args) + "))";
+        return;
+    }
+    std::string callee = expression(expr->callee.get());
+    std::string args   = arguments(expr->args);
+    code               = "rt.call(" + token(expr->paren) + ", {" + callee + ", " + args + "})";
+}
+
+void CppEmitter::visitGetExpr(GetExpr *expr) {
+    code = "rt.interpreter.getProperty(" + expression(expr->object.get()) + ", " +
+           token(expr->name) + ")";
+}
+
+void CppEmitter::visitArrayAccessExpr(ArrayAccessExpr *expr) {
+    std::string array = expression(expr->array.get());
+    code              = "rt.index(" + token(expr->bracket) + ", {" + array + ", " +
+               expression(expr->index.get()) + "})";
+}
+
+void CppEmitter::visitArrayLitExpr(ArrayLitExpr *expr) {
+    code = "rt.list(" + arguments(expr->elements) + ")";
+}
+
+void CppEmitter::visitSliceExpr(SliceExpr *expr) {
+    std::string array = expression(expr->array.get());
+    std::string start = expr->start ? expression(expr->start.get()) : "RuntimeValue{}";
+    std::string end   = expr->end ? expression(expr->end.get()) : "RuntimeValue{}";
+    std::string given = std::string(expr->start ? "true" : "false") + ", " +
+                        (expr->end ? "true" : "false");
+    code = "rt.slice(" + token(expr->bracket) + ", {" + array + ", " + start + ", " + end +
+           "}, " + given + ")";
+}
+
+void CppEmitter::visitNewExpr(NewExpr *expr) {
+    unsupported(expr->className.line, "classes");
+}
+
+// ============================================================
+// Statements
+// ============================================================
+
+void CppEmitter::visitExpressionStmt(ExpressionStmt *stmt) {
+    Expr *expr = stmt->expression.get();
+    bool used  = dynamic_cast<CallExpr *>(expr) || dynamic_cast<AssignExpr *>(expr);
+    line((used ? "" : "(void) ") + expression(expr) + ";");
+}
+
+void CppEmitter::visitPrintStmt(PrintStmt *stmt) {
+    line("rt.print(" + expression(stmt->expression.get()) + ");");
+}
+
+void CppEmitter::visitReturnStmt(ReturnStmt *stmt) {
+    if (!current) {
+        // As in the interpreter, the top level has nothing to return to
+        line("throw ReturnException(" +
+             (stmt->value ? expression(stmt->value.get()) : "RuntimeValue{}") + ");");
+        return;
+    }
+    if (!stmt->value) {
+        line("return {};");
+        return;
+    }
+
+    // 'RETURN f(...)' from f itself starts the body over with the new arguments
+    auto call     = dynamic_cast<CallExpr *>(stmt->value.get());
+    auto variable = call ? dynamic_cast<VariableExpr *>(call->callee.get()) : nullptr;
+    if (variable && directTarget(variable->name, call->args.size()) == current) {
+        current->tailCalls = true;
+        const auto &params = current->declaration->params;
+        line("{");
+        line("    aot::Args<" + std::to_string(params.size()) + "> next" +
+             arguments(call->args) + ";");
+        for (size_t i = 0; i < params.size(); ++i) {
+            line("    l_" + params[i].lexeme + " = {std::move(next[" + std::to_string(i) +
+                 "]), true};");
+        }
+        for (const std::string &name : current->scope.names) {
+            if (!isParameter(current->declaration, name))
+                line("    l_" + name + " = {};");
+        }
+        line("    goto top;");
+        line("}");
+        return;
+    }
+    line("return " + expression(stmt->value.get()) + ";");
+}
+
+void CppEmitter::visitBlockStmt(BlockStmt *stmt) {
+    Scope scope{"v" + std::to_string(++nextScope) + "_", scopeNames(stmt->statements)};
+    line("{");
+    indent += "    ";
+    scopes.push_back(&scope);
+    declare(scope);
+    statements(stmt->statements);
+    scopes.pop_back();
+    indent.resize(indent.size() - 4);
+    line("}");
+}
+
+void CppEmitter::visitIfStmt(IfStmt *stmt) {
+    line("if (rt.truthy(" + expression(stmt->condition.get()) + ")) {");
+    indent += "    ";
+    statements(stmt->thenBranch);
+    indent.resize(indent.size() - 4);
+    if (!stmt->elseBranch.empty()) {
+        line("} else {");
+        indent += "    ";
+        statements(stmt->elseBranch);
+        indent.resize(indent.size() - 4);
+    }
+    line("}");
+}
+
+void CppEmitter::visitWhileStmt(WhileStmt *stmt) {
+    line("while (rt.truthy(" + expression(stmt->condition.get()) + ")) {");
+    indent += "    ";
+    statements(stmt->body);
+    indent.resize(indent.size() - 4);
+    line("}");
+}
+
+void CppEmitter::visitFunctionStmt(FunctionStmt *stmt) {
+    // Only the top level declares functions; their closure is then always the global scope
+    if (current || scopes.size() != 1)
+        unsupported(stmt->name.line, "functions declared inside functions, loops or blocks");
+    for (const Function &function : functions) {
+        if (function.declaration == stmt) {
+            line("aot::assign(rt.function(" + quote(stmt->name.lexeme) + ", " +
+                 std::to_string(stmt->params.size()) + ", w_" + function.name + "), g_" +
+                 stmt->name.lexeme + ");");
+        }
+    }
+}
+
+void CppEmitter::visitClassStmt(ClassStmt *stmt) {
+    unsupported(stmt->name.line, "classes");
+}
+
+void CppEmitter::visitForInStmt(ForInStmt *stmt) {
+    std::string suffix = std::to_string(++nextScope);
+    Scope scope{"v" + suffix + "_", scopeNames(stmt->body)};
+    scope.names.insert(stmt->variable.lexeme);
+
+    if (stmt->parallel)
+        line("// PARALLEL FOR, run sequentially");
+    line("{");
+    indent += "    ";
+    line("ArrayPtr list" + suffix + " = rt.interpreter.iterationList(" + token(stmt->variable) +
+         ", " + expression(stmt->iterable.get()) + ");");
+    line("for (size_t i" + suffix + " = 0; i" + suffix + " < list" + suffix + "->size(); ++i" +
+         suffix + ") {");
+    indent += "    ";
+    line("aot::Var " + scope.prefix + stmt->variable.lexeme + "{list" + suffix + "->get(i" +
+         suffix + "), true};");
+    scopes.push_back(&scope);
+    declare(scope, stmt->variable.lexeme);
+    statements(stmt->body);
+    scopes.pop_back();
+    indent.resize(indent.size() - 4);
+    line("}");
+    indent.resize(indent.size() - 4);
+    line("}");
+}
+
+// ============================================================
+// Numeric Versions
+// ============================================================
+
+/**
+ * Decide which functions also get a version over doubles
+ * Candidates are direct functions with no local that is also a global. Each is translated
+ * assuming the others are numeric, and any that fail are dropped until the set stops changing.
+ */
+void CppEmitter::findNumericFunctions() {
+    for (Function &function : functions) {
+        if (!function.direct)
+            continue;
+        function.numeric = true;
+        for (const std::string &name : function.scope.names) {
+            if (!isParameter(function.declaration, name) && globals.names.count(name))
+                function.numeric = false;
+        }
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (Function &function : functions) {
+            if (!function.numeric)
+                continue;
+            Numeric numeric{&function, "", "    "};
+            std::set<std::string> assigned;
+            for (const Token &param : function.declaration->params)
+                assigned.insert(param.lexeme);
+            bool returns = false;
+            if (numericStatements(function.declaration->body, numeric, assigned, returns) &&
+                returns) {
+                function.numericCode = numeric.code;
+            } else {
+                function.numeric = false;
+                changed          = true;
+            }
+        }
+    }
+}
+
+/**
+ * Translate statements to double code
+ * @param assigned Locals certainly assigned so far; updated past the statements
+ * @param returns Set if every path through the statements returns
+ * @return false if the statements fall outside the numeric subset
+ */
+bool CppEmitter::numericStatements(const std::vector<StmtPtr> &body, Numeric &numeric,
+                                   std::set<std::string> &assigned, bool &returns) {
+    returns = false;
+    for (const auto &stmt : body) {
+        if (returns)
+            break; // Never reached
+        std::string value;
+
+        if (auto expression = dynamic_cast<ExpressionStmt *>(stmt.get())) {
+            auto assign = dynamic_cast<AssignExpr *>(expression->expression.get());
+            auto target = assign ? dynamic_cast<VariableExpr *>(assign->target.get()) : nullptr;
+            if (!target || !numericExpression(assign->value.get(), numeric, assigned, value))
+                return false;
+            numeric.code += numeric.indent + "l_" + target->name.lexeme + " = " + value + ";\n";
+            assigned.insert(target->name.lexeme);
+        } else if (auto ret = dynamic_cast<ReturnStmt *>(stmt.get())) {
+            if (!ret->value)
+                return false;
+            Function *function = numeric.function;
+            auto call          = dynamic_cast<CallExpr *>(ret->value.get());
+            auto variable = call ? dynamic_cast<VariableExpr *>(call->callee.get()) : nullptr;
+            const auto &params = function->declaration->params;
+            if (variable && variable->name.lexeme == function->declaration->name.lexeme &&
+                call->args.size() == params.size() &&
+                !function->scope.names.count(variable->name.lexeme)) {
+                // Self tail call: start over with the new arguments
+                std::vector<std::string> args;
+                for (const auto &arg : call->args) {
+                    if (!numericExpression(arg.get(), numeric, assigned, value))
+                        return false;
+                    args.push_back(value);
+                }
+                numeric.code += numeric.indent + "{\n";
+                for (size_t i = 0; i < args.size(); ++i) {
+                    numeric.code += numeric.indent + "    double next" + std::to_string(i) +
+                                    " = " + args[i] + ";\n";
+                }
+                for (size_t i = 0; i < args.size(); ++i) {
+                    numeric.code += numeric.indent + "    l_" + params[i].lexeme + " = next" +
+                                    std::to_string(i) + ";\n";
+                }
+                numeric.code += numeric.indent + "    goto top;\n" + numeric.indent + "}\n";
+                if (numeric.code.find("top:\n") == std::string::npos)
+                    numeric.code = "top:\n" + numeric.code;
+            } else {
+                if (!numericExpression(ret->value.get(), numeric, assigned, value))
+                    return false;
+                numeric.code += numeric.indent + "return " + value + ";\n";
+            }
+            returns = true;
+        } else if (auto branch = dynamic_cast<IfStmt *>(stmt.get())) {
+            if (!numericCondition(branch->condition.get(), numeric, assigned, value))
+                return false;
+            numeric.code += numeric.indent + "if " + value + " {\n";
+            numeric.indent += "    ";
+            std::set<std::string> thenAssigned = assigned, elseAssigned = assigned;
+            bool thenReturns = false, elseReturns = false;
+            if (!numericStatements(branch->thenBranch, numeric, thenAssigned, thenReturns))
+                return false;
+            if (!branch->elseBranch.empty()) {
+                numeric.code += numeric.indent.substr(4) + "} else {\n";
+                if (!numericStatements(branch->elseBranch, numeric, elseAssigned, elseReturns))
+                    return false;
+            }
+            numeric.indent.resize(numeric.indent.size() - 4);
+            numeric.code += numeric.indent + "}\n";
+
+            // A branch that returns does not reach the code after the IF
+            returns = thenReturns && elseReturns;
+            if (thenReturns && !elseReturns) {
+                assigned = elseAssigned;
+            } else if (elseReturns && !thenReturns) {
+                assigned = thenAssigned;
+            } else if (!returns) {
+                for (const std::string &name : thenAssigned) {
+                    if (elseAssigned.count(name))
+                        assigned.insert(name);
+                }
+            }
+        } else if (auto loop = dynamic_cast<WhileStmt *>(stmt.get())) {
+            if (!numericCondition(loop->condition.get(), numeric, assigned, value))
+                return false;
+            numeric.code += numeric.indent + "while " + value + " {\n";
+            numeric.indent += "    ";
+            // The body may run no times, so nothing it assigns is certain afterwards
+            std::set<std::string> bodyAssigned = assigned;
+            bool bodyReturns                   = false;
+            if (!numericStatements(loop->body, numeric, bodyAssigned, bodyReturns))
+                return false;
+            numeric.indent.resize(numeric.indent.size() - 4);
+            numeric.code += numeric.indent + "}\n";
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Translate an expression whose value is a number to a double expression
+ */
+bool CppEmitter::numericExpression(Expr *expr, Numeric &numeric,
+                                   const std::set<std::string> &assigned, std::string &result) {
+    const Scope &locals = numeric.function->scope;
+
+    if (auto literal = dynamic_cast<LiteralExpr *>(expr)) {
+        if (literal->token.type != TOK_INTEGER && literal->token.type != TOK_FLOAT)
+            return false;
+        result = number(literal->token.lexeme);
+        return true;
+    }
+    if (auto variable = dynamic_cast<VariableExpr *>(expr)) {
+        // Only locals, and only once assigned; anything else is a global or an error
+        if (!assigned.count(variable->name.lexeme))
+            return false;
+        result = "l_" + variable->name.lexeme;
+        return true;
+    }
+    if (auto binary = dynamic_cast<BinaryExpr *>(expr)) {
+        std::string left, right;
+        if (!numericExpression(binary->left.get(), numeric, assigned, left) ||
+            !numericExpression(binary->right.get(), numeric, assigned, right))
+            return false;
+        switch (binary->op.type) {
+        case TOK_PLUS:
+            result = "(" + left + " + " + right + ")";
+            return true;
+        case TOK_MINUS:
+            result = "(" + left + " - " + right + ")";
+            return true;
+        case TOK_MULTIPLY:
+            result = "(" + left + " * " + right + ")";
+            return true;
+        case TOK_DIVIDE:
+            result = "aot::divide(" + token(binary->op) + ", " + left + ", " + right + ")";
+            return true;
+        default:
+            return false;
+        }
+    }
+    if (auto call = dynamic_cast<CallExpr *>(expr)) {
+        auto variable = dynamic_cast<VariableExpr *>(call->callee.get());
+        if (!variable || locals.names.count(variable->name.lexeme))
+            return false;
+        const std::string &name = variable->name.lexeme;
+        std::vector<std::string> args;
+        for (const auto &arg : call->args) {
+            std::string value;
+            if (!numericExpression(arg.get(), numeric, assigned, value))
+                return false;
+            args.push_back(value);
+        }
+        std::string list;
+        for (size_t i = 0; i < args.size(); ++i)
+            list += (i ? ", " : "") + args[i];
+
+        auto direct = directFunctions.find(name);
+        if (direct != directFunctions.end()) {
+            Function *target = direct->second;
+            if (!target->numeric || target->declaration->params.size() != args.size())
+                return false;
+            result = "n_" + target->name + "(" + list + ")";
+            if (target != numeric.function) {
+                result = "(aot::require(" + token(variable->name) + ", g_" + name + "), " +
+                         result + ")";
+            }
+            return true;
+        }
+        // A math native, unless the program rebinds its name
+        const MathNative *native = findMathNative(name);
+        if (!native || native->arity != args.size() || assignedAnywhere.count(name))
+            return false;
+        for (const Function &function : functions) {
+            if (function.declaration->name.lexeme == name)
+                return false;
+        }
+        result = std::string(native->function) + "(" +
+                 (native->checked ? token(call->paren) + ", " : "") + list + ")";
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Translate an IF or WHILE condition to a parenthesized C++ condition
+ */
+bool CppEmitter::numericCondition(Expr *expr, Numeric &numeric,
+                                  const std::set<std::string> &assigned, std::string &result) {
+    if (auto literal = dynamic_cast<LiteralExpr *>(expr)) {
+        if (literal->token.type != TOK_TRUE && literal->token.type != TOK_FALSE)
+            return false;
+        result = literal->token.type == TOK_TRUE ? "(true)" : "(false)";
+        return true;
+    }
+    auto binary = dynamic_cast<BinaryExpr *>(expr);
+    if (!binary || !isComparison(binary->op.type))
+        return false;
+    std::string left, right;
+    if (!numericExpression(binary->left.get(), numeric, assigned, left) ||
+        !numericExpression(binary->right.get(), numeric, assigned, right))
+        return false;
+    std::string op = binary->op.type == TOK_EQUAL          ? "=="
+                     : binary->op.type == TOK_LESS_THAN    ? "<"
+                     : binary->op.type == TOK_LT_OR_EQ     ? "<="
+                     : binary->op.type == TOK_GREATER_THAN ? ">"
+                                                           : ">=";
+    result = "(" + left + " " + op + " " + right + ")";
+    return true;
+}
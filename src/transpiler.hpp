@@ -0,0 +1,123 @@
+#pragma once
+
+#include "ast.hpp"
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * CppEmitter - ahead-of-time compiler from the AST to C++17 (scsa --emit-cpp)
+ *
+ * The generated file includes aot.hpp and links against libscsa.a, whose Interpreter supplies
+ * natives, collection methods and error reports, so the compiled program behaves like the
+ * interpreted one. Variables are resolved to their scopes at compile time, calls to top-level
+ * functions bind directly, and functions that only compute with numbers (the JIT's subset, plus
+ * calls to such functions and the math natives) get a second version over plain doubles, which
+ * the generic version switches to when it is passed numbers.
+ *
+ * Compiled programs have no step, time or memory limits. Classes and functions declared anywhere
+ * but the top level are not supported and raise a std::runtime_error naming the line.
+ */
+class CppEmitter : public ExprVisitor, public StmtVisitor {
+public:
+    /**
+     * @param sourceName The script's path, quoted in the generated file's header
+     */
+    explicit CppEmitter(std::string sourceName) : sourceName(std::move(sourceName)) {
+    }
+
+    /**
+     * Translate a whole program
+     * @param program The parsed top-level statements
+     * @return A complete C++ source file with a main()
+     */
+    std::string emit(const std::vector<StmtPtr> &program);
+
+    // --- ExprVisitor Implementation ---
+    void visitLiteralExpr(LiteralExpr *expr) override;
+    void visitVariableExpr(VariableExpr *expr) override;
+    void visitAssignExpr(AssignExpr *expr) override;
+    void visitBinaryExpr(BinaryExpr *expr) override;
+    void visitCallExpr(CallExpr *expr) override;
+    void visitGetExpr(GetExpr *expr) override;
+    void visitArrayAccessExpr(ArrayAccessExpr *expr) override;
+    void visitArrayLitExpr(ArrayLitExpr *expr) override;
+    void visitSliceExpr(SliceExpr *expr) override;
+    void visitNewExpr(NewExpr *expr) override;
+
+    // --- StmtVisitor Implementation ---
+    void visitExpressionStmt(ExpressionStmt *stmt) override;
+    void visitPrintStmt(PrintStmt *stmt) override;
+    void visitReturnStmt(ReturnStmt *stmt) override;
+    void visitBlockStmt(BlockStmt *stmt) override;
+    void visitIfStmt(IfStmt *stmt) override;
+    void visitWhileStmt(WhileStmt *stmt) override;
+    void visitFunctionStmt(FunctionStmt *stmt) override;
+    void visitClassStmt(ClassStmt *stmt) override;
+    void visitForInStmt(ForInStmt *stmt) override;
+
+private:
+    // Variables one pseudocode scope defines, and the prefix of their C++ names
+    struct Scope {
+        std::string prefix;
+        std::set<std::string> names;
+    };
+
+    // A top-level function and what is known about it
+    struct Function {
+        FunctionStmt *declaration;
+        std::string name;        // C++ name, unique among the program's functions
+        Scope scope;             // Parameters and locals
+        bool direct    = false;  // Its name is bound to nothing else, so calls skip the lookup
+        bool numeric   = false;  // Also compiled over doubles, as numericCode
+        bool tailCalls = false;  // RETURNs a call to itself, which loops instead
+        std::string numericCode; // Body of the double version
+    };
+
+    // State while translating one function body to double code
+    struct Numeric {
+        Function *function;
+        std::string code;
+        std::string indent;
+    };
+
+    std::string sourceName;
+    std::vector<Function> functions;
+    std::map<std::string, Function *> directFunctions; // By pseudocode name
+    std::set<std::string> assignedAnywhere;             // Names some assignment writes
+    Scope globals;
+
+    // Scopes enclosing the code being emitted, outermost first
+    std::vector<Scope *> scopes;
+    Function *current = nullptr; // Function being emitted, if any
+    int nextScope     = 0;
+
+    std::ostringstream *out = nullptr; // Receives the statements being emitted
+    std::string indent;
+    std::string code; // The C++ expression for the last expression visited
+
+    std::map<std::string, std::string> tokens; // Name of the constant for each token used
+    std::ostringstream tokenDeclarations;
+
+    std::string expression(Expr *expr);
+    void statements(const std::vector<StmtPtr> &body);
+    void line(const std::string &text);
+
+    std::string token(const Token &token);
+    std::string variables(const std::string &name) const;
+    std::string arguments(const std::vector<ExprPtr> &args);
+    Function *directTarget(const Token &name, size_t arity) const;
+    void declare(const Scope &scope, const std::string &except = "");
+    void emitFunction(Function &function, std::ostringstream &file);
+
+    // --- Numeric versions ---
+    void findNumericFunctions();
+    bool numericStatements(const std::vector<StmtPtr> &body, Numeric &numeric,
+                           std::set<std::string> &assigned, bool &returns);
+    bool numericExpression(Expr *expr, Numeric &numeric, const std::set<std::string> &assigned,
+                           std::string &result);
+    bool numericCondition(Expr *expr, Numeric &numeric, const std::set<std::string> &assigned,
+                          std::string &result);
+};
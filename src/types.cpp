@@ -0,0 +1,363 @@
+#include "types.hpp"
+
+#include <map>
+#include <set>
+#include <string>
+
+namespace {
+
+// --- Facts ---
+
+/**
+ * The types of variables at one point of the body
+ * Names that are not listed are Unknown; an unreachable state follows a RETURN.
+ */
+struct State {
+    bool reachable = true;
+    std::map<std::string, StaticType> vars;
+
+    StaticType get(const std::string &name) const {
+        auto found = vars.find(name);
+        return found == vars.end() ? StaticType::Unknown : found->second;
+    }
+
+    void set(const std::string &name, StaticType type) {
+        if (type == StaticType::Unknown)
+            vars.erase(name);
+        else
+            vars[name] = type;
+    }
+
+    bool operator==(const State &other) const {
+        return reachable == other.reachable && vars == other.vars;
+    }
+};
+
+/**
+ * The facts that hold after either of two paths
+ */
+State merge(const State &a, const State &b) {
+    if (!a.reachable)
+        return b;
+    if (!b.reachable)
+        return a;
+    State result;
+    for (const auto &[name, type] : a.vars) {
+        if (b.get(name) == type)
+            result.vars.emplace(name, type);
+    }
+    return result;
+}
+
+/**
+ * Whether a function or class is declared where it would capture a scope holding locals
+ * Every scope of a function body can reach its parameters; at the top level only FOR bodies
+ * and blocks open scopes below the globals.
+ */
+bool declaresClosures(const std::vector<StmtPtr> &statements, bool local) {
+    for (const auto &stmt : statements) {
+        if (dynamic_cast<FunctionStmt *>(stmt.get()) || dynamic_cast<ClassStmt *>(stmt.get())) {
+            if (local)
+                return true;
+        } else if (auto ifStmt = dynamic_cast<IfStmt *>(stmt.get())) {
+            if (declaresClosures(ifStmt->thenBranch, local) ||
+                declaresClosures(ifStmt->elseBranch, local))
+                return true;
+        } else if (auto whileStmt = dynamic_cast<WhileStmt *>(stmt.get())) {
+            if (declaresClosures(whileStmt->body, local))
+                return true;
+        } else if (auto forStmt = dynamic_cast<ForInStmt *>(stmt.get())) {
+            if (declaresClosures(forStmt->body, true))
+                return true;
+        } else if (auto block = dynamic_cast<BlockStmt *>(stmt.get())) {
+            if (declaresClosures(block->statements, true))
+                return true;
+        }
+    }
+    return false;
+}
+
+// An operand whose evaluation cannot reassign a variable read before it
+bool isSimple(Expr *expr) {
+    return dynamic_cast<LiteralExpr *>(expr) || dynamic_cast<VariableExpr *>(expr);
+}
+
+// --- Inference ---
+
+/**
+ * Walks a body in evaluation order, carrying the variable types along each path
+ */
+class TypeInference : public ExprVisitor, public StmtVisitor {
+public:
+    SiteTypes sites;
+
+    TypeInference(const std::vector<Token> *params, bool closures) : closures(closures) {
+        if (params) {
+            for (const auto &param : *params) {
+                locals.insert(param.lexeme);
+            }
+        }
+    }
+
+    void analyze(const std::vector<StmtPtr> &statements) {
+        for (const auto &stmt : statements) {
+            if (!state.reachable)
+                return;
+            if (stmt)
+                stmt->accept(*this);
+        }
+    }
+
+    // --- ExprVisitor Implementation ---
+    void visitLiteralExpr(LiteralExpr *expr) override {
+        switch (expr->token.type) {
+        case TOK_INTEGER:
+        case TOK_FLOAT:
+            result = StaticType::Number;
+            break;
+        case TOK_STRING:
+            result = StaticType::String;
+            break;
+        case TOK_TRUE:
+        case TOK_FALSE:
+            result = StaticType::Boolean;
+            break;
+        default:
+            result = StaticType::Unknown;
+            break;
+        }
+    }
+
+    void visitVariableExpr(VariableExpr *expr) override {
+        result = state.get(expr->name.lexeme);
+    }
+
+    void visitAssignExpr(AssignExpr *expr) override {
+        StaticType value = infer(expr->value.get());
+        if (auto varExpr = dynamic_cast<VariableExpr *>(expr->target.get())) {
+            state.set(varExpr->name.lexeme, value);
+        } else if (auto getExpr = dynamic_cast<GetExpr *>(expr->target.get())) {
+            infer(getExpr->object.get());
+        } else if (auto arrExpr = dynamic_cast<ArrayAccessExpr *>(expr->target.get())) {
+            infer(arrExpr->array.get());
+            infer(arrExpr->index.get());
+        }
+        result = value;
+    }
+
+    void visitBinaryExpr(BinaryExpr *expr) override {
+        StaticType left  = infer(expr->left.get());
+        StaticType right = infer(expr->right.get());
+        sites[expr]      = {left, right};
+
+        switch (expr->op.type) {
+        case TOK_MINUS:
+        case TOK_MULTIPLY:
+        case TOK_DIVIDE:
+            refine(expr, StaticType::Number);
+            result = StaticType::Number;
+            break;
+        case TOK_LESS_THAN:
+        case TOK_LT_OR_EQ:
+        case TOK_GREATER_THAN:
+        case TOK_GT_OR_EQ:
+            refine(expr, StaticType::Number);
+            result = StaticType::Boolean;
+            break;
+        case TOK_PLUS:
+            // Only two numbers or two strings add, so one operand decides the other's type
+            if (left == StaticType::Number || right == StaticType::Number) {
+                refine(expr, StaticType::Number);
+                result = StaticType::Number;
+            } else if (left == StaticType::String || right == StaticType::String) {
+                refine(expr, StaticType::String);
+                result = StaticType::String;
+            } else {
+                result = StaticType::Unknown;
+            }
+            break;
+        case TOK_EQUAL:
+        case TOK_IN:
+            result = StaticType::Boolean;
+            break;
+        default:
+            result = StaticType::Unknown;
+            break;
+        }
+    }
+
+    void visitCallExpr(CallExpr *expr) override {
+        if (auto getExpr = dynamic_cast<GetExpr *>(expr->callee.get()))
+            infer(getExpr->object.get());
+        else
+            infer(expr->callee.get());
+        for (const auto &arg : expr->args) {
+            infer(arg.get());
+        }
+        forgetOnCall();
+        result = StaticType::Unknown;
+    }
+
+    void visitGetExpr(GetExpr *expr) override {
+        infer(expr->object.get());
+        result = StaticType::Unknown;
+    }
+
+    void visitArrayAccessExpr(ArrayAccessExpr *expr) override {
+        StaticType array = infer(expr->array.get());
+        StaticType index = infer(expr->index.get());
+        sites[expr]      = {array, index};
+        result           = StaticType::Unknown;
+    }
+
+    void visitArrayLitExpr(ArrayLitExpr *expr) override {
+        for (const auto &el : expr->elements) {
+            infer(el.get());
+        }
+        result = StaticType::List;
+    }
+
+    void visitSliceExpr(SliceExpr *expr) override {
+        infer(expr->array.get());
+        if (expr->start)
+            infer(expr->start.get());
+        if (expr->end)
+            infer(expr->end.get());
+        result = StaticType::List;
+    }
+
+    void visitNewExpr(NewExpr *expr) override {
+        for (const auto &arg : expr->args) {
+            infer(arg.get());
+        }
+        forgetOnCall();
+        result = StaticType::Unknown;
+    }
+
+    // --- StmtVisitor Implementation ---
+    void visitExpressionStmt(ExpressionStmt *stmt) override {
+        infer(stmt->expression.get());
+    }
+
+    void visitPrintStmt(PrintStmt *stmt) override {
+        infer(stmt->expression.get());
+    }
+
+    void visitReturnStmt(ReturnStmt *stmt) override {
+        if (stmt->value)
+            infer(stmt->value.get());
+        state.reachable = false;
+    }
+
+    void visitBlockStmt(BlockStmt *stmt) override {
+        // Names first assigned inside the block are defined in its scope and vanish with it
+        State outer = state;
+        analyze(stmt->statements);
+        for (auto it = state.vars.begin(); it != state.vars.end();) {
+            if (outer.vars.count(it->first))
+                ++it;
+            else
+                it = state.vars.erase(it);
+        }
+    }
+
+    void visitIfStmt(IfStmt *stmt) override {
+        infer(stmt->condition.get());
+        State before = state;
+        analyze(stmt->thenBranch);
+        State taken = state;
+        state       = before;
+        analyze(stmt->elseBranch);
+        state = merge(taken, state);
+    }
+
+    void visitWhileStmt(WhileStmt *stmt) override {
+        // Widen the loop head until another pass through the body adds nothing to forget
+        while (true) {
+            State head = state;
+            infer(stmt->condition.get());
+            State exit = state;
+            analyze(stmt->body);
+            state = merge(head, state);
+            if (state == head) {
+                state = exit;
+                return;
+            }
+        }
+    }
+
+    void visitFunctionStmt(FunctionStmt *stmt) override {
+        state.set(stmt->name.lexeme, StaticType::Unknown);
+    }
+
+    void visitClassStmt(ClassStmt *stmt) override {
+        state.set(stmt->name.lexeme, StaticType::Unknown);
+    }
+
+    void visitForInStmt(ForInStmt *stmt) override {
+        infer(stmt->iterable.get());
+        const std::string &variable = stmt->variable.lexeme;
+        if (stmt->parallel) {
+            // The iterations run elsewhere, and may call anything
+            state.vars.clear();
+            return;
+        }
+
+        // The loop variable shadows any outer one, in a scope of its own per iteration; merging
+        // with the head drops whatever else the body defined in that scope
+        locals.insert(variable);
+        while (true) {
+            State head = state;
+            state.set(variable, StaticType::Unknown);
+            analyze(stmt->body);
+            state.set(variable, StaticType::Unknown);
+            state = merge(head, state);
+            if (state == head)
+                break;
+        }
+        locals.erase(locals.find(variable));
+        state.set(variable, StaticType::Unknown);
+    }
+
+private:
+    State state;
+    StaticType result = StaticType::Unknown; // Type of the last expression visited
+    std::multiset<std::string> locals;       // Names that only this body can assign
+    bool closures;                           // Some declaration captures the locals
+
+    StaticType infer(Expr *expr) {
+        expr->accept(*this);
+        return result;
+    }
+
+    /**
+     * Record what a binary operator that succeeded proves about its variable operands
+     * The left operand was read before the right one ran, so it only keeps its value when the
+     * right one is simple.
+     */
+    void refine(BinaryExpr *expr, StaticType type) {
+        if (auto right = dynamic_cast<VariableExpr *>(expr->right.get()))
+            state.set(right->name.lexeme, type);
+        auto left = dynamic_cast<VariableExpr *>(expr->left.get());
+        if (left && isSimple(expr->right.get()))
+            state.set(left->name.lexeme, type);
+    }
+
+    // A call may reassign any variable it can see
+    void forgetOnCall() {
+        for (auto it = state.vars.begin(); it != state.vars.end();) {
+            if (!closures && locals.count(it->first))
+                ++it;
+            else
+                it = state.vars.erase(it);
+        }
+    }
+};
+
+} // namespace
+
+SiteTypes inferTypes(const std::vector<StmtPtr> &body, const std::vector<Token> *params) {
+    TypeInference inference(params, declaresClosures(body, params != nullptr));
+    inference.analyze(body);
+    return std::move(inference.sites);
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "ast.hpp"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * What the type inference pass knows about a value
+ * Unknown is the top of the lattice: the value may be of any type.
+ */
+enum class StaticType : uint8_t { Unknown, Number, String, Boolean, List };
+
+/**
+ * Types proven for the two operands of an operator site
+ * Left and right for a BinaryExpr; the list and the index for an ArrayAccessExpr.
+ */
+struct OperandTypes {
+    StaticType left  = StaticType::Unknown;
+    StaticType right = StaticType::Unknown;
+};
+
+using SiteTypes = std::unordered_map<const Expr *, OperandTypes>;
+
+/**
+ * Flow-sensitive type inference over one script or function body
+ *
+ * Tracks the type of every variable the body assigns along each path, merging at IF joins and
+ * iterating loops to a fixed point. Operators that only accept numbers refine their variable
+ * operands once they have succeeded. Any call may run code that reassigns variables, so a call
+ * forgets everything except the function's own parameters and the loop variables it is
+ * iterating - and even those when the body declares a function that could capture them.
+ * Nested function bodies are analyzed separately, when they are compiled.
+ *
+ * @param body The statements to analyze
+ * @param params The function's parameters, or null for top-level code
+ * @return The operand types of every reachable BinaryExpr and ArrayAccessExpr site; sites that
+ *         are not listed have unknown operands
+ */
+SiteTypes inferTypes(const std::vector<StmtPtr> &body, const std::vector<Token> *params);
@@ -0,0 +1,563 @@
+#include "vm.hpp"
+#include "interpreter.hpp"
+
+#include <cmath>
+#include <functional>
+
+namespace {
+
+// --- Specialized Operators ---
+
+// Guard of the numeric opcodes: are the top two operands numbers?
+bool numbers(const std::vector<RuntimeValue> &stack) {
+    return stack.back().is<double>() && stack[stack.size() - 2].is<double>();
+}
+
+// An operand the compiler proved to be a number, read without checking
+double &number(RuntimeValue &value) {
+    return *std::get_if<double>(&value.value);
+}
+
+/**
+ * Replace the top two operands, both numbers, with op(left, right)
+ */
+template <typename Op> void numeric(std::vector<RuntimeValue> &stack, Op op) {
+    double right = number(stack.back());
+    stack.pop_back();
+    RuntimeValue &left = stack.back();
+    left.value         = op(number(left), right);
+}
+
+// Guard of OP_ADD_STRINGS: are the top two operands strings?
+bool strings(const std::vector<RuntimeValue> &stack) {
+    return stack.back().is<std::string>() && stack[stack.size() - 2].is<std::string>();
+}
+
+// Rewrite a site to its specialized form, remembering the generic one
+void quicken(Instruction &site, OpCode specialized) {
+    site.b  = site.op;
+    site.op = specialized;
+    site.c  = SITE_QUICKENED;
+}
+
+// Put a quickened site back to its generic form, never to be quickened again. Sites the
+// compiler specialized keep their form: they have no generic opcode in b to go back to.
+void deoptimize(Instruction &site) {
+    if (site.c != SITE_QUICKENED)
+        return;
+    site.op = (OpCode) site.b;
+    site.c  = SITE_DEOPTIMIZED;
+}
+
+} // namespace
+
+// --- Entry Points ---
+
+void VM::run(const std::vector<StmtPtr> &statements) {
+    std::unique_ptr<Chunk> script = compiler.compileScript(statements);
+    execute({script.get(), 0, interpreter.environment, 0, nullptr, nullptr, {}});
+}
+
+RuntimeValue VM::call(LoxFunction &function, std::vector<RuntimeValue> &arguments) {
+    // Non-owning handle: the caller keeps the function alive for the whole call
+    std::shared_ptr<Callable> self(std::shared_ptr<Callable>(), &function);
+
+    std::unique_ptr<MemoKey> memoKey;
+    if (const RuntimeValue *cached =
+            memoLookup(self, arguments.data(), arguments.size(), memoKey))
+        return *cached;
+
+    CallDepthGuard depth(interpreter, function.declaration->name);
+    interpreter.tick(function.declaration->name);
+    Frame entry   = enterFunction(self, arguments.data(), arguments.size(), 0);
+    entry.memoKey = std::move(memoKey);
+    return execute(std::move(entry));
+}
+
+// --- Frames ---
+
+Chunk &VM::chunkFor(FunctionStmt *function) {
+    auto &chunk = functionChunks[function];
+    if (!chunk)
+        chunk = compiler.compileFunction(function);
+    return *chunk;
+}
+
+VM::Frame VM::enterFunction(const std::shared_ptr<Callable> &function, RuntimeValue *args,
+                            size_t argc, size_t stackBase) {
+    auto lox = static_cast<LoxFunction *>(function.get());
+    auto env = std::make_shared<Environment>(lox->closure);
+    for (size_t i = 0; i < argc; ++i) {
+        env->define(lox->declaration->params[i], std::move(args[i]));
+    }
+    return {&chunkFor(lox->declaration), 0, env, stackBase, function, nullptr, {}};
+}
+
+HeapCharge VM::holdTemporaries(const std::vector<RuntimeValue> &stack, size_t from, size_t to,
+                               const Token &where) const {
+    HeapCharge held;
+    if (!held.active())
+        return held;
+    size_t bytes = 0;
+    for (size_t i = from; i < to; ++i) {
+        if (stack[i].is<std::string>())
+            bytes += stack[i].as<std::string>().size();
+    }
+    try {
+        held.resize(bytes);
+    } catch (const NativeError &error) {
+        throw RuntimeError(where, error.what());
+    }
+    return held;
+}
+
+const RuntimeValue *VM::memoLookup(const std::shared_ptr<Callable> &function,
+                                   const RuntimeValue *args, size_t argc,
+                                   std::unique_ptr<MemoKey> &key) {
+    if (!interpreter.memo)
+        return nullptr;
+    auto lox       = static_cast<LoxFunction *>(function.get());
+    auto candidate = std::make_unique<MemoKey>();
+    if (!interpreter.memo->prepare(*lox, args, argc, *candidate))
+        return nullptr;
+    if (const RuntimeValue *cached = interpreter.memo->find(*candidate))
+        return cached;
+    key = std::move(candidate);
+    return nullptr;
+}
+
+void VM::callValue(std::vector<Frame> &frames, std::vector<RuntimeValue> &stack, size_t base,
+                   size_t argc, const Token &paren) {
+    if (!stack[base].is<std::shared_ptr<Callable>>()) {
+        throw RuntimeError(paren, "Can only call functions and classes.");
+    }
+    auto function = stack[base].as<std::shared_ptr<Callable>>();
+    interpreter.checkArgumentCount(paren, *function, argc);
+
+    if (auto lox = dynamic_cast<LoxFunction *>(function.get())) {
+        RuntimeValue native;
+        if (lox->callNative(interpreter, &stack[base + 1], native)) {
+            stack.resize(base);
+            stack.push_back(std::move(native));
+            return;
+        }
+        std::unique_ptr<MemoKey> memoKey;
+        if (const RuntimeValue *cached = memoLookup(function, &stack[base + 1], argc, memoKey)) {
+            RuntimeValue result = *cached;
+            stack.resize(base);
+            stack.push_back(std::move(result));
+            return;
+        }
+        const Token &name = lox->declaration->name;
+        interpreter.tick(name);
+        if (interpreter.callDepth >= interpreter.maxCallDepth) {
+            throw RuntimeError(name, "Maximum recursion depth of " +
+                                         std::to_string(interpreter.maxCallDepth) +
+                                         " exceeded in '" + name.lexeme + "'.");
+        }
+        HeapCharge temporaries = holdTemporaries(stack, frames.back().stackBase, base, paren);
+        interpreter.callDepth++;
+        frames.push_back(enterFunction(function, &stack[base + 1], argc, base));
+        frames.back().memoKey     = std::move(memoKey);
+        frames.back().temporaries = std::move(temporaries);
+        stack.resize(base);
+        return;
+    }
+
+    RuntimeValue result;
+    try {
+        if (auto native = dynamic_cast<NativeFunction *>(function.get())) {
+            // Natives read their arguments in place on the operand stack
+            result = native->invoke(interpreter, ArgSpan(&stack[base + 1], argc));
+        } else {
+            std::vector<RuntimeValue> args(std::make_move_iterator(stack.begin() + base + 1),
+                                           std::make_move_iterator(stack.end()));
+            result = function->call(interpreter, std::move(args));
+        }
+    } catch (const NativeError &error) {
+        throw RuntimeError(paren, error.what());
+    }
+    stack.resize(base);
+    stack.push_back(std::move(result));
+}
+
+// --- Dispatch Loop ---
+
+RuntimeValue VM::execute(Frame entry) {
+    std::vector<Frame> frames;
+    std::vector<RuntimeValue> stack;
+    frames.push_back(std::move(entry));
+
+    // Frames pushed by this loop are counted in callDepth until they return
+    int baseDepth = interpreter.callDepth;
+
+    auto pop = [&stack]() {
+        RuntimeValue value = std::move(stack.back());
+        stack.pop_back();
+        return value;
+    };
+
+    // The full operator semantics, for OP_BINARY and specialized opcodes whose guard fails
+    auto binary = [&](const Token &op) {
+        RuntimeValue right = pop();
+        RuntimeValue left  = pop();
+        stack.push_back(interpreter.binaryOp(op, left, right));
+    };
+
+    // '+' on two strings, extending the left one in place
+    auto concat = [&](const Token &op) {
+        auto &left  = *std::get_if<std::string>(&stack[stack.size() - 2].value);
+        auto &right = *std::get_if<std::string>(&stack.back().value);
+        if (const auto &heap = HeapAccount::current())
+            heap->require(left.size() + right.size(), op);
+        left += right;
+        stack.pop_back();
+    };
+
+    try {
+        Frame *frame = &frames.back();
+        while (true) {
+            Instruction &in = frame->chunk->code[frame->ip++];
+            switch (in.op) {
+            case OP_CONSTANT:
+                stack.push_back(frame->chunk->constants[in.a]);
+                break;
+            case OP_NIL:
+                stack.push_back({std::monostate{}});
+                break;
+            case OP_POP:
+                stack.pop_back();
+                break;
+            case OP_GET_VAR:
+                stack.push_back(frame->env->get(*frame->chunk->tokens[in.a]));
+                break;
+            case OP_SET_VAR: {
+                // Assigning to an unknown name defines it in the current scope
+                const Token &name = *frame->chunk->tokens[in.a];
+                if (!frame->env->assignExisting(name, stack.back())) {
+                    frame->env->define(name, stack.back());
+                }
+                break;
+            }
+            case OP_GET_PROP: {
+                RuntimeValue object = pop();
+                stack.push_back(interpreter.getProperty(object, *frame->chunk->tokens[in.a]));
+                break;
+            }
+            case OP_SET_PROP: {
+                RuntimeValue object = pop();
+                interpreter.setProperty(object, *frame->chunk->tokens[in.a], stack.back());
+                break;
+            }
+            case OP_INDEX_LIST: {
+                // Read an element in place; a bad index takes the generic path for its error
+                const RuntimeValue &index = stack.back();
+                const ArrayPtr *list      = std::get_if<ArrayPtr>(&stack[stack.size() - 2].value);
+                if (!list) {
+                    // Either way the generic path below handles whatever was indexed
+                    deoptimize(in);
+                } else if (index.is<double>()) {
+                    // NaN fails every comparison, so it takes the generic path too
+                    double position = index.as<double>();
+                    if (position >= 0 && position < (double) (*list)->size() &&
+                        std::trunc(position) == position) {
+                        RuntimeValue element = (*list)->get((size_t) position);
+                        stack.pop_back();
+                        stack.back() = std::move(element);
+                        break;
+                    }
+                }
+                [[fallthrough]];
+            }
+            case OP_GET_INDEX: {
+                if (in.op == OP_GET_INDEX && in.c == SITE_UNSEEN &&
+                    stack[stack.size() - 2].is<ArrayPtr>())
+                    quicken(in, OP_INDEX_LIST);
+                RuntimeValue index = pop();
+                RuntimeValue array = pop();
+                stack.push_back(interpreter.getIndex(*frame->chunk->tokens[in.a], array, index));
+                break;
+            }
+            case OP_SET_INDEX: {
+                RuntimeValue index = pop();
+                RuntimeValue array = pop();
+                interpreter.setIndex(*frame->chunk->tokens[in.a], array, index, stack.back());
+                break;
+            }
+            case OP_SLICE: {
+                RuntimeValue end, start;
+                if (in.b & 2)
+                    end = pop();
+                if (in.b & 1)
+                    start = pop();
+                RuntimeValue array = pop();
+                stack.push_back(interpreter.sliceArray(*frame->chunk->tokens[in.a], array,
+                                                       (in.b & 1) ? &start : nullptr,
+                                                       (in.b & 2) ? &end : nullptr));
+                break;
+            }
+            case OP_ARRAY: {
+                auto vec     = std::make_shared<Array>();
+                size_t first = stack.size() - in.a;
+                vec->reserve(in.a);
+                for (size_t i = first; i < stack.size(); ++i) {
+                    vec->push(std::move(stack[i]));
+                }
+                stack.resize(first);
+                stack.push_back({vec});
+                break;
+            }
+            case OP_BINARY:
+                if (in.c == SITE_UNSEEN && frame->chunk->tokens[in.a]->type == TOK_PLUS &&
+                    strings(stack)) {
+                    quicken(in, OP_ADD_STRINGS);
+                    concat(*frame->chunk->tokens[in.a]);
+                    break;
+                }
+                binary(*frame->chunk->tokens[in.a]);
+                break;
+            // Each guarded numeric opcode deoptimizes to OP_BINARY when an operand is not a
+            // number, and otherwise runs the unchecked form that follows it
+            case OP_ADD:
+                if (!numbers(stack)) {
+                    if (in.c == SITE_UNSEEN && strings(stack)) {
+                        quicken(in, OP_ADD_STRINGS);
+                        concat(*frame->chunk->tokens[in.a]);
+                        break;
+                    }
+                    binary(*frame->chunk->tokens[in.a]);
+                    break;
+                }
+                [[fallthrough]];
+            case OP_ADD_NUM:
+                numeric(stack, std::plus<double>());
+                break;
+            case OP_SUBTRACT:
+                if (!numbers(stack)) {
+                    binary(*frame->chunk->tokens[in.a]);
+                    break;
+                }
+                [[fallthrough]];
+            case OP_SUBTRACT_NUM:
+                numeric(stack, std::minus<double>());
+                break;
+            case OP_MULTIPLY:
+                if (!numbers(stack)) {
+                    binary(*frame->chunk->tokens[in.a]);
+                    break;
+                }
+                [[fallthrough]];
+            case OP_MULTIPLY_NUM:
+                numeric(stack, std::multiplies<double>());
+                break;
+            case OP_DIVIDE:
+                if (!numbers(stack)) {
+                    binary(*frame->chunk->tokens[in.a]);
+                    break;
+                }
+                [[fallthrough]];
+            case OP_DIVIDE_NUM:
+                if (number(stack.back()) == 0)
+                    throw RuntimeError(*frame->chunk->tokens[in.a], "Division by zero.");
+                numeric(stack, std::divides<double>());
+                break;
+            case OP_LESS:
+                if (!numbers(stack)) {
+                    binary(*frame->chunk->tokens[in.a]);
+                    break;
+                }
+                [[fallthrough]];
+            case OP_LESS_NUM:
+                numeric(stack, std::less<double>());
+                break;
+            case OP_LT_OR_EQ:
+                if (!numbers(stack)) {
+                    binary(*frame->chunk->tokens[in.a]);
+                    break;
+                }
+                [[fallthrough]];
+            case OP_LT_OR_EQ_NUM:
+                numeric(stack, std::less_equal<double>());
+                break;
+            case OP_GREATER:
+                if (!numbers(stack)) {
+                    binary(*frame->chunk->tokens[in.a]);
+                    break;
+                }
+                [[fallthrough]];
+            case OP_GREATER_NUM:
+                numeric(stack, std::greater<double>());
+                break;
+            case OP_GT_OR_EQ:
+                if (!numbers(stack)) {
+                    binary(*frame->chunk->tokens[in.a]);
+                    break;
+                }
+                [[fallthrough]];
+            case OP_GT_OR_EQ_NUM:
+                numeric(stack, std::greater_equal<double>());
+                break;
+            case OP_ADD_STRINGS:
+                if (!strings(stack)) {
+                    deoptimize(in);
+                    binary(*frame->chunk->tokens[in.a]);
+                    break;
+                }
+                [[fallthrough]];
+            case OP_CONCAT:
+                concat(*frame->chunk->tokens[in.a]);
+                break;
+            case OP_CALL: {
+                size_t base = stack.size() - in.a - 1;
+                callValue(frames, stack, base, in.a, *frame->chunk->tokens[in.b]);
+                frame = &frames.back();
+                break;
+            }
+            case OP_TAIL_CALL: {
+                size_t base                = stack.size() - in.a - 1;
+                const RuntimeValue &callee = stack[base];
+                if (!callee.is<std::shared_ptr<Callable>>() ||
+                    !dynamic_cast<LoxFunction *>(callee.as<std::shared_ptr<Callable>>().get())) {
+                    // Not a user function: call it normally; the following RETURN returns it
+                    callValue(frames, stack, base, in.a, *frame->chunk->tokens[in.b]);
+                    frame = &frames.back();
+                    break;
+                }
+                // Replace the running frame instead of pushing a new one
+                auto function = callee.as<std::shared_ptr<Callable>>();
+                interpreter.tick(static_cast<LoxFunction *>(function.get())->declaration->name);
+                interpreter.checkArgumentCount(*frame->chunk->tokens[in.b], *function, in.a);
+                std::unique_ptr<MemoKey> memoKey;
+                if (const RuntimeValue *cached =
+                        memoLookup(function, &stack[base + 1], in.a, memoKey)) {
+                    // The RETURN that follows hands the cached result back
+                    RuntimeValue result = *cached;
+                    stack.resize(base);
+                    stack.push_back(std::move(result));
+                    break;
+                }
+                // Both calls share one result, so the replaced frame's key is kept if it had one
+                if (frame->memoKey)
+                    memoKey = std::move(frame->memoKey);
+                // The caller's temporaries stay on the stack under the replacement too
+                HeapCharge temporaries = std::move(frame->temporaries);
+                size_t stackBase       = frame->stackBase;
+                *frame             = enterFunction(function, &stack[base + 1], in.a, stackBase);
+                frame->memoKey     = std::move(memoKey);
+                frame->temporaries = std::move(temporaries);
+                stack.resize(stackBase);
+                break;
+            }
+            case OP_INVOKE: {
+                size_t base         = stack.size() - in.a - 1;
+                const Token &name   = *frame->chunk->tokens[in.b];
+                RuntimeValue object = stack[base];
+                if (Interpreter::hasNativeMethods(object)) {
+                    // List, set and dictionary methods are dispatched directly on the receiver
+                    std::vector<RuntimeValue> args(
+                        std::make_move_iterator(stack.begin() + base + 1),
+                        std::make_move_iterator(stack.end()));
+                    RuntimeValue result = interpreter.callNativeMethod(object, name, args);
+                    stack.resize(base);
+                    stack.push_back(std::move(result));
+                    break;
+                }
+                stack[base] = interpreter.getProperty(object, name);
+                callValue(frames, stack, base, in.a, *frame->chunk->tokens[in.c]);
+                frame = &frames.back();
+                break;
+            }
+            case OP_NEW: {
+                size_t base = stack.size() - in.a - 1;
+                if (!stack[base].is<std::shared_ptr<Callable>>()) {
+                    throw RuntimeError(*frame->chunk->tokens[in.b],
+                                       "Can only instantiate classes.");
+                }
+                auto klass = stack[base].as<std::shared_ptr<Callable>>();
+                std::vector<RuntimeValue> args(std::make_move_iterator(stack.begin() + base + 1),
+                                               std::make_move_iterator(stack.end()));
+                RuntimeValue instance = klass->call(interpreter, std::move(args));
+                stack.resize(base);
+                stack.push_back(std::move(instance));
+                break;
+            }
+            case OP_PRINT:
+                interpreter.printValue(pop());
+                break;
+            case OP_RETURN: {
+                RuntimeValue result = pop();
+                if (frame->memoKey)
+                    interpreter.memo->store(std::move(*frame->memoKey), result);
+                stack.resize(frame->stackBase);
+                frames.pop_back();
+                if (frames.empty())
+                    return result;
+                interpreter.callDepth--;
+                stack.push_back(std::move(result));
+                frame = &frames.back();
+                break;
+            }
+            case OP_JUMP:
+                frame->ip = in.a;
+                break;
+            case OP_LOOP:
+                interpreter.tick(*frame->chunk->tokens[in.b]);
+                frame->ip = in.a;
+                break;
+            case OP_JUMP_IF_FALSE:
+                if (!interpreter.isTruthy(pop()))
+                    frame->ip = in.a;
+                break;
+            case OP_FOR_PREP: {
+                // Sets and dictionaries are walked through a snapshot of their keys
+                const Token &variable = *frame->chunk->tokens[in.a];
+                stack.back()          = {interpreter.iterationList(variable, stack.back())};
+                stack.push_back({0.0});
+                break;
+            }
+            case OP_FOR_NEXT: {
+                // Stack holds [list, position]; the list may grow while the body runs
+                double &position = stack.back().as<double>();
+                const Array &vec = *stack[stack.size() - 2].as<ArrayPtr>();
+                if (position >= (double) vec.size()) {
+                    frame->ip = in.a;
+                    break;
+                }
+                interpreter.tick(*frame->chunk->tokens[in.b]);
+                auto loopEnv = std::make_shared<Environment>(frame->env);
+                loopEnv->define(*frame->chunk->tokens[in.b], vec.get((size_t) position));
+                position += 1;
+                frame->env = loopEnv;
+                break;
+            }
+            case OP_PUSH_SCOPE:
+                frame->env = std::make_shared<Environment>(frame->env);
+                break;
+            case OP_POP_SCOPE:
+                frame->env = frame->env->getEnclosing();
+                break;
+            case OP_FUNCTION: {
+                FunctionStmt *declaration = frame->chunk->functions[in.a];
+                auto function = std::make_shared<LoxFunction>(declaration, frame->env);
+                frame->env->define(declaration->name.lexeme, {function});
+                break;
+            }
+            case OP_EXEC_STMT: {
+                std::shared_ptr<Environment> previous = interpreter.environment;
+                interpreter.environment               = frame->env;
+                try {
+                    interpreter.execute(frame->chunk->statements[in.a]);
+                } catch (...) {
+                    interpreter.environment = previous;
+                    throw;
+                }
+                interpreter.environment = previous;
+                break;
+            }
+            }
+        }
+    } catch (...) {
+        interpreter.callDepth = baseDepth;
+        throw;
+    }
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "bytecode.hpp"
+#include "compiler.hpp"
+#include "memo.hpp"
+#include "runtime.hpp"
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class Interpreter;
+class LoxFunction;
+
+/**
+ * VM - executes compiled chunks with an explicit operand stack and call stack
+ *
+ * Pseudocode calls push a Frame onto a heap-allocated vector instead of recursing in C++, so
+ * recursion depth is bounded by memory (and Interpreter::maxCallDepth) rather than by the
+ * native stack. Operator semantics are shared with the tree walker through the Interpreter.
+ */
+class VM {
+public:
+    VM(Interpreter &interpreter) : interpreter(interpreter) {
+    }
+
+    /**
+     * Compile and run top-level statements in the interpreter's current environment
+     * @param statements The parsed program; must outlive the VM
+     */
+    void run(const std::vector<StmtPtr> &statements);
+
+    /**
+     * Call a user function from native code (e.g. a SORT comparator)
+     * @return The function's return value
+     */
+    RuntimeValue call(LoxFunction &function, std::vector<RuntimeValue> &arguments);
+
+private:
+    struct Frame {
+        Chunk *chunk; // Mutable so that sites can be quickened
+        size_t ip;
+        std::shared_ptr<Environment> env;
+        size_t stackBase;                   // Stack height to restore on return
+        std::shared_ptr<Callable> function; // Keeps the running function alive
+        std::unique_ptr<MemoKey> memoKey;   // Set when the result is to be memoized on return
+        HeapCharge temporaries; // Strings the caller left on the stack under this call
+    };
+
+    Interpreter &interpreter;
+    Compiler compiler;
+
+    // Function bodies are compiled on their first call
+    std::unordered_map<FunctionStmt *, std::unique_ptr<Chunk>> functionChunks;
+
+    Chunk &chunkFor(FunctionStmt *function);
+
+    /**
+     * Build the frame for a user function, moving its arguments into a fresh scope
+     */
+    Frame enterFunction(const std::shared_ptr<Callable> &function, RuntimeValue *args,
+                        size_t argc, size_t stackBase);
+
+    /**
+     * Charge the strings held in stack[from, to) while a call made above them runs
+     * Recursion through an expression like 's + f(n - 1)' keeps a copy of 's' at every level.
+     * @throws RuntimeError at 'where' if they pass the memory limit
+     */
+    HeapCharge holdTemporaries(const std::vector<RuntimeValue> &stack, size_t from, size_t to,
+                               const Token &where) const;
+
+    /**
+     * With memoization enabled, look up a call of a user function in the cache
+     * @param key Set on a miss when the call's result should be stored
+     * @return The cached result, or nullptr
+     */
+    const RuntimeValue *memoLookup(const std::shared_ptr<Callable> &function,
+                                   const RuntimeValue *args, size_t argc,
+                                   std::unique_ptr<MemoKey> &key);
+
+    /**
+     * Run frames until the entry frame returns
+     */
+    RuntimeValue execute(Frame entry);
+
+    /**
+     * Call the value at stack[base] with the argc values above it
+     * User functions push a frame; anything else is called immediately and its result replaces
+     * the callee and arguments on the stack.
+     */
+    void callValue(std::vector<Frame> &frames, std::vector<RuntimeValue> &stack, size_t base,
+                   size_t argc, const Token &paren);
+};
@@ -0,0 +1,770 @@
+#include "ast_cache.hpp"
+#include "errors.hpp"
+#include "incremental.hpp"
+#include "scsa.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+
+/**
+ * regression_test - runs small programs on both engines and checks what they print
+ *
+ * Each case pins down behaviour that once went wrong. It runs on the tree walker and on the VM
+ * with the same options, and both must print the expected output. A case that expects an error
+ * passes when the run fails and its error report contains the given text. Damaged AST cache
+ * files, reused bindings, incremental re-parsing, error reports and deep recursion are checked
+ * separately.
+ */
+
+// ============================================================
+// Cases
+// ============================================================
+
+struct Case {
+    const char *name;
+    const char *source;
+    const char *output;     // Everything the program must print
+    const char *error;      // Text the error report must contain; null if the run must succeed
+    RunOptions options = {};
+};
+
+static RunOptions memoized() {
+    RunOptions options;
+    options.memoize = true;
+    return options;
+}
+
+static RunOptions memoryLimit(size_t bytes) {
+    RunOptions options;
+    options.limits.maxMemory = bytes;
+    return options;
+}
+
+static RunOptions stepLimit(uint64_t steps) {
+    RunOptions options;
+    options.limits.maxSteps = steps;
+    return options;
+}
+
+static RunOptions callDepthLimit(int depth) {
+    RunOptions options;
+    options.maxCallDepth = depth;
+    return options;
+}
+
+static const Case CASES[] = {
+    {"memoized call through a rebound global", R"(
+FUNCTION a(x)
+    RETURN 1
+END a
+FUNCTION b(x)
+    RETURN 2
+END b
+FUNCTION f(x)
+    RETURN g(x) + 0
+END f
+g = a
+PRINT(f(1))
+g = b
+PRINT(f(1))
+g = a
+PRINT(f(1))
+)",
+     "1\n2\n1\n", nullptr, memoized()},
+    {"memoized call through a redeclared function", R"(
+FUNCTION g(x)
+    RETURN x
+END g
+FUNCTION f(x)
+    RETURN g(x) * 10
+END f
+PRINT(f(1))
+FUNCTION g(x)
+    RETURN x + 1
+END g
+PRINT(f(1))
+)",
+     "10\n20\n", nullptr, memoized()},
+    {"strings passed down recursive calls count against the memory limit", R"(
+FUNCTION pass(s, n)
+    IF n == 0 THEN
+        RETURN LENGTH(s)
+    END IF
+    RETURN pass(s + "x", n - 1) + 0
+END pass
+s = "x"
+i = 0
+WHILE i < 16
+    s = s + s
+    i = i + 1
+END WHILE
+PRINT(LENGTH(s))
+PRINT(pass(s, 60))
+)",
+     "65536\n", "Memory limit of 1048576 bytes exceeded.", memoryLimit(1 << 20)},
+    {"replacing a string variable refunds its old text", R"(
+s = "x"
+i = 0
+WHILE i < 16
+    s = s + s
+    i = i + 1
+END WHILE
+i = 0
+WHILE i < 200
+    s = s + "y"
+    i = i + 1
+END WHILE
+PRINT(LENGTH(s))
+)",
+     "65736\n", nullptr, memoryLimit(1 << 20)},
+    {"a missing dictionary key is a located runtime error", R"(
+d = DICTIONARY()
+d["a"] = 1
+PRINT(d["a"])
+PRINT(d["b"])
+)",
+     "1\n", "[Runtime Error] Key b is not in the dictionary.\n[Line 5]"},
+    {"a fractional subscript is rejected", R"(
+x = [10, 20, 30]
+PRINT(x[1])
+PRINT(x[1.7])
+)",
+     "20\n", "List index must be a whole number."},
+    {"a fractional subscript is rejected on assignment", R"(
+x = [10, 20, 30]
+x[0.5] = 99
+PRINT(x)
+)",
+     "", "List index must be a whole number."},
+    {"a fractional subscript of a list known to the compiler is rejected", R"(
+x = [10, 20, 30]
+i = 0
+WHILE i < 2
+    PRINT(x[i])
+    i = i + 0.5
+END WHILE
+)",
+     "10\n", "List index must be a whole number."},
+    {"a NaN subscript is rejected", R"(
+big = 10
+i = 0
+WHILE i < 400
+    big = big * 10
+    i = i + 1
+END WHILE
+x = [10, 20, 30]
+PRINT(x[big - big])
+)",
+     "", "List index must be a whole number."},
+    {"a '+' site that first joins strings still adds numbers", R"(
+FUNCTION plus(a, b)
+    RETURN a + b
+END plus
+PRINT(plus("a", "b"))
+PRINT(plus(1, 2))
+PRINT(plus("c", "d"))
+PRINT(plus(4, 5))
+)",
+     "ab\n3\ncd\n9\n", nullptr},
+    {"a subscript site that first reads a list still reads a dictionary", R"(
+FUNCTION at(xs, i)
+    RETURN xs[i]
+END at
+d = DICTIONARY()
+d[1] = "one"
+PRINT(at([5, 6], 1))
+PRINT(at(d, 1))
+PRINT(at([7, 8], 0))
+PRINT(at(d, 2))
+)",
+     "6\none\n7\n", "Key 2 is not in the dictionary."},
+    // The last call to 'spin' runs as native code, and all 1121 steps fit the limit exactly
+    {"a division by zero in native code counts its steps once", R"(
+FUNCTION spin(n)
+    i = 0
+    WHILE i < n
+        i = i + 1
+    END WHILE
+    RETURN n / (i - n)
+END spin
+total = 0
+k = 0
+WHILE k < 60
+    total = total + spin(0 - 1)
+    k = k + 1
+END WHILE
+PRINT(total)
+PRINT(spin(1000))
+)",
+     "-60\n", "[Runtime Error] Division by zero.\n[Line 7]", stepLimit(1121)},
+    // The same steps with one fewer allowed: the limit is passed on the last loop iteration
+    {"a step limit is checked inside native loops on the step that passes it", R"(
+FUNCTION spin(n)
+    i = 0
+    WHILE i < n
+        i = i + 1
+    END WHILE
+    RETURN n / (i - n)
+END spin
+total = 0
+k = 0
+WHILE k < 60
+    total = total + spin(0 - 1)
+    k = k + 1
+END WHILE
+PRINT(total)
+PRINT(spin(1000))
+)",
+     "-60\n", "Step limit of 1120 exceeded; is there an infinite loop?\n[Line 4]",
+     stepLimit(1120)},
+    {"a list key changed after it is stored keeps its place", R"(
+dd = DICTIONARY()
+k = [1, 2]
+dd[k] = "list"
+k.append(3)
+PRINT([1, 2] IN dd)
+PRINT(k IN dd)
+dd[[1, 2, 3]] = "again"
+PRINT(dd)
+s = SET()
+s.add(k)
+k.append(4)
+PRINT([1, 2, 3] IN s)
+PRINT(s)
+)",
+     "true\nfalse\n{[1, 2]: list, [1, 2, 3]: again}\ntrue\n{[1, 2, 3]}\n", nullptr},
+    {"nested and object keys are hashed as they were stored", R"(
+CLASS Point
+METHODS
+    FUNCTION Point()
+        x = 0
+    END Point
+END Point
+p = NEW Point()
+n = [[1], p]
+d = DICTIONARY()
+d[n] = "nested"
+d[p] = "object"
+n[0].append(2)
+p.x = 5
+q = NEW Point()
+PRINT([[1], q] IN d)
+PRINT(q IN d)
+PRINT(n IN d)
+s = SET()
+s.add([[7]])
+FOR key IN s
+    inner = key[0]
+    inner.append(8)
+END FOR
+PRINT(s)
+)",
+     "true\ntrue\nfalse\n{[[7]]}\n", nullptr},
+    {"calls inside PARALLEL FOR count the calls around the loop", R"(
+FUNCTION down(n)
+    IF n == 0 THEN
+        RETURN 0
+    END IF
+    RETURN down(n - 1) + 1
+END down
+FUNCTION outer(n)
+    IF n > 1 THEN
+        RETURN outer(n - 1) + 0
+    END IF
+    PRINT(down(5))
+    PARALLEL FOR i IN [1, 2]
+        PRINT(down(15))
+    END FOR
+    RETURN 0
+END outer
+PRINT(outer(11))
+)",
+     "5\n", "Maximum recursion depth of 20 exceeded in 'down'.", callDepthLimit(20)},
+    {"list methods, length and slices", R"(
+xs = [3, 1, 4]
+xs.append(1)
+xs.insert(0, 9)
+PRINT(xs)
+PRINT(xs.pop())
+xs.remove(1)
+PRINT(xs)
+PRINT(xs.length)
+PRINT(xs[1:3])
+PRINT(xs[:10])
+PRINT(xs[2:])
+xs.insert(xs.length, 5)
+PRINT(xs)
+xs.remove(7)
+)",
+     "[9, 3, 1, 4, 1]\n1\n[9, 1, 4]\n3\n[1, 4]\n[9, 1, 4]\n[4]\n[9, 1, 4, 5]\n",
+     "[Runtime Error] List index out of bounds.\n[Line 15]"},
+    {"packed lists take values of another type", R"(
+xs = [1, 2, 3]
+flags = [TRUE, FALSE]
+xs.append("four")
+flags.append(2)
+xs[0] = FALSE
+PRINT(xs)
+PRINT(flags)
+ys = [1.5, 2.5]
+ys.insert(1, [7])
+PRINT(ys)
+PRINT(ys[1][0] + ys[2])
+)",
+     "[false, 2, 3, four]\n[true, false, 2]\n[1.5, [7], 2.5]\n9.5\n", nullptr},
+    // 19 numbers leave a remainder after every kernel's vector width
+    {"vectorized list builtins cover the elements past the last full vector", R"(
+xs = [1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19]
+PRINT(SUM(xs))
+PRINT(MIN(xs))
+PRINT(MAX(xs))
+PRINT(MEAN(xs))
+PRINT(DOT(xs, xs))
+PRINT(ADD_EACH(xs, 0.5)[18])
+PRINT(MULTIPLY_EACH(xs, 2)[17])
+PRINT(SUM([]))
+PRINT(DOT([1, 2], [3]))
+)",
+     "190\n1\n19\n10\n2470\n19.5\n36\n0\n",
+     "[Runtime Error] DOT expects two lists of the same length.\n[Line 11]"},
+    {"native sorts with and without a comparator", R"(
+FUNCTION byFirst(a, b)
+    RETURN a[0] < b[0]
+END byFirst
+FUNCTION desc(a, b)
+    RETURN a > b
+END desc
+pairs = [[2, "a"], [1, "b"], [2, "c"], [1, "d"], [0, "e"]]
+STABLE_SORT(pairs, byFirst)
+PRINT(pairs)
+xs = [5, 3, 9, 1, 7, 2, 8]
+SORT(xs)
+PRINT(xs)
+SORT(xs, desc)
+PRINT(xs)
+words = ["pear", "apple", "fig"]
+SORT(words)
+PRINT(words)
+)",
+     "[[0, e], [1, b], [1, d], [2, a], [2, c]]\n[1, 2, 3, 5, 7, 8, 9]\n[9, 8, 7, 5, 3, 2, 1]\n"
+     "[apple, fig, pear]\n",
+     nullptr},
+    {"math and string natives, and a native called with too few arguments", R"(
+PRINT(MOD(17, 5))
+PRINT(ABS(0 - 3))
+PRINT(POW(2, 10))
+PRINT(UPPER("abc"))
+PRINT(SUBSTRING("hello", 1, 3))
+PRINT(JOIN(SPLIT("a,b,c", ","), "-"))
+PRINT(NUMBER("42") + 1)
+PRINT(STRING(7) + "!")
+PRINT(SQRT())
+)",
+     "2\n3\n1024\nABC\nell\na-b-c\n43\n7!\n",
+     "[Runtime Error] Expected 1 arguments but got 0.\n[Line 10]"},
+    {"tail calls run past the depth limit that stops other recursion", R"(
+FUNCTION count(n, total)
+    IF n == 0 THEN
+        RETURN total
+    END IF
+    RETURN count(n - 1, total + 1)
+END count
+FUNCTION deep(n)
+    IF n == 0 THEN
+        RETURN 0
+    END IF
+    RETURN deep(n - 1) + 1
+END deep
+PRINT(count(5000, 0))
+PRINT(deep(40))
+PRINT(deep(60))
+)",
+     "5000\n40\n", "[Runtime Error] Maximum recursion depth of 50 exceeded in 'deep'.\n[Line 8]",
+     callDepthLimit(50)},
+    {"names that start like keywords, or are one letter longer, are identifiers", R"(
+IFF = 1
+ENDS = 2
+PRINTS = 3
+RETURNS = 4
+FUNCTIONS = 5
+PARALLELS = 6
+Print = 7
+ATTRIBUTE = 8
+PRINT(IFF + ENDS + PRINTS + RETURNS + FUNCTIONS + PARALLELS + Print + ATTRIBUTE)
+new_value = 9
+PRINT(new_value)
+PRINT(True)
+PRINT(False == FALSE)
+)",
+     "36\n9\ntrue\ntrue\n", nullptr},
+    // Every run is longer than a vector, so the scanners' tail handling is covered
+    {"long comments, identifiers, strings and whitespace runs", R"(
+# a comment running past thirty-two characters, so it spans vectors
+an_identifier_longer_than_thirty_two_characters = 'a single-quoted string longer than 32 bytes'
+PRINT(an_identifier_longer_than_thirty_two_characters)
+)" "\t\t  PRINT(LENGTH(\"x                                                y\"))   # trailing\n"
+     R"(
+PRINT(undefined_name_well_past_sixteen_chars)
+)",
+     "a single-quoted string longer than 32 bytes\n50\n",
+     "[Runtime Error] Undefined variable 'undefined_name_well_past_sixteen_chars'.\n[Line 7]"},
+    {"lists and objects compare by contents, cycles included", R"(
+CLASS Point
+METHODS
+    FUNCTION Point()
+        x = 0
+    END Point
+END Point
+p = NEW Point()
+q = NEW Point()
+p.x = [1, "a"]
+q.x = [1, "a"]
+PRINT(p == q)
+q.x = [1, "b"]
+PRINT(p == q)
+PRINT([1, [2, 3]] == [1, [2, 3]])
+PRINT([1, 2] == [1, 2, 3])
+a = [1]
+b = [1]
+a.append(a)
+b.append(b)
+PRINT(a == b)
+b.append(2)
+PRINT(a == b)
+d = DICTIONARY()
+d[[1, [2, 3]]] = "found"
+PRINT(d[[1, [2, 3]]])
+)",
+     "true\nfalse\ntrue\nfalse\ntrue\nfalse\nfound\n", nullptr},
+    // COPY is shallow: the lists inside are shared, but replacing one is not
+    {"copies share storage until either list changes", R"(
+xs = [1, 2, 3]
+ys = COPY(xs)
+zs = COPY(ys)
+ys.append(4)
+xs[0] = 9
+PRINT(xs)
+PRINT(ys)
+PRINT(zs)
+alias = xs
+alias.append(5)
+PRINT(xs)
+nested = [[1], [2]]
+copied = COPY(nested)
+inner = copied[0]
+inner.append(7)
+copied[1] = "two"
+PRINT(nested)
+PRINT(copied)
+)",
+     "[9, 2, 3]\n[1, 2, 3, 4]\n[1, 2, 3]\n[9, 2, 3, 5]\n[[1, 7], [2]]\n[[1, 7], two]\n", nullptr},
+    // Each variable's type changes where inference could wrongly assume it stays the same
+    {"variables that change type in a loop, a branch or a call", R"(
+x = 1
+y = 2
+i = 0
+WHILE i < 3
+    PRINT(x + y)
+    IF i == 1 THEN
+        x = "a"
+        y = "b"
+    END IF
+    i = i + 1
+END WHILE
+xs = [10, 20]
+PRINT(xs[1])
+IF i > 0 THEN
+    xs = DICTIONARY()
+    xs[1] = "one"
+END IF
+PRINT(xs[1])
+n = 5
+FUNCTION bump()
+    n = "changed"
+END bump
+bump()
+PRINT(n < 6)
+)",
+     "3\n3\nab\n20\none\n", "[Runtime Error] Operands must be numbers.\n[Line 25]"},
+};
+
+// ============================================================
+// Runs
+// ============================================================
+
+static bool passes(const Case &test, const RunResult &result) {
+    if (result.output != test.output)
+        return false;
+    if (!test.error)
+        return result.status == 0;
+    return result.status != 0 && result.errors.find(test.error) != std::string::npos;
+}
+
+// What running 'statements' prints, errors included
+static std::string runStatements(const std::vector<StmtPtr> &statements) {
+    std::ostringstream out;
+    Interpreter interpreter;
+    interpreter.output      = &out;
+    interpreter.errorOutput = &out;
+    interpreter.interpret(statements);
+    return out.str();
+}
+
+// ============================================================
+// AST Cache
+// ============================================================
+
+static const char *CACHE_PATH = "build/regression.scsac";
+
+static std::string readFile(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static void writeFile(const std::string &path, const std::string &contents) {
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << contents;
+}
+
+/**
+ * Save and reload 'source', optionally damaging the file in between
+ * @return Whether the cache loaded
+ */
+static bool reload(const std::string &source, void (*damage)(std::string &) = nullptr) {
+    auto program = Program::compile(source);
+    if (!AstCache::save(CACHE_PATH, source, program->statements()))
+        return false;
+    if (damage) {
+        std::string contents = readFile(CACHE_PATH);
+        damage(contents);
+        writeFile(CACHE_PATH, contents);
+    }
+    std::vector<StmtPtr> statements;
+    bool loaded = AstCache::load(CACHE_PATH, source, statements);
+    std::remove(CACHE_PATH);
+    return loaded;
+}
+
+// Caches whose header and source hash still match, so only the reader's checks can reject them
+static int checkAstCache() {
+    int failures = 0;
+    auto expect  = [&](bool ok, const char *name) {
+        if (!ok) {
+            failures++;
+            std::cerr << "FAILED: AST cache: " << name << std::endl;
+        }
+    };
+
+    expect(reload("FUNCTION f(x)\n    RETURN\nEND f\nPRINT([1, 2, 3][:2])\n"),
+           "a RETURN without a value and an open slice bound load");
+
+    // Every kind of statement, so a node the cache drops or misreads changes the output
+    std::string source = R"(
+FUNCTION twice(n)
+    RETURN n * 2
+END twice
+CLASS Counter
+METHODS
+    FUNCTION Counter()
+        count = 0
+    END Counter
+END Counter
+c = NEW Counter()
+c.count = 10
+FOR x IN [1, 2, 3]
+    IF x == 2 THEN
+        c.count = c.count + twice(x)
+        PRINT(c.count)
+    ELSE
+        PRINT(-x)
+    END IF
+END FOR
+i = 0
+WHILE i <= 2
+    i = i + 1
+END WHILE
+d = DICTIONARY()
+d["k"] = [i, "s", TRUE][0:2]
+PRINT(d)
+PRINT(c.count)
+)";
+    auto program = Program::compile(source);
+    std::vector<StmtPtr> statements;
+    bool loaded = AstCache::save(CACHE_PATH, source, program->statements()) &&
+                  AstCache::load(CACHE_PATH, source, statements);
+    std::remove(CACHE_PATH);
+    expect(loaded && runStatements(statements) == program->run().output,
+           "a loaded program prints what the parsed one does");
+
+    // 'PRINT(1)' ends in a literal tag and its token (type, string index, line, column and
+    // length); a null expression takes their place
+    expect(!reload("PRINT(1)\n",
+                   [](std::string &contents) {
+                       contents.resize(contents.size() - 18);
+                       contents.push_back('\0');
+                   }),
+           "a null PRINT expression is rejected");
+    return failures;
+}
+
+// ============================================================
+// Bindings
+// ============================================================
+
+// Runs sharing one bindings map must each start from the caller's values and leave them alone
+static int checkBindings() {
+    auto program =
+        Program::compile("xs.append(9)\nPRINT(xs.length)\nd[\"k\"] = xs\nPRINT(LENGTH(d))\n");
+    ArrayPtr list = Array::fromValues({{1.0}, {2.0}});
+    auto table    = std::make_shared<Dictionary>();
+    std::map<std::string, RuntimeValue> bindings{{"xs", {list}}, {"d", {table}}};
+
+    int failures = 0;
+    for (bool useVM : {false, true}) {
+        for (int run = 0; run < 2; ++run) {
+            RunOptions options;
+            options.useVM    = useVM;
+            RunResult result = program->run(bindings, options);
+            if (result.output == "3\n1\n")
+                continue;
+            failures++;
+            std::cerr << "FAILED: bindings: run " << run + 1 << " on "
+                      << (useVM ? "VM" : "tree walker") << " printed\n"
+                      << result.output << result.errors;
+        }
+    }
+    if (list->size() != 2 || table->size() != 0) {
+        failures++;
+        std::cerr << "FAILED: bindings: the caller's list or dictionary changed" << std::endl;
+    }
+    return failures;
+}
+
+// ============================================================
+// Incremental Parsing
+// ============================================================
+
+// Statements reused after an edit that adds a line must report errors where a full parse does
+static int checkIncremental() {
+    const char *lasts[] = {"PRINT(xs[7])", "PRINT(xs[0:\"a\"])", "PRINT(get(xs, 1) / 0)",
+                           "PRINT(missing(1))", "PRINT(xs.size)"};
+    int failures = 0;
+    for (const char *last : lasts) {
+        std::string source = "xs = [1, 2, 3]\nFUNCTION get(list, i)\n    RETURN list[i]\nEND get\n"
+                             "PRINT(get(xs, 0))\nPRINT(LENGTH(xs))\n" +
+                             std::string(last) + "\n";
+        IncrementalParser parser;
+        parser.update(source);
+        parser.update("z = 0\n" + source);
+
+        RunResult full = Program::compile(parser.source())->run();
+        std::string shifted = runStatements(parser.take());
+        if (shifted == full.output + full.errors)
+            continue;
+        failures++;
+        std::cerr << "FAILED: incremental parse ending in " << last << "\n--- full parse\n"
+                  << full.output << full.errors << "--- incremental\n"
+                  << shifted;
+    }
+    return failures;
+}
+
+// ============================================================
+// Error Reports
+// ============================================================
+
+// Lines are looked up from an index built by the first report, so later reports reuse it
+static int checkErrorReports() {
+    InterpreterStage stage = Parsing;
+    std::ostringstream out;
+    ErrorReporter reporter(stage, "report.scsa", "x = 1\ny = 22\nz = 333", out);
+    // Each report ends by throwing, for the lexer and parser to unwind on
+    for (size_t line : {3, 1}) {
+        try {
+            reporter.report(ErrorType::Syntax, line, line == 3 ? 4 : 0, "here", line);
+        } catch (const std::runtime_error &) {
+        }
+    }
+
+    // The last line has no newline, and the one before it is shown as context
+    std::string report = out.str();
+    const std::string expected[] = {
+        C_GRAY "2" C_RESET C_BLUE " │ " C_RESET C_GRAY "y = 22" C_RESET "\n",
+        C_BLUE "3 │ " C_RESET "z = " C_RED "333" C_RESET "\n",
+        C_BLUE "1 │ " C_RESET C_RED "x" C_RESET " = 1\n",
+    };
+    int failures = 0;
+    for (const std::string &line : expected) {
+        if (report.find(line) != std::string::npos)
+            continue;
+        failures++;
+        std::cerr << "FAILED: error report is missing the line\n" << line << report;
+    }
+    return failures;
+}
+
+// ============================================================
+// Deep Recursion
+// ============================================================
+
+// Whether compiling 'source' fails with a report containing 'message'
+static bool rejects(const std::string &source, const char *message) {
+    try {
+        Program::compile(source);
+    } catch (const CompileError &error) {
+        return std::string(error.what()).find(message) != std::string::npos;
+    }
+    return false;
+}
+
+// The VM's frames live on the heap, and the parser refuses what would recurse too deep
+static int checkDeepRecursion() {
+    int failures = 0;
+    auto expect  = [&](bool ok, const char *name) {
+        if (!ok) {
+            failures++;
+            std::cerr << "FAILED: deep recursion: " << name << std::endl;
+        }
+    };
+
+    auto program = Program::compile("FUNCTION deep(n)\n    IF n == 0 THEN\n        RETURN 0\n"
+                                    "    END IF\n    RETURN deep(n - 1) + 1\nEND deep\n"
+                                    "PRINT(deep(100000))\n");
+    RunOptions options;
+    options.useVM = true;
+    expect(program->run({}, options).output == "100000\n",
+           "the VM returns from 100000 nested calls");
+
+    expect(rejects("RETURN 1\n", "RETURN is only allowed inside a function."),
+           "a top-level RETURN is a syntax error");
+    expect(rejects("x = " + std::string(1500, '(') + "1" + std::string(1500, ')') + "\n",
+                   "Nesting is too deep (more than 1000 levels)."),
+           "1500 nested parentheses are a syntax error");
+    return failures;
+}
+
+int main() {
+    int runs = 0, failures = checkAstCache() + checkBindings() + checkIncremental() +
+                             checkErrorReports() + checkDeepRecursion();
+    for (const Case &test : CASES) {
+        auto program = Program::compile(test.source, "regression.scsa");
+        for (bool useVM : {false, true}) {
+            RunOptions options = test.options;
+            options.useVM      = useVM;
+            RunResult result   = program->run({}, options);
+            runs++;
+            if (passes(test, result))
+                continue;
+            failures++;
+            std::cerr << "FAILED: " << test.name << " on " << (useVM ? "VM" : "tree walker")
+                      << "\n--- expected\n"
+                      << test.output << (test.error ? test.error : "") << "\n--- got\n"
+                      << result.output << result.errors;
+        }
+    }
+
+    std::cout << runs << " runs, " << failures << " failed" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,212 @@
+#include "scsa.hpp"
+
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+/**
+ * stress_test - runs shared compiled programs from many threads at once
+ *
+ * 'make test' builds this and the library with -fsanitize=thread, so ThreadSanitizer reports
+ * any data race between interpreters running side by side: in the lexer and parser, the shared
+ * AST, the JIT's compiled functions, the thread pool behind PARALLEL FOR, or the native
+ * registry. Every concurrent run must also print exactly what the same run printed alone.
+ */
+
+// ============================================================
+// Programs
+// ============================================================
+
+struct Case {
+    const char *name;
+    const char *source;
+};
+
+static const Case CASES[] = {
+    {"recursion", R"(
+FUNCTION fib(k)
+    IF k < 2 THEN
+        RETURN k
+    END IF
+    RETURN fib(k - 1) + fib(k - 2)
+END fib
+
+FUNCTION countdown(k, acc)
+    IF k == 0 THEN
+        RETURN acc
+    END IF
+    RETURN countdown(k - 1, acc + k)
+END countdown
+
+PRINT(fib(n))
+PRINT(countdown(500, 0))
+)"},
+    {"collections", R"(
+numbers = []
+i = 0
+WHILE i < 200
+    numbers.append(MOD(i * 37, 101))
+    i = i + 1
+END WHILE
+SORT(numbers)
+PRINT(numbers[0:5])
+PRINT(SUM(numbers))
+PRINT(MAX(ADD_EACH(numbers, n)))
+words = SPLIT("the quick brown fox jumps over the lazy dog", " ")
+STABLE_SORT(words)
+PRINT(JOIN(words, ","))
+seen = SET(words)
+PRINT(LENGTH(seen))
+counts = DICTIONARY()
+FOR w IN words
+    IF w IN counts THEN
+        counts[w] = counts[w] + 1
+    ELSE
+        counts[w] = 1
+    END IF
+END FOR
+PRINT(counts["the"])
+copy = COPY(numbers)
+copy.append(n)
+PRINT(copy.length - numbers.length)
+)"},
+    {"objects", R"(
+CLASS Point
+METHODS
+    FUNCTION Point()
+        x = 0
+    END Point
+END Point
+
+p = NEW Point()
+p.x = n
+p.y = 4
+i = 0
+WHILE i < 100
+    p.x = p.x + i
+    i = i + 1
+END WHILE
+PRINT(p.x)
+q = NEW Point()
+q.x = p.x
+q.y = 4
+PRINT(p == q)
+)"},
+    {"parallel", R"(
+FUNCTION work(k)
+    total = 0
+    i = 0
+    WHILE i < k
+        total = total + i
+        i = i + 1
+    END WHILE
+    RETURN total
+END work
+
+PARALLEL FOR s IN [1, 2, 3, 4, 5, 6, 7, 8]
+    PRINT(STRING(s) + " " + STRING(work(s * n)))
+END FOR
+)"},
+    {"bindings", R"(
+xs.append(n)
+PRINT(xs.length)
+PRINT(SUM(xs))
+)"},
+    {"error", R"(
+PRINT(n)
+items = [1, 2, 3]
+PRINT(items[n])
+)"},
+};
+
+// ============================================================
+// Runs
+// ============================================================
+
+struct Config {
+    const char *name;
+    RunOptions options;
+};
+
+static std::vector<Config> configs() {
+    std::vector<Config> all(4);
+    all[0].name = "tree walker";
+
+    all[1].name           = "tree walker, no JIT";
+    all[1].options.useJit = false;
+
+    all[2].name          = "VM";
+    all[2].options.useVM = true;
+
+    all[3].name                    = "tree walker, memoized, step limit";
+    all[3].options.memoize         = true;
+    all[3].options.limits.maxSteps = 1000000;
+    return all;
+}
+
+static bool sameResult(const RunResult &a, const RunResult &b) {
+    return a.status == b.status && a.output == b.output && a.errors == b.errors;
+}
+
+static constexpr int THREADS = 8;
+static constexpr int ROUNDS  = 3;
+static constexpr double N    = 15; // Bound to 'n' in every program, along with the list 'xs'
+
+int main() {
+    const size_t caseCount     = sizeof(CASES) / sizeof(CASES[0]);
+    std::vector<Config> engine = configs();
+    std::map<std::string, RuntimeValue> bindings{{"n", {N}},
+                                                 {"xs", {Array::fromValues({{1.0}, {2.0}})}}};
+
+    // Reference results, each from a run with nothing else going on
+    std::vector<std::shared_ptr<const Program>> programs;
+    std::vector<std::vector<RunResult>> expected(caseCount);
+    for (size_t c = 0; c < caseCount; ++c) {
+        programs.push_back(Program::compile(CASES[c].source, CASES[c].name));
+        for (const Config &config : engine) {
+            expected[c].push_back(programs[c]->run(bindings, config.options));
+        }
+    }
+
+    std::mutex reportMutex;
+    std::atomic<int> runs{0};
+    std::atomic<int> failures{0};
+
+    auto check = [&](size_t c, size_t k, const RunResult &result, const char *what) {
+        runs.fetch_add(1, std::memory_order_relaxed);
+        if (sameResult(result, expected[c][k]))
+            return;
+        failures.fetch_add(1, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(reportMutex);
+        std::cerr << "MISMATCH: " << CASES[c].name << " on " << engine[k].name << " (" << what
+                  << ")\n--- expected\n"
+                  << expected[c][k].output << expected[c][k].errors << "--- got\n"
+                  << result.output << result.errors;
+    };
+
+    // Every thread runs every program each round, on an engine that shifts with the thread and
+    // round, so different programs and engines overlap. Each run is repeated on a private copy
+    // compiled just before it, so lexing and parsing overlap with the shared runs too.
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&, t] {
+            for (int round = 0; round < ROUNDS; ++round) {
+                for (size_t i = 0; i < caseCount; ++i) {
+                    size_t c   = (i + t) % caseCount;
+                    size_t k   = (i + t + round) % engine.size();
+                    auto local = Program::compile(CASES[c].source, CASES[c].name);
+                    check(c, k, programs[c]->run(bindings, engine[k].options), "shared");
+                    check(c, k, local->run(bindings, engine[k].options), "own copy");
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    std::cout << runs.load() << " runs on " << THREADS << " threads, " << failures.load()
+              << " mismatched" << std::endl;
+    return failures.load() == 0 ? 0 : 1;
+}